@@ -2,7 +2,7 @@
 
 ./make.sh
 
-for FLAGS in "" "-fdedup-movs" "-finc-decs" "-fpower-of-two" "-freuse-tmps" "-O"
+for FLAGS in "" "-fdedup-movs" "-finc-decs" "-fregalloc" "-fframe-params" "-ftail-calls" "-fpower-of-two" "-fmagic-div" "-freuse-tmps" "-fssa" "-fconst-prop" "-fdce" "-fgvn" "-flicm" "-fstrength-reduce" "-finline" "-fmerge-prints" "-funroll-loops" "-fvectorize" "-floop-idioms" "-O"
 do
     echo "     $FLAGS"
     src/etapa7 src/sample-md5.txt $FLAGS
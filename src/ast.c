@@ -61,11 +61,25 @@ void ast_binary_operator_render(
             fputs("!=", params.output);
             break;
         case AST_AND:
+        case AST_BIT_AND:
             fputs("&", params.output);
             break;
         case AST_OR:
+        case AST_BIT_OR:
             fputs("|", params.output);
             break;
+        case AST_BIT_XOR:
+            fputs("^", params.output);
+            break;
+        case AST_SHIFT_LEFT:
+            fputs("<<", params.output);
+            break;
+        case AST_SHIFT_RIGHT:
+            fputs(">>", params.output);
+            break;
+        case AST_ROTATE_LEFT:
+            fputs("<<<", params.output);
+            break;
     }
 }
 
@@ -88,6 +102,7 @@ void ast_unary_operator_render(
 {
     switch (unary_operator) {
         case AST_NOT:
+        case AST_BIT_NOT:
             fputs("~", params.output);
             break;
     }
@@ -403,6 +418,9 @@ void ast_statement_render(
         case AST_EXPRESSION_STATEMENT:
             ast_expression_render(statement.data.expression, params);
             break;
+        case AST_LOCAL_VAR_DECL:
+            ast_local_var_decl_render(*statement.data.local_var_decl, params);
+            break;
     }
 }
 
@@ -421,6 +439,9 @@ void datatype_render(
         case DATATYPE_CARA:
             fputs("cara", params.output);
             break;
+        case DATATYPE_NATU:
+            fputs("natu", params.output);
+            break;
     }
 }
 
@@ -521,6 +542,14 @@ void ast_declaration_render(
     }
 }
 
+void ast_local_var_decl_render(
+    struct ast_local_var_decl local_var_decl,
+    struct ast_fmt_params params
+)
+{
+    ast_declaration_render(local_var_decl.declaration, params);
+}
+
 void ast_declaration_list_render(
     struct ast_declaration_list declaration_list,
     struct ast_fmt_params params
@@ -598,6 +627,12 @@ void ast_declaration_free(struct ast_declaration declaration)
     }
 }
 
+void ast_local_var_decl_free(struct ast_local_var_decl *local_var_decl)
+{
+    ast_declaration_free(local_var_decl->declaration);
+    free(local_var_decl);
+}
+
 void ast_scalar_var_decl_free(struct ast_scalar_var_decl scalar_var_decl)
 {
     ast_expression_free(scalar_var_decl.init);
@@ -720,6 +755,9 @@ void ast_statement_free(struct ast_statement statement)
         case AST_EXPRESSION_STATEMENT:
             ast_expression_free(statement.data.expression);
             break;
+        case AST_LOCAL_VAR_DECL:
+            ast_local_var_decl_free(statement.data.local_var_decl);
+            break;
     }
 }
 
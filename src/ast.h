@@ -28,7 +28,8 @@ enum ast_statement_tag {
     AST_WRITE,
     AST_RETURN,
     AST_BODY,
-    AST_EXPRESSION_STATEMENT
+    AST_EXPRESSION_STATEMENT,
+    AST_LOCAL_VAR_DECL
 };
 
 enum ast_expression_tag {
@@ -55,11 +56,18 @@ enum ast_binary_operator {
     AST_EQUALS,
     AST_NOT_EQUAL,
     AST_AND,
-    AST_OR
+    AST_OR,
+    AST_BIT_AND,
+    AST_BIT_OR,
+    AST_BIT_XOR,
+    AST_SHIFT_LEFT,
+    AST_SHIFT_RIGHT,
+    AST_ROTATE_LEFT
 };
 
 enum ast_unary_operator {
-    AST_NOT
+    AST_NOT,
+    AST_BIT_NOT
 };
 
 enum ast_write_argument_tag {
@@ -210,6 +218,7 @@ struct ast_statement {
         struct ast_return return_;
         struct ast_body body;
         struct ast_expression expression;
+        struct ast_local_var_decl *local_var_decl;
     } data;
 };
 
@@ -257,6 +266,13 @@ struct ast_declaration {
     } data;
 };
 
+struct ast_local_var_decl {
+    /* either a scalar or a vector variable declaration */
+    struct ast_declaration declaration;
+    /* temporary holding the variable, set by semantic analysis */
+    struct symbol *variable;
+};
+
 /**
  * *********************
  * *********************
@@ -421,6 +437,11 @@ void ast_declaration_render(
     struct ast_fmt_params params
 );
 
+void ast_local_var_decl_render(
+    struct ast_local_var_decl local_var_decl,
+    struct ast_fmt_params params
+);
+
 void ast_declaration_list_render(
     struct ast_declaration_list declaration_list,
     struct ast_fmt_params params
@@ -456,6 +477,8 @@ void ast_declaration_list_free(struct ast_declaration_list declaration_list);
 
 void ast_declaration_free(struct ast_declaration declaration);
 
+void ast_local_var_decl_free(struct ast_local_var_decl *local_var_decl);
+
 void ast_scalar_var_decl_free(struct ast_scalar_var_decl scalar_var_decl);
 
 void ast_vector_var_decl_free(struct ast_vector_var_decl vector_var_decl);
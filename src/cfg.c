@@ -0,0 +1,616 @@
+#include <stdlib.h>
+#include "cfg.h"
+#include "alloc.h"
+#include "symboltable.h"
+#include "vector.h"
+#include "panic.h"
+
+struct dfs_frame {
+    size_t block;
+    size_t next_successor;
+};
+
+static int is_block_end(enum tac_opcode opcode);
+
+static void split_blocks(struct cfg *cfg);
+
+static void connect_blocks(struct cfg *cfg);
+
+static void add_edge(struct cfg *cfg, size_t from, size_t to);
+
+static void compute_reverse_postorder(struct cfg *cfg);
+
+static void compute_dominators(struct cfg *cfg);
+
+static size_t intersect_dominators(
+    struct cfg const *cfg,
+    size_t left,
+    size_t right
+);
+
+static void compute_dominance_frontiers(struct cfg *cfg);
+
+static void compute_loops(struct cfg *cfg);
+
+static void collect_loop_blocks(
+    struct cfg *cfg,
+    struct cfg_loop *loop,
+    size_t latch
+);
+
+static int loop_cmp_size(void const *left, void const *right);
+
+static size_t *push_unique(size_t *buf, size_t *length, size_t value);
+
+struct cfg cfg_build(struct tac_node *beginfun_node)
+{
+    struct cfg cfg;
+
+    if (beginfun_node->instruction.opcode != TAC_BEGINFUN) {
+        panic("CFG must be built from a .beginfun node");
+    }
+
+    cfg.beginfun_node = beginfun_node;
+    cfg.endfun_node = NULL;
+    cfg.blocks = vector_empty(&cfg.block_count);
+    cfg.reverse_postorder = vector_empty(&cfg.reverse_postorder_length);
+    cfg.loops = vector_empty(&cfg.loop_count);
+
+    split_blocks(&cfg);
+    connect_blocks(&cfg);
+    compute_reverse_postorder(&cfg);
+    compute_dominators(&cfg);
+    compute_dominance_frontiers(&cfg);
+    compute_loops(&cfg);
+
+    return cfg;
+}
+
+void cfg_free(struct cfg cfg)
+{
+    size_t i;
+
+    for (i = 0; i < cfg.block_count; i++) {
+        free(cfg.blocks[i].predecessors);
+        free(cfg.blocks[i].successors);
+        free(cfg.blocks[i].dominated);
+        free(cfg.blocks[i].dominance_frontier);
+    }
+    for (i = 0; i < cfg.loop_count; i++) {
+        free(cfg.loops[i].blocks);
+        free(cfg.loops[i].latches);
+    }
+    free(cfg.blocks);
+    free(cfg.reverse_postorder);
+    free(cfg.loops);
+}
+
+int cfg_dominates(struct cfg const *cfg, size_t dominator, size_t dominated)
+{
+    if (cfg->blocks[dominated].postorder_index == CFG_NO_BLOCK) {
+        return 0;
+    }
+
+    while (dominated != CFG_NO_BLOCK) {
+        if (dominated == dominator) {
+            return 1;
+        }
+        dominated = cfg->blocks[dominated].immediate_dominator;
+    }
+
+    return 0;
+}
+
+int cfg_loop_contains(struct cfg const *cfg, size_t loop, size_t block)
+{
+    size_t i;
+
+    for (i = 0; i < cfg->loops[loop].block_count; i++) {
+        if (cfg->loops[loop].blocks[i] == block) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+size_t cfg_find_label_block(struct cfg const *cfg, struct symbol *label)
+{
+    size_t i;
+
+    for (i = 0; i < cfg->block_count; i++) {
+        if (
+            cfg->blocks[i].first->instruction.opcode == TAC_LABEL
+            && cfg->blocks[i].first->instruction.srcs[0] == label
+        ) {
+            return i;
+        }
+    }
+
+    return CFG_NO_BLOCK;
+}
+
+void cfg_debug(struct cfg const *cfg, FILE *output)
+{
+    size_t i, j;
+    struct tac_node *node;
+    struct tac_render_params params;
+
+    params.space_count = 4;
+    params.output = output;
+
+    for (i = 0; i < cfg->block_count; i++) {
+        fprintf(output, "block %zu", i);
+        if (cfg->blocks[i].immediate_dominator != CFG_NO_BLOCK) {
+            fprintf(output, " idom %zu", cfg->blocks[i].immediate_dominator);
+        }
+        if (cfg->blocks[i].loop != CFG_NO_LOOP) {
+            fprintf(
+                output,
+                " loop %zu depth %zu",
+                cfg->blocks[i].loop,
+                cfg->blocks[i].loop_depth
+            );
+        }
+        fputs(" preds", output);
+        for (j = 0; j < cfg->blocks[i].predecessor_count; j++) {
+            fprintf(output, " %zu", cfg->blocks[i].predecessors[j]);
+        }
+        fputs(" succs", output);
+        for (j = 0; j < cfg->blocks[i].successor_count; j++) {
+            fprintf(output, " %zu", cfg->blocks[i].successors[j]);
+        }
+        fputs(" df", output);
+        for (j = 0; j < cfg->blocks[i].dominance_frontier_count; j++) {
+            fprintf(output, " %zu", cfg->blocks[i].dominance_frontier[j]);
+        }
+        fputc('\n', output);
+
+        node = cfg->blocks[i].first;
+        for (;;) {
+            tac_instruction_print(node->instruction, params);
+            if (node == cfg->blocks[i].last) {
+                break;
+            }
+            node = node->next;
+        }
+    }
+}
+
+static int is_block_end(enum tac_opcode opcode)
+{
+    switch (opcode) {
+        case TAC_IFZ:
+        case TAC_JUMP:
+        case TAC_RET:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static void split_blocks(struct cfg *cfg)
+{
+    int starts_block;
+    struct tac_node *node;
+    struct cfg_block block;
+
+    block.first = NULL;
+    block.last = NULL;
+    starts_block = 1;
+
+    for (
+        node = cfg->beginfun_node->next;
+        node != NULL && node->instruction.opcode != TAC_ENDFUN;
+        node = node->next
+    ) {
+        if (node->instruction.opcode == TAC_LABEL) {
+            starts_block = 1;
+        }
+
+        if (starts_block && block.first != NULL) {
+            cfg->blocks = vector_push(
+                cfg->blocks,
+                sizeof(*cfg->blocks),
+                &cfg->block_count,
+                &block
+            );
+        }
+
+        if (starts_block) {
+            block.first = node;
+            block.predecessors = vector_empty(&block.predecessor_count);
+            block.successors = vector_empty(&block.successor_count);
+            block.immediate_dominator = CFG_NO_BLOCK;
+            block.dominated = vector_empty(&block.dominated_count);
+            block.dominance_frontier =
+                vector_empty(&block.dominance_frontier_count);
+            block.postorder_index = CFG_NO_BLOCK;
+            block.loop = CFG_NO_LOOP;
+            block.loop_depth = 0;
+        }
+
+        block.last = node;
+        starts_block = is_block_end(node->instruction.opcode);
+    }
+
+    if (node == NULL) {
+        panic(
+            "function %s has no .endfun",
+            cfg->beginfun_node->instruction.dest->content
+        );
+    }
+    cfg->endfun_node = node;
+
+    if (block.first != NULL) {
+        cfg->blocks = vector_push(
+            cfg->blocks,
+            sizeof(*cfg->blocks),
+            &cfg->block_count,
+            &block
+        );
+    }
+}
+
+static void connect_blocks(struct cfg *cfg)
+{
+    size_t i, target;
+    struct tac_instruction last;
+
+    for (i = 0; i < cfg->block_count; i++) {
+        last = cfg->blocks[i].last->instruction;
+
+        if (last.opcode == TAC_JUMP || last.opcode == TAC_IFZ) {
+            target = cfg_find_label_block(cfg, last.dest);
+            if (target == CFG_NO_BLOCK) {
+                panic("jump target %s not found", last.dest->content);
+            }
+            add_edge(cfg, i, target);
+        }
+
+        if (
+            last.opcode != TAC_JUMP
+            && last.opcode != TAC_RET
+            && i + 1 < cfg->block_count
+        ) {
+            add_edge(cfg, i, i + 1);
+        }
+    }
+}
+
+static void add_edge(struct cfg *cfg, size_t from, size_t to)
+{
+    cfg->blocks[from].successors = push_unique(
+        cfg->blocks[from].successors,
+        &cfg->blocks[from].successor_count,
+        to
+    );
+    cfg->blocks[to].predecessors = push_unique(
+        cfg->blocks[to].predecessors,
+        &cfg->blocks[to].predecessor_count,
+        from
+    );
+}
+
+static void compute_reverse_postorder(struct cfg *cfg)
+{
+    size_t i, stack_length, successor;
+    int *visited;
+    struct dfs_frame frame;
+    struct dfs_frame *stack;
+
+    if (cfg->block_count == 0) {
+        return;
+    }
+
+    visited = aborting_malloc(sizeof(*visited) * cfg->block_count);
+    for (i = 0; i < cfg->block_count; i++) {
+        visited[i] = 0;
+    }
+
+    stack = vector_empty(&stack_length);
+    frame.block = 0;
+    frame.next_successor = 0;
+    visited[0] = 1;
+    stack = vector_push(stack, sizeof(*stack), &stack_length, &frame);
+
+    while (stack_length > 0) {
+        frame = stack[stack_length - 1];
+        if (frame.next_successor < cfg->blocks[frame.block].successor_count) {
+            stack[stack_length - 1].next_successor++;
+            successor =
+                cfg->blocks[frame.block].successors[frame.next_successor];
+            if (!visited[successor]) {
+                visited[successor] = 1;
+                frame.block = successor;
+                frame.next_successor = 0;
+                stack = vector_push(
+                    stack,
+                    sizeof(*stack),
+                    &stack_length,
+                    &frame
+                );
+            }
+        } else {
+            stack = vector_pop(stack, sizeof(*stack), &stack_length, &frame);
+            cfg->reverse_postorder = vector_push(
+                cfg->reverse_postorder,
+                sizeof(*cfg->reverse_postorder),
+                &cfg->reverse_postorder_length,
+                &frame.block
+            );
+        }
+    }
+
+    /* postorder was collected, reverse it */
+    for (i = 0; i < cfg->reverse_postorder_length / 2; i++) {
+        successor = cfg->reverse_postorder[i];
+        cfg->reverse_postorder[i] = cfg->reverse_postorder[
+            cfg->reverse_postorder_length - 1 - i
+        ];
+        cfg->reverse_postorder[cfg->reverse_postorder_length - 1 - i] =
+            successor;
+    }
+
+    for (i = 0; i < cfg->reverse_postorder_length; i++) {
+        cfg->blocks[cfg->reverse_postorder[i]].postorder_index = i;
+    }
+
+    free(stack);
+    free(visited);
+}
+
+/*
+ * Iterative dominator computation by Cooper, Harvey and Kennedy, over the
+ * reverse postorder. The entry block temporarily dominates itself so that
+ * intersections terminate.
+ */
+static void compute_dominators(struct cfg *cfg)
+{
+    size_t i, j, block, predecessor, new_idom;
+    int changed;
+
+    if (cfg->reverse_postorder_length == 0) {
+        return;
+    }
+
+    cfg->blocks[0].immediate_dominator = 0;
+
+    do {
+        changed = 0;
+        for (i = 1; i < cfg->reverse_postorder_length; i++) {
+            block = cfg->reverse_postorder[i];
+            new_idom = CFG_NO_BLOCK;
+            for (j = 0; j < cfg->blocks[block].predecessor_count; j++) {
+                predecessor = cfg->blocks[block].predecessors[j];
+                if (
+                    cfg->blocks[predecessor].immediate_dominator
+                    == CFG_NO_BLOCK
+                ) {
+                    continue;
+                }
+                if (new_idom == CFG_NO_BLOCK) {
+                    new_idom = predecessor;
+                } else {
+                    new_idom = intersect_dominators(
+                        cfg,
+                        predecessor,
+                        new_idom
+                    );
+                }
+            }
+            if (cfg->blocks[block].immediate_dominator != new_idom) {
+                cfg->blocks[block].immediate_dominator = new_idom;
+                changed = 1;
+            }
+        }
+    } while (changed);
+
+    cfg->blocks[0].immediate_dominator = CFG_NO_BLOCK;
+
+    for (i = 1; i < cfg->reverse_postorder_length; i++) {
+        block = cfg->reverse_postorder[i];
+        new_idom = cfg->blocks[block].immediate_dominator;
+        cfg->blocks[new_idom].dominated = vector_push(
+            cfg->blocks[new_idom].dominated,
+            sizeof(*cfg->blocks[new_idom].dominated),
+            &cfg->blocks[new_idom].dominated_count,
+            &block
+        );
+    }
+}
+
+static size_t intersect_dominators(
+    struct cfg const *cfg,
+    size_t left,
+    size_t right
+)
+{
+    while (left != right) {
+        while (
+            cfg->blocks[left].postorder_index
+            > cfg->blocks[right].postorder_index
+        ) {
+            left = cfg->blocks[left].immediate_dominator;
+        }
+        while (
+            cfg->blocks[right].postorder_index
+            > cfg->blocks[left].postorder_index
+        ) {
+            right = cfg->blocks[right].immediate_dominator;
+        }
+    }
+    return left;
+}
+
+static void compute_dominance_frontiers(struct cfg *cfg)
+{
+    size_t i, j, runner, predecessor;
+    struct cfg_block *block;
+
+    for (i = 0; i < cfg->block_count; i++) {
+        block = &cfg->blocks[i];
+        if (block->postorder_index == CFG_NO_BLOCK) {
+            continue;
+        }
+        if (block->predecessor_count < 2) {
+            continue;
+        }
+        for (j = 0; j < block->predecessor_count; j++) {
+            predecessor = block->predecessors[j];
+            if (cfg->blocks[predecessor].postorder_index == CFG_NO_BLOCK) {
+                continue;
+            }
+            runner = predecessor;
+            while (runner != block->immediate_dominator) {
+                cfg->blocks[runner].dominance_frontier = push_unique(
+                    cfg->blocks[runner].dominance_frontier,
+                    &cfg->blocks[runner].dominance_frontier_count,
+                    i
+                );
+                runner = cfg->blocks[runner].immediate_dominator;
+            }
+        }
+    }
+}
+
+static void compute_loops(struct cfg *cfg)
+{
+    size_t i, j, k, header;
+    struct cfg_loop loop;
+    struct cfg_loop *found;
+
+    for (i = 0; i < cfg->block_count; i++) {
+        for (j = 0; j < cfg->blocks[i].successor_count; j++) {
+            header = cfg->blocks[i].successors[j];
+            if (!cfg_dominates(cfg, header, i)) {
+                continue;
+            }
+
+            found = NULL;
+            for (k = 0; k < cfg->loop_count && found == NULL; k++) {
+                if (cfg->loops[k].header == header) {
+                    found = &cfg->loops[k];
+                }
+            }
+            if (found == NULL) {
+                loop.header = header;
+                loop.parent = CFG_NO_LOOP;
+                loop.depth = 0;
+                loop.blocks = vector_singleton(
+                    sizeof(*loop.blocks),
+                    &loop.block_count,
+                    &header
+                );
+                loop.latches = vector_empty(&loop.latch_count);
+                cfg->loops = vector_push(
+                    cfg->loops,
+                    sizeof(*cfg->loops),
+                    &cfg->loop_count,
+                    &loop
+                );
+                found = &cfg->loops[cfg->loop_count - 1];
+            }
+
+            found->latches = push_unique(
+                found->latches,
+                &found->latch_count,
+                i
+            );
+            collect_loop_blocks(cfg, found, i);
+        }
+    }
+
+    /* functions without loops have no loop vector to sort */
+    if (cfg->loop_count > 1) {
+        qsort(cfg->loops, cfg->loop_count, sizeof(*cfg->loops), loop_cmp_size);
+    }
+
+    for (i = 0; i < cfg->loop_count; i++) {
+        /* the innermost enclosing loop is the last one containing our header */
+        for (j = 0; j < i; j++) {
+            if (
+                cfg->loops[j].block_count > cfg->loops[i].block_count
+                && cfg_loop_contains(cfg, j, cfg->loops[i].header)
+            ) {
+                cfg->loops[i].parent = j;
+            }
+        }
+        if (cfg->loops[i].parent == CFG_NO_LOOP) {
+            cfg->loops[i].depth = 1;
+        } else {
+            cfg->loops[i].depth = cfg->loops[cfg->loops[i].parent].depth + 1;
+        }
+        for (j = 0; j < cfg->loops[i].block_count; j++) {
+            cfg->blocks[cfg->loops[i].blocks[j]].loop = i;
+            cfg->blocks[cfg->loops[i].blocks[j]].loop_depth =
+                cfg->loops[i].depth;
+        }
+    }
+}
+
+static void collect_loop_blocks(
+    struct cfg *cfg,
+    struct cfg_loop *loop,
+    size_t latch
+)
+{
+    size_t i, block, worklist_length, old_length;
+    size_t *worklist;
+
+    worklist = vector_singleton(sizeof(*worklist), &worklist_length, &latch);
+
+    while (worklist_length > 0) {
+        worklist = vector_pop(
+            worklist,
+            sizeof(*worklist),
+            &worklist_length,
+            &block
+        );
+        if (cfg->blocks[block].postorder_index == CFG_NO_BLOCK) {
+            continue;
+        }
+        old_length = loop->block_count;
+        loop->blocks = push_unique(loop->blocks, &loop->block_count, block);
+        if (old_length == loop->block_count) {
+            continue;
+        }
+        for (i = 0; i < cfg->blocks[block].predecessor_count; i++) {
+            worklist = vector_push(
+                worklist,
+                sizeof(*worklist),
+                &worklist_length,
+                &cfg->blocks[block].predecessors[i]
+            );
+        }
+    }
+
+    free(worklist);
+}
+
+static int loop_cmp_size(void const *left, void const *right)
+{
+    struct cfg_loop const *left_loop = left;
+    struct cfg_loop const *right_loop = right;
+
+    if (left_loop->block_count > right_loop->block_count) {
+        return -1;
+    }
+    if (left_loop->block_count < right_loop->block_count) {
+        return 1;
+    }
+    return 0;
+}
+
+static size_t *push_unique(size_t *buf, size_t *length, size_t value)
+{
+    size_t i;
+
+    for (i = 0; i < *length; i++) {
+        if (buf[i] == value) {
+            return buf;
+        }
+    }
+
+    return vector_push(buf, sizeof(*buf), length, &value);
+}
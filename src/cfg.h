@@ -0,0 +1,96 @@
+#ifndef CFG_H_
+#define CFG_H_ 1
+
+#include <stdio.h>
+#include "tac.h"
+
+#define CFG_NO_BLOCK ((size_t) -1)
+
+#define CFG_NO_LOOP ((size_t) -1)
+
+/**
+ * A maximal straight-line run of TAC nodes of a function. A block starts at a
+ * label, at the first node of the function or right after a jump, a
+ * conditional jump or a return, and it spans from first to last, inclusive.
+ */
+struct cfg_block {
+    struct tac_node *first;
+    struct tac_node *last;
+    size_t predecessor_count;
+    size_t *predecessors;
+    size_t successor_count;
+    size_t *successors;
+    /* CFG_NO_BLOCK for the entry block and for unreachable blocks */
+    size_t immediate_dominator;
+    size_t dominated_count;
+    size_t *dominated;
+    size_t dominance_frontier_count;
+    size_t *dominance_frontier;
+    /* position in reverse postorder, CFG_NO_BLOCK if unreachable */
+    size_t postorder_index;
+    /* innermost loop containing this block, or CFG_NO_LOOP */
+    size_t loop;
+    size_t loop_depth;
+};
+
+/**
+ * A natural loop, made of every block that reaches one of the latches
+ * without passing through the header. Loops sharing a header are merged.
+ */
+struct cfg_loop {
+    size_t header;
+    /* enclosing loop, or CFG_NO_LOOP for outermost loops */
+    size_t parent;
+    size_t depth;
+    size_t block_count;
+    size_t *blocks;
+    size_t latch_count;
+    size_t *latches;
+};
+
+/**
+ * Control-flow graph of a single function. Block 0 is the entry block. The
+ * graph refers to the TAC nodes directly, so it must be rebuilt whenever a
+ * pass adds or removes labels, jumps or returns.
+ */
+struct cfg {
+    struct tac_node *beginfun_node;
+    struct tac_node *endfun_node;
+    size_t block_count;
+    struct cfg_block *blocks;
+    /* reachable blocks in reverse postorder */
+    size_t reverse_postorder_length;
+    size_t *reverse_postorder;
+    /* loops, outer loops always come before the loops they enclose */
+    size_t loop_count;
+    struct cfg_loop *loops;
+};
+
+/**
+ * Builds the CFG of the function starting at the given .beginfun node, along
+ * with its dominator tree, dominance frontiers and loop nesting.
+ */
+struct cfg cfg_build(struct tac_node *beginfun_node);
+
+void cfg_free(struct cfg cfg);
+
+/**
+ * Tells whether the block dominator dominates the block dominated. Every
+ * reachable block dominates itself.
+ */
+int cfg_dominates(struct cfg const *cfg, size_t dominator, size_t dominated);
+
+/**
+ * Tells whether the given block belongs to the given loop, directly or
+ * through a nested loop.
+ */
+int cfg_loop_contains(struct cfg const *cfg, size_t loop, size_t block);
+
+/**
+ * Finds the block whose first node is the given label, CFG_NO_BLOCK if none.
+ */
+size_t cfg_find_label_block(struct cfg const *cfg, struct symbol *label);
+
+void cfg_debug(struct cfg const *cfg, FILE *output);
+
+#endif
@@ -39,6 +39,34 @@ int const_eval_int_expression(struct ast_expression expression, long *output)
                     case AST_DIV:
                         *output = left_operand / right_operand;
                         return 1;
+                    case AST_AND:
+                    case AST_BIT_AND:
+                        *output = left_operand & right_operand;
+                        return 1;
+                    case AST_OR:
+                    case AST_BIT_OR:
+                        *output = left_operand | right_operand;
+                        return 1;
+                    case AST_BIT_XOR:
+                        *output = left_operand ^ right_operand;
+                        return 1;
+                    case AST_SHIFT_LEFT:
+                        *output = (unsigned long) left_operand
+                            << (right_operand & 63);
+                        return 1;
+                    case AST_SHIFT_RIGHT:
+                        *output = left_operand >> (right_operand & 63);
+                        return 1;
+                    case AST_ROTATE_LEFT:
+                        right_operand &= 63;
+                        *output = right_operand == 0
+                            ? left_operand
+                            : (long) (
+                                (unsigned long) left_operand << right_operand
+                                | (unsigned long) left_operand
+                                    >> (64 - right_operand)
+                            );
+                        return 1;
                     default:
                         return 0;
                 }
@@ -52,6 +80,10 @@ int const_eval_int_expression(struct ast_expression expression, long *output)
                 )
             ) {
                 switch (expression.data.unary_operation.operator) {
+                    case AST_NOT:
+                    case AST_BIT_NOT:
+                        *output = ~operand;
+                        return 1;
                     default: return 0;
                 }
             }
@@ -0,0 +1,427 @@
+#include <stdlib.h>
+#include "idioms.h"
+#include "symboltable.h"
+
+/*
+ * The shape generated for a while statement, with the counter stepped by one
+ * right before the back edge:
+ *
+ *   head:  compare t, counter, bound
+ *          ifz exit, t
+ *          ...body...
+ *          add counter, counter, 1
+ *          jump head
+ *   exit:
+ */
+struct idiom_loop {
+    struct tac_node *head;
+    struct tac_node *compare;
+    struct tac_node *exit_branch;
+    struct tac_node *step;
+    struct tac_node *back_jump;
+    struct symbol *counter;
+    struct symbol *bound;
+    /* the comparison with the counter as its left operand */
+    enum tac_opcode comparison;
+};
+
+static int match_loop(
+    struct tac_node *function_start,
+    struct tac_node *back_jump,
+    struct idiom_loop *loop
+);
+
+static int match_comparison(struct idiom_loop *loop);
+
+static int match_fill(
+    struct idiom_loop const *loop,
+    struct symbol **vector,
+    struct symbol **value
+);
+
+static int match_copy(
+    struct tac_node *function_start,
+    struct idiom_loop const *loop,
+    struct symbol **dest_vector,
+    struct symbol **src_vector
+);
+
+static int is_int_var(struct symbol *symbol);
+
+static int is_vector_var(struct symbol *symbol);
+
+static size_t count_references(
+    struct tac_node *function_start,
+    struct symbol *symbol
+);
+
+static void replace_loop(
+    struct tac *tac,
+    struct idiom_loop const *loop,
+    enum tac_opcode opcode,
+    struct symbol *vector,
+    struct symbol *operand
+);
+
+static void insert_instruction(
+    struct tac *tac,
+    struct tac_node *before,
+    enum tac_opcode opcode,
+    struct symbol *dest,
+    struct symbol *left,
+    struct symbol *right
+);
+
+void replace_loop_idioms(struct tac *tac)
+{
+    struct idiom_loop loop;
+    struct symbol *vector, *operand;
+    struct tac_node *node, *next, *function_start;
+
+    function_start = NULL;
+    for (node = tac->first; node != NULL; node = next) {
+        next = node->next;
+        if (node->instruction.opcode == TAC_BEGINFUN) {
+            function_start = node;
+        } else if (
+            node->instruction.opcode == TAC_JUMP
+            && function_start != NULL
+            && match_loop(function_start, node, &loop)
+        ) {
+            if (match_fill(&loop, &vector, &operand)) {
+                replace_loop(tac, &loop, TAC_FILL, vector, operand);
+            } else if (
+                match_copy(function_start, &loop, &vector, &operand)
+            ) {
+                replace_loop(tac, &loop, TAC_COPY, vector, operand);
+            }
+        }
+    }
+}
+
+static int match_loop(
+    struct tac_node *function_start,
+    struct tac_node *back_jump,
+    struct idiom_loop *loop
+)
+{
+    struct tac_instruction step;
+
+    loop->back_jump = back_jump;
+    loop->head = back_jump->prev;
+    while (
+        loop->head != function_start
+        && (
+            loop->head->instruction.opcode != TAC_LABEL
+            || loop->head->instruction.srcs[0] != back_jump->instruction.dest
+        )
+    ) {
+        loop->head = loop->head->prev;
+    }
+    if (loop->head == function_start) {
+        return 0;
+    }
+
+    loop->compare = loop->head->next;
+    loop->exit_branch = loop->compare->next;
+    loop->step = back_jump->prev;
+    if (
+        loop->compare == back_jump
+        || loop->exit_branch == back_jump
+        || loop->step == loop->exit_branch
+        || loop->exit_branch->instruction.opcode != TAC_IFZ
+        || loop->compare->instruction.dest == NULL
+        || loop->compare->instruction.dest->type != SYM_TMP_VAR
+        || loop->exit_branch->instruction.srcs[0]
+            != loop->compare->instruction.dest
+        || back_jump->next == NULL
+        || back_jump->next->instruction.opcode != TAC_LABEL
+        || back_jump->next->instruction.srcs[0]
+            != loop->exit_branch->instruction.dest
+    ) {
+        return 0;
+    }
+
+    step = loop->step->instruction;
+    loop->counter = step.dest;
+    if (
+        step.opcode != TAC_ADD
+        || !is_int_var(loop->counter)
+        || step.srcs[0] != loop->counter
+        || step.srcs[1]->type != SYM_LIT_INT
+        || step.srcs[1]->data.parsed_int != 1
+        || !match_comparison(loop)
+    ) {
+        return 0;
+    }
+
+    /* the loop must be entered from above and the test used only to exit */
+    return count_references(
+            function_start,
+            loop->head->instruction.srcs[0]
+        ) == 2
+        && count_references(
+            function_start,
+            loop->compare->instruction.dest
+        ) == 2;
+}
+
+static int match_comparison(struct idiom_loop *loop)
+{
+    struct tac_instruction compare;
+
+    compare = loop->compare->instruction;
+    if (
+        compare.srcs[0] == loop->counter
+        && compare.srcs[1] != loop->counter
+    ) {
+        loop->bound = compare.srcs[1];
+        loop->comparison = compare.opcode;
+    } else if (
+        compare.srcs[1] == loop->counter
+        && compare.srcs[0] != loop->counter
+    ) {
+        loop->bound = compare.srcs[0];
+        switch (compare.opcode) {
+            case TAC_GT:
+                loop->comparison = TAC_LT;
+                break;
+            case TAC_GE:
+                loop->comparison = TAC_LE;
+                break;
+            default:
+                return 0;
+        }
+    } else {
+        return 0;
+    }
+
+    return (loop->comparison == TAC_LT || loop->comparison == TAC_LE)
+        && (loop->bound->type == SYM_LIT_INT || is_int_var(loop->bound));
+}
+
+/* the body is a single store of a value the loop does not change */
+static int match_fill(
+    struct idiom_loop const *loop,
+    struct symbol **vector,
+    struct symbol **value
+)
+{
+    int is_real;
+    struct tac_instruction store;
+
+    if (loop->exit_branch->next->next != loop->step) {
+        return 0;
+    }
+    store = loop->exit_branch->next->instruction;
+    if (
+        store.opcode != TAC_MOVV
+        || store.srcs[0] != loop->counter
+        || !is_vector_var(store.dest)
+    ) {
+        return 0;
+    }
+
+    is_real = store.dest->data.variable.type == DATATYPE_REAL;
+    switch (store.srcs[1]->type) {
+        case SYM_LIT_INT:
+        case SYM_LIT_CHAR:
+            if (is_real) {
+                return 0;
+            }
+            break;
+        case SYM_LIT_FLOAT:
+            if (!is_real) {
+                return 0;
+            }
+            break;
+        case SYM_TMP_VAR:
+        case SYM_SCALAR_VAR:
+            if (
+                store.srcs[1] == loop->counter
+                || is_real
+                    != (store.srcs[1]->data.variable.type == DATATYPE_REAL)
+            ) {
+                return 0;
+            }
+            break;
+        default:
+            return 0;
+    }
+
+    *vector = store.dest;
+    *value = store.srcs[1];
+    return 1;
+}
+
+/* the body loads an element and stores it at the same index elsewhere */
+static int match_copy(
+    struct tac_node *function_start,
+    struct idiom_loop const *loop,
+    struct symbol **dest_vector,
+    struct symbol **src_vector
+)
+{
+    struct tac_instruction load, store;
+    struct tac_node *load_node;
+
+    load_node = loop->exit_branch->next;
+    if (
+        load_node->next == loop->step
+        || load_node->next->next != loop->step
+    ) {
+        return 0;
+    }
+    load = load_node->instruction;
+    store = load_node->next->instruction;
+    if (
+        load.opcode != TAC_MOVI
+        || store.opcode != TAC_MOVV
+        || load.srcs[1] != loop->counter
+        || store.srcs[0] != loop->counter
+        || store.srcs[1] != load.dest
+        || load.dest->type != SYM_TMP_VAR
+        || !is_vector_var(load.srcs[0])
+        || !is_vector_var(store.dest)
+    ) {
+        return 0;
+    }
+
+    /* no conversion may happen between the elements */
+    if (
+        load.srcs[0]->data.variable.type != store.dest->data.variable.type
+        || load.dest->data.variable.type != store.dest->data.variable.type
+        || count_references(function_start, load.dest) != 2
+    ) {
+        return 0;
+    }
+
+    *dest_vector = store.dest;
+    *src_vector = load.srcs[0];
+    return 1;
+}
+
+static int is_int_var(struct symbol *symbol)
+{
+    return symbol != NULL
+        && (symbol->type == SYM_TMP_VAR || symbol->type == SYM_SCALAR_VAR)
+        && symbol->data.variable.type == DATATYPE_INTE;
+}
+
+static int is_vector_var(struct symbol *symbol)
+{
+    return symbol->type == SYM_VECTOR_VAR
+        || symbol->type == SYM_TMP_VECTOR_VAR;
+}
+
+static size_t count_references(
+    struct tac_node *function_start,
+    struct symbol *symbol
+)
+{
+    size_t count;
+    struct tac_node *node;
+
+    count = 0;
+    for (
+        node = function_start;
+        node->instruction.opcode != TAC_ENDFUN;
+        node = node->next
+    ) {
+        count += node->instruction.dest == symbol;
+        count += node->instruction.srcs[0] == symbol;
+        count += node->instruction.srcs[1] == symbol;
+    }
+    return count;
+}
+
+/*
+ * Keeps the test guarding the first iteration, so that the element count is
+ * never negative, and leaves the counter as the last step would.
+ */
+static void replace_loop(
+    struct tac *tac,
+    struct idiom_loop const *loop,
+    enum tac_opcode opcode,
+    struct symbol *vector,
+    struct symbol *operand
+)
+{
+    struct tac_node *node, *next, *exit;
+    struct symbol *count;
+
+    exit = loop->back_jump->next;
+    for (node = loop->exit_branch->next; node != exit; node = next) {
+        next = node->next;
+        tac_remove(tac, node);
+    }
+    tac_remove(tac, loop->head);
+
+    count = symbol_table_create_tmp_scalar_var(DATATYPE_INTE);
+    insert_instruction(
+        tac,
+        exit,
+        TAC_SUB,
+        count,
+        loop->bound,
+        loop->counter
+    );
+    if (loop->comparison == TAC_LE) {
+        insert_instruction(
+            tac,
+            exit,
+            TAC_ADD,
+            count,
+            count,
+            symbol_table_create_int_lit(1)
+        );
+    }
+    insert_instruction(tac, exit, TAC_REP, NULL, count, NULL);
+    if (opcode == TAC_FILL) {
+        insert_instruction(
+            tac,
+            exit,
+            TAC_FILL,
+            vector,
+            loop->counter,
+            operand
+        );
+    } else {
+        insert_instruction(
+            tac,
+            exit,
+            TAC_COPY,
+            vector,
+            operand,
+            loop->counter
+        );
+    }
+    insert_instruction(
+        tac,
+        exit,
+        TAC_ADD,
+        loop->counter,
+        loop->counter,
+        count
+    );
+}
+
+static void insert_instruction(
+    struct tac *tac,
+    struct tac_node *before,
+    enum tac_opcode opcode,
+    struct symbol *dest,
+    struct symbol *left,
+    struct symbol *right
+)
+{
+    struct tac_instruction instruction;
+
+    instruction.opcode = opcode;
+    instruction.dest = dest;
+    instruction.srcs[0] = left;
+    instruction.srcs[1] = right;
+    instruction.phi_arg_count = 0;
+    instruction.phi_args = NULL;
+    tac_insert_before(tac, before, instruction);
+}
@@ -0,0 +1,14 @@
+#ifndef IDIOMS_H_
+#define IDIOMS_H_ 1
+
+#include "tac.h"
+
+/**
+ * Replaces the counted loops produced by the while statement whose body only
+ * fills vector elements at the counter with the same value, or only copies
+ * them from the same elements of another vector, by a single fill or copy of
+ * every element the loop would visit.
+ */
+void replace_loop_idioms(struct tac *tac);
+
+#endif
@@ -0,0 +1,406 @@
+#include <stdlib.h>
+#include "inliner.h"
+#include "alloc.h"
+#include "symboltable.h"
+#include "vector.h"
+
+struct inliner_function {
+    struct symbol *symbol;
+    struct tac_node *beginfun_node;
+    struct tac_node *endfun_node;
+    size_t param_count;
+    struct symbol **params;
+    size_t size;
+    int has_calls;
+};
+
+struct inliner_rename {
+    struct symbol *from;
+    struct symbol *to;
+};
+
+static struct inliner_function *collect_functions(
+    struct tac *tac,
+    size_t *function_count
+);
+
+static void free_functions(
+    struct inliner_function *functions,
+    size_t function_count
+);
+
+static struct inliner_function const *find_function(
+    struct inliner_function const *functions,
+    size_t function_count,
+    struct symbol *symbol
+);
+
+static int can_inline(
+    struct inliner_function const *callee,
+    struct tac_node *call_node,
+    size_t size_limit
+);
+
+static void inline_call(
+    struct tac *tac,
+    struct inliner_function const *callee,
+    struct tac_node *call_node
+);
+
+static struct symbol *rename_symbol(
+    struct inliner_rename **renames,
+    size_t *rename_count,
+    struct symbol *symbol
+);
+
+static int symbol_datatype(struct symbol *symbol, enum datatype *datatype);
+
+void inline_calls(struct tac *tac, size_t size_limit)
+{
+    size_t i, function_count;
+    int changed;
+    struct inliner_function *functions;
+    struct inliner_function const *callee;
+    struct tac_node *node, *next;
+
+    do {
+        changed = 0;
+        functions = collect_functions(tac, &function_count);
+
+        for (i = 0; i < function_count; i++) {
+            if (!functions[i].has_calls) {
+                continue;
+            }
+            node = functions[i].beginfun_node;
+            while (node != functions[i].endfun_node) {
+                next = node->next;
+                if (node->instruction.opcode == TAC_CALL) {
+                    callee = find_function(
+                        functions,
+                        function_count,
+                        node->instruction.srcs[0]
+                    );
+                    if (
+                        callee != NULL
+                        && callee != &functions[i]
+                        && can_inline(callee, node, size_limit)
+                    ) {
+                        inline_call(tac, callee, node);
+                        changed = 1;
+                    }
+                }
+                node = next;
+            }
+        }
+
+        free_functions(functions, function_count);
+    } while (changed);
+}
+
+static struct inliner_function *collect_functions(
+    struct tac *tac,
+    size_t *function_count
+)
+{
+    struct inliner_function *functions;
+    struct inliner_function function;
+    struct tac_node *node;
+
+    functions = vector_empty(function_count);
+
+    node = tac_find_function_start(tac->first);
+    while (node != NULL) {
+        function.symbol = node->instruction.dest;
+        function.beginfun_node = node;
+        function.params = vector_empty(&function.param_count);
+        function.size = 0;
+        function.has_calls = 0;
+
+        for (
+            node = node->next;
+            node->instruction.opcode != TAC_ENDFUN;
+            node = node->next
+        ) {
+            switch (node->instruction.opcode) {
+                case TAC_DEFP:
+                    function.params = vector_push(
+                        function.params,
+                        sizeof(*function.params),
+                        &function.param_count,
+                        &node->instruction.dest
+                    );
+                    break;
+                case TAC_LABEL:
+                    break;
+                case TAC_CALL:
+                    function.has_calls = 1;
+                    function.size++;
+                    break;
+                default:
+                    function.size++;
+                    break;
+            }
+        }
+
+        function.endfun_node = node;
+        functions = vector_push(
+            functions,
+            sizeof(*functions),
+            function_count,
+            &function
+        );
+        node = tac_find_function_start(node);
+    }
+
+    return functions;
+}
+
+static void free_functions(
+    struct inliner_function *functions,
+    size_t function_count
+)
+{
+    size_t i;
+
+    for (i = 0; i < function_count; i++) {
+        free(functions[i].params);
+    }
+    free(functions);
+}
+
+static struct inliner_function const *find_function(
+    struct inliner_function const *functions,
+    size_t function_count,
+    struct symbol *symbol
+)
+{
+    size_t i;
+
+    for (i = 0; i < function_count; i++) {
+        if (functions[i].symbol == symbol) {
+            return &functions[i];
+        }
+    }
+    return NULL;
+}
+
+/*
+ * The arguments are passed right before the call. A call converts neither the
+ * arguments nor the result, so every value must already have the type of its
+ * destination to become a plain copy.
+ */
+static int can_inline(
+    struct inliner_function const *callee,
+    struct tac_node *call_node,
+    size_t size_limit
+)
+{
+    size_t i;
+    enum datatype expected, actual;
+    struct tac_node *node;
+
+    if (callee->has_calls || callee->size > size_limit) {
+        return 0;
+    }
+
+    node = call_node;
+    for (i = callee->param_count; i > 0; i--) {
+        node = node->prev;
+        if (
+            node->instruction.opcode != TAC_ARG
+            || !symbol_datatype(callee->params[i - 1], &expected)
+            || !symbol_datatype(node->instruction.srcs[0], &actual)
+            || expected != actual
+        ) {
+            return 0;
+        }
+    }
+
+    if (call_node->instruction.dest == NULL) {
+        return 1;
+    }
+    if (!symbol_datatype(call_node->instruction.dest, &expected)) {
+        return 0;
+    }
+    for (
+        node = callee->beginfun_node;
+        node != callee->endfun_node;
+        node = node->next
+    ) {
+        if (
+            node->instruction.opcode == TAC_RET
+            && (
+                !symbol_datatype(node->instruction.srcs[0], &actual)
+                || expected != actual
+            )
+        ) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static void inline_call(
+    struct tac *tac,
+    struct inliner_function const *callee,
+    struct tac_node *call_node
+)
+{
+    size_t i, rename_count;
+    struct inliner_rename *renames;
+    struct inliner_rename rename;
+    struct tac_instruction instruction;
+    struct tac_node *node;
+    struct symbol *end_label;
+
+    renames = vector_empty(&rename_count);
+
+    node = call_node;
+    for (i = callee->param_count; i > 0; i--) {
+        node = node->prev;
+        rename.from = callee->params[i - 1];
+        rename.to = symbol_table_create_tmp_scalar_var(
+            rename.from->data.variable.type
+        );
+        renames = vector_push(
+            renames,
+            sizeof(*renames),
+            &rename_count,
+            &rename
+        );
+        node->instruction.opcode = TAC_MOVE;
+        node->instruction.dest = rename.to;
+    }
+
+    end_label = symbol_table_create_tmp_label();
+    instruction.srcs[1] = NULL;
+    instruction.phi_arg_count = 0;
+    instruction.phi_args = NULL;
+
+    for (
+        node = callee->beginfun_node->next;
+        node != callee->endfun_node;
+        node = node->next
+    ) {
+        if (node->instruction.opcode == TAC_DEFP) {
+            continue;
+        }
+
+        if (node->instruction.opcode == TAC_RET) {
+            if (call_node->instruction.dest != NULL) {
+                instruction.opcode = TAC_MOVE;
+                instruction.dest = call_node->instruction.dest;
+                instruction.srcs[0] = rename_symbol(
+                    &renames,
+                    &rename_count,
+                    node->instruction.srcs[0]
+                );
+                instruction.srcs[1] = NULL;
+                tac_insert_before(tac, call_node, instruction);
+            }
+            if (node->next != callee->endfun_node) {
+                instruction.opcode = TAC_JUMP;
+                instruction.dest = end_label;
+                instruction.srcs[0] = NULL;
+                instruction.srcs[1] = NULL;
+                tac_insert_before(tac, call_node, instruction);
+            }
+            continue;
+        }
+
+        instruction.opcode = node->instruction.opcode;
+        instruction.dest = rename_symbol(
+            &renames,
+            &rename_count,
+            node->instruction.dest
+        );
+        for (i = 0; i < 2; i++) {
+            instruction.srcs[i] = rename_symbol(
+                &renames,
+                &rename_count,
+                node->instruction.srcs[i]
+            );
+        }
+        tac_insert_before(tac, call_node, instruction);
+    }
+
+    instruction.opcode = TAC_LABEL;
+    instruction.dest = NULL;
+    instruction.srcs[0] = end_label;
+    instruction.srcs[1] = NULL;
+    tac_insert_before(tac, call_node, instruction);
+    tac_remove(tac, call_node);
+
+    free(renames);
+}
+
+/*
+ * Temporaries, local vectors included, labels and parameters are local to
+ * the callee, so each inlined copy gets its own. Parameters are renamed
+ * before the body is copied, so other scalar variables, which are globals,
+ * are kept.
+ */
+static struct symbol *rename_symbol(
+    struct inliner_rename **renames,
+    size_t *rename_count,
+    struct symbol *symbol
+)
+{
+    size_t i;
+    struct inliner_rename rename;
+
+    if (symbol == NULL) {
+        return NULL;
+    }
+
+    for (i = 0; i < *rename_count; i++) {
+        if ((*renames)[i].from == symbol) {
+            return (*renames)[i].to;
+        }
+    }
+
+    switch (symbol->type) {
+        case SYM_TMP_VAR:
+            rename.to = symbol_table_create_tmp_scalar_var(
+                symbol->data.variable.type
+            );
+            break;
+        case SYM_TMP_VECTOR_VAR:
+            rename.to = symbol_table_create_tmp_vector_var(
+                symbol->data.variable.type,
+                symbol->data.variable.length
+            );
+            break;
+        case SYM_LABEL:
+            rename.to = symbol_table_create_tmp_label();
+            break;
+        default:
+            return symbol;
+    }
+
+    rename.from = symbol;
+    *renames = vector_push(*renames, sizeof(**renames), rename_count, &rename);
+    return rename.to;
+}
+
+static int symbol_datatype(struct symbol *symbol, enum datatype *datatype)
+{
+    switch (symbol->type) {
+        case SYM_LIT_INT:
+            *datatype = DATATYPE_INTE;
+            return 1;
+        case SYM_LIT_CHAR:
+            *datatype = DATATYPE_CARA;
+            return 1;
+        case SYM_LIT_FLOAT:
+            *datatype = DATATYPE_REAL;
+            return 1;
+        case SYM_TMP_VAR:
+        case SYM_SCALAR_VAR:
+            *datatype = symbol->data.variable.type;
+            return 1;
+        default:
+            return 0;
+    }
+}
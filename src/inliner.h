@@ -0,0 +1,16 @@
+#ifndef INLINER_H_
+#define INLINER_H_ 1
+
+#include <stddef.h>
+#include "tac.h"
+
+/**
+ * Replaces calls to functions that call nothing themselves and have at most
+ * size_limit instructions by a copy of their bodies, with fresh temporaries
+ * and labels. The parameters become temporaries holding the arguments, and
+ * each return becomes a copy into the call result and a jump past the copy.
+ * Functions that only call such functions become candidates in turn.
+ */
+void inline_calls(struct tac *tac, size_t size_limit);
+
+#endif
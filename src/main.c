@@ -26,6 +26,7 @@ struct arguments {
     enum operation operation;
     int debug;
     tac_opt_flags_type tac_opt_flags;
+    struct tac_opt_params tac_opt_params;
     x86_64_opt_flags_type x86_64_opt_flags;
     char const *source;
 };
@@ -81,7 +82,11 @@ int main(int argc, char const *argv[])
 
     if (exit_code == 0 && arguments.operation >= OPERATION_EMIT_DEBUG_TAC) {
         tac = gen_tac_for_ast(g_ast);
-        optimize_tac(&tac, arguments.tac_opt_flags);
+        optimize_tac(
+            &tac,
+            arguments.tac_opt_flags,
+            arguments.tac_opt_params
+        );
 
         if (arguments.operation < OPERATION_EMIT_ASSEMBLY_TAC) {
             fputs("generated TAC:\n\n", stderr);
@@ -91,7 +96,10 @@ int main(int argc, char const *argv[])
             tac_render_params.space_count = 4;
             tac_print(tac, tac_render_params);
         } else {
-            x86_64_asm_unit = x86_64_pc_linux_gnu_gen(tac);
+            x86_64_asm_unit = x86_64_pc_linux_gnu_gen(
+                tac,
+                arguments.x86_64_opt_flags
+            );
             x86_64_opt(&x86_64_asm_unit, arguments.x86_64_opt_flags);
 
             path_length = strlen(arguments.source);
@@ -156,12 +164,15 @@ static struct arguments parse_arguments(int argc, char const *argv[])
 {
     size_t i;
     struct arguments arguments;
+    char *end;
     int operation_given_count = 0;
 
     arguments.operation = OPERATION_EMIT_EXECUTABLE;
     arguments.source = NULL;
     arguments.debug = 0;
     arguments.tac_opt_flags = TAC_OPT_OFF;
+    arguments.tac_opt_params.inline_limit = TAC_OPT_DEFAULT_INLINE_LIMIT;
+    arguments.tac_opt_params.unroll_factor = TAC_OPT_DEFAULT_UNROLL_FACTOR;
     arguments.x86_64_opt_flags = X86_64_OPT_OFF;
 
     for (i = 1; i < argc; i++) {
@@ -221,10 +232,54 @@ static struct arguments parse_arguments(int argc, char const *argv[])
         } else if (strcmp(argv[i], "-finc-decs") == 0) {
             arguments.x86_64_opt_flags |= X86_64_OPT_INC_DECS;
             arguments.x86_64_opt_flags |= X86_64_OPT_DEDUP_MOVS;
+        } else if (strcmp(argv[i], "-fregalloc") == 0) {
+            arguments.x86_64_opt_flags |= X86_64_OPT_REGALLOC;
+        } else if (strcmp(argv[i], "-fframe-params") == 0) {
+            arguments.x86_64_opt_flags |= X86_64_OPT_FRAME_PARAMS;
+        } else if (strcmp(argv[i], "-ftail-calls") == 0) {
+            arguments.x86_64_opt_flags |= X86_64_OPT_TAIL_CALLS;
         } else if (strcmp(argv[i], "-fpower-of-two") == 0) {
             arguments.tac_opt_flags |= TAC_OPT_POWER_OF_TWO;
+        } else if (strcmp(argv[i], "-fmagic-div") == 0) {
+            arguments.tac_opt_flags |= TAC_OPT_MAGIC_DIV;
         } else if (strcmp(argv[i], "-freuse-tmps") == 0) {
             arguments.tac_opt_flags |= TAC_OPT_REUSE_TMPS;
+        } else if (strcmp(argv[i], "-fssa") == 0) {
+            arguments.tac_opt_flags |= TAC_OPT_SSA;
+        } else if (strcmp(argv[i], "-fconst-prop") == 0) {
+            arguments.tac_opt_flags |= TAC_OPT_CONST_PROP;
+        } else if (strcmp(argv[i], "-fdce") == 0) {
+            arguments.tac_opt_flags |= TAC_OPT_DCE;
+        } else if (strcmp(argv[i], "-fgvn") == 0) {
+            arguments.tac_opt_flags |= TAC_OPT_GVN;
+        } else if (strcmp(argv[i], "-flicm") == 0) {
+            arguments.tac_opt_flags |= TAC_OPT_LICM;
+        } else if (strcmp(argv[i], "-fstrength-reduce") == 0) {
+            arguments.tac_opt_flags |= TAC_OPT_STRENGTH_REDUCE;
+        } else if (strcmp(argv[i], "-finline") == 0) {
+            arguments.tac_opt_flags |= TAC_OPT_INLINE;
+        } else if (strcmp(argv[i], "-fmerge-prints") == 0) {
+            arguments.tac_opt_flags |= TAC_OPT_MERGE_PRINTS;
+        } else if (strcmp(argv[i], "-funroll-loops") == 0) {
+            arguments.tac_opt_flags |= TAC_OPT_UNROLL_LOOPS;
+        } else if (strcmp(argv[i], "-fvectorize") == 0) {
+            arguments.tac_opt_flags |= TAC_OPT_VECTORIZE;
+        } else if (strcmp(argv[i], "-floop-idioms") == 0) {
+            arguments.tac_opt_flags |= TAC_OPT_LOOP_IDIOMS;
+        } else if (strncmp(argv[i], "-finline-limit=", 15) == 0) {
+            arguments.tac_opt_params.inline_limit =
+                strtoul(argv[i] + 15, &end, 10);
+            if (argv[i][15] == '\0' || *end != '\0') {
+                fputs("-finline-limit requires a number\n\n", stderr);
+                show_usage();
+            }
+        } else if (strncmp(argv[i], "-funroll-factor=", 16) == 0) {
+            arguments.tac_opt_params.unroll_factor =
+                strtoul(argv[i] + 16, &end, 10);
+            if (argv[i][16] == '\0' || *end != '\0') {
+                fputs("-funroll-factor requires a number\n\n", stderr);
+                show_usage();
+            }
         } else if (
             strcmp(argv[i], "-g") == 0 || strcmp(argv[i], "--debug") == 0
         ) {
@@ -271,8 +326,25 @@ static void show_usage(void)
     fputs("    -O, --optimize               -- turns on all optimizations\n", stderr);
     fputs("    -fdedup-movs                 -- turns on dedup-movs optimization\n", stderr);
     fputs("    -finc-decs                   -- turns on inc-decs optimization\n", stderr);
+    fputs("    -fregalloc                   -- turns on register allocation optimization\n", stderr);
+    fputs("    -fframe-params               -- keeps parameters in stack frames\n", stderr);
+    fputs("    -ftail-calls                 -- turns calls in return position into jumps\n", stderr);
     fputs("    -fpower-of-two               -- turns on power-of-two optimization\n", stderr);
+    fputs("    -fmagic-div                  -- divides by other constants through multiply-high\n", stderr);
     fputs("    -freuse-tmps                 -- turns on reuse-temps optimization\n", stderr);
+    fputs("    -fssa                        -- round-trips the code through SSA form\n", stderr);
+    fputs("    -fconst-prop                 -- turns on constant propagation optimization\n", stderr);
+    fputs("    -fdce                        -- turns on dead code elimination\n", stderr);
+    fputs("    -fgvn                        -- turns on global value numbering\n", stderr);
+    fputs("    -flicm                       -- turns on loop-invariant code motion\n", stderr);
+    fputs("    -fstrength-reduce            -- turns on induction variable strength reduction\n", stderr);
+    fputs("    -finline                     -- turns on inlining of small functions\n", stderr);
+    fputs("    -finline-limit=N             -- inlines functions of at most N instructions\n", stderr);
+    fputs("    -fmerge-prints               -- renders constant escreva arguments at compile time\n", stderr);
+    fputs("    -funroll-loops               -- turns on unrolling of counted loops\n", stderr);
+    fputs("    -funroll-factor=N            -- unrolls loops of unknown trip count N times\n", stderr);
+    fputs("    -fvectorize                  -- turns element-wise vector loops into packed code\n", stderr);
+    fputs("    -floop-idioms                -- turns vector fill and copy loops into string instructions\n", stderr);
     fputs("    -g, --debug                  -- generates assembly debug symbols\n", stderr);
     fputs("    -h, --help                   -- prints this message\n", stderr);
     exit(1);
@@ -71,6 +71,7 @@ static void err_recovery(char const *message)
 
 %token KW_CARA
 %token KW_INTE
+%token KW_NATU
 %token KW_REAL
 
 %token KW_SE
@@ -85,6 +86,9 @@ static void err_recovery(char const *message)
 %token OPERATOR_GE
 %token OPERATOR_EQ
 %token OPERATOR_DIF
+%token OPERATOR_SHL
+%token OPERATOR_SHR
+%token OPERATOR_ROL
 
 %token<symbol> TK_IDENTIFIER
 
@@ -100,7 +104,9 @@ static void err_recovery(char const *message)
 %right '='
 %left '<' '>' OPERATOR_LE OPERATOR_GE OPERATOR_EQ OPERATOR_DIF
 %left '|'
+%left '^'
 %left '&'
+%left OPERATOR_SHL OPERATOR_SHR OPERATOR_ROL
 %left '~' '+' '-'
 %left '*' '/'
 %left '[' ']'
@@ -114,12 +120,15 @@ static void err_recovery(char const *message)
 %type<declaration> toplevel_declaration
 %type<vector_var_decl> vector_var_declaration
 %type<scalar_var_decl> scalar_var_declaration
+%type<scalar_var_decl> initialized_scalar_var_declaration
 %type<function_decl> function_declaration
 %type<parameter_list> parameter_list
 %type<parameter> parameter
 
 %type<statement_list> statement_list
 %type<statement> statement
+%type<statement> block_statement
+%type<statement> local_var_declaration
 %type<optional_statement> optional_statement
 %type<body> body
 %type<scalar_var_assign> scalar_var_assign
@@ -206,6 +215,11 @@ datatype: KW_INTE
                 $$ = DATATYPE_CARA;
                 TRACE;
             }
+        | KW_NATU
+            {
+                $$ = DATATYPE_NATU;
+                TRACE;
+            }
         | KW_REAL
             {
                 $$ = DATATYPE_REAL;
@@ -213,27 +227,9 @@ datatype: KW_INTE
             }
         ;
 
-scalar_var_declaration: datatype TK_IDENTIFIER '=' expression
-                            {
-                                $$.datatype = $1;
-                                $$.name = $2;
-                                $$.init = $4;
-                                TRACE;
-                            }
-                      | datatype TK_IDENTIFIER error expression
-                            {
-                                $$.datatype = $1;
-                                $$.name = $2;
-                                $$.init = $4;
-                                err_recovery("missing assignment operator in scalar variable declaration");
-                                TRACE;
-                            }
-                      | datatype TK_IDENTIFIER '=' error
+scalar_var_declaration: initialized_scalar_var_declaration
                             {
-                                $$.datatype = $1;
-                                $$.name = $2;
-                                $$.init.tag = AST_INPUT;
-                                err_recovery("missing initialization expression in scalar variable declaration");
+                                $$ = $1;
                                 TRACE;
                             }
                       | datatype TK_IDENTIFIER error
@@ -244,24 +240,49 @@ scalar_var_declaration: datatype TK_IDENTIFIER '=' expression
                                 err_recovery("missing initialization in scalar variable declaration");
                                 TRACE;
                             }
-                      | datatype error '=' expression
-                            {
-                                $$.datatype = $1;
-                                $$.name = symbol_table_insert("@null");
-                                $$.init.tag = AST_INPUT;
-                                err_recovery("missing variable name in scalar variable declaration");
-                                TRACE;
-                            }
-                      | datatype error '=' error
-                            {
-                                $$.datatype = $1;
-                                $$.name = symbol_table_insert("@null");
-                                $$.init.tag = AST_INPUT;
-                                err_recovery("missing variable name and initialization in scalar variable declaration");
-                                TRACE;
-                            }
                       ;
 
+initialized_scalar_var_declaration: datatype TK_IDENTIFIER '=' expression
+                                        {
+                                            $$.datatype = $1;
+                                            $$.name = $2;
+                                            $$.init = $4;
+                                            TRACE;
+                                        }
+                                  | datatype TK_IDENTIFIER error expression
+                                        {
+                                            $$.datatype = $1;
+                                            $$.name = $2;
+                                            $$.init = $4;
+                                            err_recovery("missing assignment operator in scalar variable declaration");
+                                            TRACE;
+                                        }
+                                  | datatype TK_IDENTIFIER '=' error
+                                        {
+                                            $$.datatype = $1;
+                                            $$.name = $2;
+                                            $$.init.tag = AST_INPUT;
+                                            err_recovery("missing initialization expression in scalar variable declaration");
+                                            TRACE;
+                                        }
+                                  | datatype error '=' expression
+                                        {
+                                            $$.datatype = $1;
+                                            $$.name = symbol_table_insert("@null");
+                                            $$.init.tag = AST_INPUT;
+                                            err_recovery("missing variable name in scalar variable declaration");
+                                            TRACE;
+                                        }
+                                  | datatype error '=' error
+                                        {
+                                            $$.datatype = $1;
+                                            $$.name = symbol_table_insert("@null");
+                                            $$.init.tag = AST_INPUT;
+                                            err_recovery("missing variable name and initialization in scalar variable declaration");
+                                            TRACE;
+                                        }
+                                  ;
+
 vector_var_declaration: datatype TK_IDENTIFIER '[' expression ']' expression_list
                             {
                                 $$.datatype = $1;
@@ -416,7 +437,7 @@ body: '{' statement_list '}'
         }
     ;
 
-statement_list: statement_list ';' statement
+statement_list: statement_list ';' block_statement
                 {
                     $1.statements = vector_push(
                         $1.statements,
@@ -432,7 +453,7 @@ statement_list: statement_list ';' statement
                     $$ = $1;
                     TRACE;
                 }
-              | statement
+              | block_statement
                 {
                     $$.statements = vector_singleton(
                         sizeof($1),
@@ -460,6 +481,52 @@ statement_list: statement_list ';' statement
                 }
               ;
 
+block_statement: statement
+                    {
+                        $$ = $1;
+                        TRACE;
+                    }
+               | local_var_declaration
+                    {
+                        $$ = $1;
+                        TRACE;
+                    }
+               ;
+
+local_var_declaration: initialized_scalar_var_declaration
+                        {
+                            $$ = ast_statement_base_init();
+                            $$.tag = AST_LOCAL_VAR_DECL;
+                            $$.data.local_var_decl = aborting_malloc(
+                                sizeof(*$$.data.local_var_decl)
+                            );
+                            $$.data.local_var_decl->declaration =
+                                ast_declaration_base_init();
+                            $$.data.local_var_decl->declaration.tag =
+                                AST_SCALAR_VAR_DECL;
+                            $$.data.local_var_decl
+                                ->declaration.data.scalar_var = $1;
+                            $$.data.local_var_decl->variable = NULL;
+                            TRACE;
+                        }
+                     | vector_var_declaration
+                        {
+                            $$ = ast_statement_base_init();
+                            $$.tag = AST_LOCAL_VAR_DECL;
+                            $$.data.local_var_decl = aborting_malloc(
+                                sizeof(*$$.data.local_var_decl)
+                            );
+                            $$.data.local_var_decl->declaration =
+                                ast_declaration_base_init();
+                            $$.data.local_var_decl->declaration.tag =
+                                AST_VECTOR_VAR_DECL;
+                            $$.data.local_var_decl
+                                ->declaration.data.vector_var = $1;
+                            $$.data.local_var_decl->variable = NULL;
+                            TRACE;
+                        }
+                     ;
+
 optional_statement: statement
                     {
                         $$ = aborting_malloc(sizeof($1));
@@ -860,6 +927,38 @@ expression: LIT_INTEIRO
                     $$ = ast_create_binary_operation($1, AST_OR, $3);
                     TRACE;
                 }
+          | expression '^' expression
+                {
+                    $$ = ast_create_binary_operation($1, AST_BIT_XOR, $3);
+                    TRACE;
+                }
+          | expression OPERATOR_SHL expression
+                {
+                    $$ = ast_create_binary_operation(
+                        $1,
+                        AST_SHIFT_LEFT,
+                        $3
+                    );
+                    TRACE;
+                }
+          | expression OPERATOR_SHR expression
+                {
+                    $$ = ast_create_binary_operation(
+                        $1,
+                        AST_SHIFT_RIGHT,
+                        $3
+                    );
+                    TRACE;
+                }
+          | expression OPERATOR_ROL expression
+                {
+                    $$ = ast_create_binary_operation(
+                        $1,
+                        AST_ROTATE_LEFT,
+                        $3
+                    );
+                    TRACE;
+                }
           | '~' expression
                 {
                     $$ = ast_create_unary_operation(AST_NOT, $2);
@@ -81,6 +81,21 @@ static void semantic_check_write(
     struct semantic_error_params params
 );
 
+static void semantic_check_statement_list(
+    struct ast_statement_list *statement_list,
+    enum semantic_type expected_return,
+    struct semantic_error_params params
+);
+
+static void semantic_check_local_var_decl(
+    struct ast_statement *statement,
+    struct semantic_error_params params
+);
+
+static void end_local_var_scope(struct ast_local_var_decl *local_var_decl);
+
+static struct symbol *resolve_local_var(struct symbol *variable);
+
 static void semantic_check_scalar_var_decl(
     struct ast_declaration *declaration,
     struct semantic_error_params params
@@ -262,13 +277,11 @@ static void semantic_check_function(
         function->parameter_list.parameters[i].name->data.variable.in_scope = 1;
     }
 
-    for (i = 0; i < function->body.statement_list.length; i++) {
-        semantic_check_statement(
-            &function->body.statement_list.statements[i],
-            datatype_to_semantic_type(function->return_datatype),
-            params
-        );
-    }
+    semantic_check_statement_list(
+        &function->body.statement_list,
+        datatype_to_semantic_type(function->return_datatype),
+        params
+    );
 
     for (i = 0; i < function->parameter_list.length; i++) {
         function->parameter_list.parameters[i].name->data.variable.in_scope = 0;
@@ -327,9 +340,147 @@ void semantic_check_statement(
         case AST_EXPRESSION_STATEMENT:
             semantic_check_expr_stmt(statement, expected_return, params);
             break;
+        case AST_LOCAL_VAR_DECL:
+            semantic_check_local_var_decl(statement, params);
+            break;
+    }
+}
+
+static void semantic_check_statement_list(
+    struct ast_statement_list *statement_list,
+    enum semantic_type expected_return,
+    struct semantic_error_params params
+)
+{
+    size_t i;
+
+    for (i = 0; i < statement_list->length; i++) {
+        semantic_check_statement(
+            &statement_list->statements[i],
+            expected_return,
+            params
+        );
+    }
+
+    for (i = 0; i < statement_list->length; i++) {
+        if (statement_list->statements[i].tag == AST_LOCAL_VAR_DECL) {
+            end_local_var_scope(
+                statement_list->statements[i].data.local_var_decl
+            );
+        }
     }
 }
 
+/*
+ * Like parameters, a local variable is checked through its name's symbol,
+ * which is in scope until the end of the enclosing body. Each declaration
+ * also gets a temporary that uses of the name are rewritten to, so the
+ * variable lives in the function's stack frame or in a register.
+ */
+static void semantic_check_local_var_decl(
+    struct ast_statement *statement,
+    struct semantic_error_params params
+)
+{
+    long length;
+    struct symbol *name;
+    struct ast_local_var_decl *local_var_decl;
+
+    local_var_decl = statement->data.local_var_decl;
+
+    switch (local_var_decl->declaration.tag) {
+        case AST_SCALAR_VAR_DECL:
+            semantic_check_scalar_var_decl(
+                &local_var_decl->declaration,
+                params
+            );
+            name = local_var_decl->declaration.data.scalar_var.name;
+            break;
+        case AST_VECTOR_VAR_DECL:
+            semantic_check_vector_var_decl(
+                &local_var_decl->declaration,
+                params
+            );
+            name = local_var_decl->declaration.data.vector_var.name;
+            break;
+        default:
+            panic(
+                "declaration tag %i cannot be local",
+                local_var_decl->declaration.tag
+            );
+    }
+
+    if (name->type != SYM_UNKNOWN_IDENT) {
+        print_redeclared_symbol(*name, statement->line_number, params);
+        return;
+    }
+
+    switch (local_var_decl->declaration.tag) {
+        case AST_SCALAR_VAR_DECL:
+            name->type = SYM_SCALAR_VAR;
+            name->data.variable.type =
+                local_var_decl->declaration.data.scalar_var.datatype;
+            local_var_decl->variable = symbol_table_create_tmp_scalar_var(
+                name->data.variable.type
+            );
+            break;
+        case AST_VECTOR_VAR_DECL:
+            if (
+                !const_eval_int_expression(
+                    local_var_decl->declaration.data.vector_var.length,
+                    &length
+                )
+                || length < 0
+            ) {
+                length = 0;
+            }
+            name->type = SYM_VECTOR_VAR;
+            name->data.variable.type =
+                local_var_decl->declaration.data.vector_var.datatype;
+            local_var_decl->variable = symbol_table_create_tmp_vector_var(
+                name->data.variable.type,
+                length
+            );
+            break;
+        default:
+            break;
+    }
+
+    name->data.variable.in_scope = 1;
+    name->data.variable.replacement = local_var_decl->variable;
+}
+
+static void end_local_var_scope(struct ast_local_var_decl *local_var_decl)
+{
+    struct symbol *name;
+
+    if (local_var_decl->variable == NULL) {
+        return;
+    }
+
+    if (local_var_decl->declaration.tag == AST_SCALAR_VAR_DECL) {
+        name = local_var_decl->declaration.data.scalar_var.name;
+    } else {
+        name = local_var_decl->declaration.data.vector_var.name;
+    }
+
+    name->type = SYM_UNKNOWN_IDENT;
+    name->data.variable.in_scope = 0;
+    name->data.variable.replacement = NULL;
+}
+
+/* gives the temporary of a local variable in scope, or the variable itself */
+static struct symbol *resolve_local_var(struct symbol *variable)
+{
+    if (
+        (variable->type == SYM_SCALAR_VAR || variable->type == SYM_VECTOR_VAR)
+        && variable->data.variable.replacement != NULL
+    ) {
+        return variable->data.variable.replacement;
+    }
+    return variable;
+}
+
 static void semantic_check_var_assign(
     struct ast_statement *statement,
     enum semantic_type expected_return,
@@ -376,6 +527,9 @@ static void semantic_check_var_assign(
             );
         }
     }
+
+    statement->data.scalar_var_assign.variable =
+        resolve_local_var(statement->data.scalar_var_assign.variable);
 }
 
 static void semantic_check_subscripted_assign(
@@ -441,6 +595,9 @@ static void semantic_check_subscripted_assign(
             );
         }
     }
+
+    statement->data.subscripted_assign.variable =
+        resolve_local_var(statement->data.subscripted_assign.variable);
 }
 
 static void semantic_check_if(
@@ -585,15 +742,11 @@ static void semantic_check_body(
     struct semantic_error_params params
 )
 {
-    size_t i;
-
-    for (i = 0; i < statement->data.body.statement_list.length; i++) {
-        semantic_check_statement(
-            &statement->data.body.statement_list.statements[i],
-            expected_return,
-            params
-        );
-    }
+    semantic_check_statement_list(
+        &statement->data.body.statement_list,
+        expected_return,
+        params
+    );
 }
 
 static void semantic_check_expr_stmt(
@@ -693,6 +846,21 @@ static void infer_binop_semantic_type(
         expression->inference_status = INFERENCE_ERROR;
     }
 
+    /* & and | over integers operate on their bits */
+    if (
+        operation_type == OPERATION_LOGICAL
+        && left_operand != NULL
+        && right_operand != NULL
+        && semantic_type_is_integer(*left_operand)
+        && semantic_type_is_integer(*right_operand)
+    ) {
+        expression->data.binary_operation.operator =
+            expression->data.binary_operation.operator == AST_AND
+            ? AST_BIT_AND
+            : AST_BIT_OR;
+        operation_type = OPERATION_BITWISE;
+    }
+
     switch (operation_type) {
         case OPERATION_ARITHMETIC:
             if (
@@ -739,7 +907,11 @@ static void infer_binop_semantic_type(
                         params
                     );
                 } else {
-                    expression->semantic_type = *left_operand;
+                    /* other integers mixed with natu wrap into natu */
+                    expression->semantic_type =
+                        *right_operand == SEMANTIC_NAT
+                        ? SEMANTIC_NAT
+                        : *left_operand;
                     expression->inference_status = INFERENCE_OK;
                 }
             }
@@ -774,6 +946,55 @@ static void infer_binop_semantic_type(
             expression->inference_status = INFERENCE_OK;
             break;
 
+        case OPERATION_BITWISE:
+            if (
+                left_operand != NULL
+                && !semantic_type_is_integer(*left_operand)
+            ) {
+                expression->inference_status = INFERENCE_ERROR;
+                print_inv_semantic_type_mismatch(
+                    *left_operand,
+                    expression->data.binary_operation.left_operand->line_number,
+                    params
+                );
+            }
+
+            if (
+                right_operand != NULL
+                && !semantic_type_is_integer(*right_operand)
+            ) {
+                expression->inference_status = INFERENCE_ERROR;
+                print_inv_semantic_type_mismatch(
+                    *right_operand,
+                    expression
+                        ->data.binary_operation.right_operand->line_number,
+                    params
+                );
+            }
+
+            if (expression->inference_status == INFERENCE_UNKNOWN) {
+                /* shifts and rotations keep the type of the shifted value */
+                switch (expression->data.binary_operation.operator) {
+                    case AST_BIT_AND:
+                    case AST_BIT_OR:
+                    case AST_BIT_XOR:
+                        if (
+                            right_operand != NULL
+                            && *right_operand == SEMANTIC_NAT
+                        ) {
+                            expression->semantic_type = SEMANTIC_NAT;
+                            break;
+                        }
+                    default:
+                        expression->semantic_type = left_operand == NULL
+                            ? *right_operand
+                            : *left_operand;
+                        break;
+                }
+                expression->inference_status = INFERENCE_OK;
+            }
+            break;
+
         case OPERATION_COMPARISON:
             if (
                 left_operand != NULL
@@ -838,6 +1059,16 @@ static void infer_unop_semantic_type(
         params
     );
 
+    /* ~ over an integer complements its bits */
+    if (
+        operation_type == OPERATION_LOGICAL
+        && operand != NULL
+        && semantic_type_is_integer(*operand)
+    ) {
+        expression->data.unary_operation.operator = AST_BIT_NOT;
+        operation_type = OPERATION_BITWISE;
+    }
+
     switch (operation_type) {
         case OPERATION_ARITHMETIC:
             if (operand == NULL) {
@@ -869,6 +1100,21 @@ static void infer_unop_semantic_type(
                 );
             }
             break;
+        case OPERATION_BITWISE:
+            if (operand == NULL) {
+                expression->inference_status = INFERENCE_ERROR;
+            } else if (!semantic_type_is_integer(*operand)) {
+                print_inv_semantic_type_mismatch(
+                    *operand,
+                    expression->data.unary_operation.operand->line_number,
+                    params
+                );
+                expression->inference_status = INFERENCE_ERROR;
+            } else {
+                expression->semantic_type = *operand;
+                expression->inference_status = INFERENCE_OK;
+            }
+            break;
         case OPERATION_COMPARISON:
             expression->semantic_type = SEMANTIC_BOOL;
             expression->inference_status = INFERENCE_OK;
@@ -914,6 +1160,9 @@ static void infer_variable_semantic_type(
             expression->data.subscription.variable->data.variable.type
         );
     }
+
+    expression->data.variable.name =
+        resolve_local_var(expression->data.variable.name);
 }
 
 static void infer_subscription_semantic_type(
@@ -959,6 +1208,9 @@ static void infer_subscription_semantic_type(
             expression->data.subscription.variable->data.variable.type
         );
     }
+
+    expression->data.subscription.variable =
+        resolve_local_var(expression->data.subscription.variable);
 }
 
 static void infer_func_call_semantic_type(
@@ -1295,6 +1547,13 @@ enum operation_type binary_operation_type( enum ast_binary_operator operator)
         case AST_AND:
         case AST_OR:
             return OPERATION_LOGICAL;
+        case AST_BIT_AND:
+        case AST_BIT_OR:
+        case AST_BIT_XOR:
+        case AST_SHIFT_LEFT:
+        case AST_SHIFT_RIGHT:
+        case AST_ROTATE_LEFT:
+            return OPERATION_BITWISE;
     }
     panic("unimplemented binary operation %i's semantic check", operator);
 }
@@ -1305,6 +1564,8 @@ enum operation_type unary_operation_type( enum ast_unary_operator operator)
     switch (operator) {
         case AST_NOT:
             return OPERATION_LOGICAL;
+        case AST_BIT_NOT:
+            return OPERATION_BITWISE;
     }
     panic("unimplemented unary operation %i's semantic check", operator);
 }
@@ -6,7 +6,8 @@
 enum operation_type {
     OPERATION_ARITHMETIC,
     OPERATION_COMPARISON,
-    OPERATION_LOGICAL
+    OPERATION_LOGICAL,
+    OPERATION_BITWISE
 };
 
 struct semantic_error_params {
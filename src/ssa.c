@@ -0,0 +1,1794 @@
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ssa.h"
+#include "cfg.h"
+#include "alloc.h"
+#include "symboltable.h"
+#include "vector.h"
+#include "panic.h"
+
+enum ssa_var_kind {
+    SSA_VAR_TMP,
+    SSA_VAR_PARAM,
+    SSA_VAR_GLOBAL
+};
+
+struct ssa_var {
+    struct symbol *symbol;
+    enum ssa_var_kind kind;
+    int is_assigned;
+    int is_non_local;
+    size_t defined_in;
+    size_t def_block_count;
+    size_t *def_blocks;
+    size_t stack_length;
+    struct symbol **stack;
+};
+
+struct ssa_phi {
+    struct tac_node *node;
+    size_t var;
+};
+
+struct ssa_block {
+    size_t phi_count;
+    struct ssa_phi *phis;
+};
+
+/*
+ * Scalar globals a function may read or write, including through the
+ * functions it calls. An opaque function calls something unknown, so it may
+ * access any global.
+ */
+struct ssa_summary {
+    struct symbol *function;
+    int is_opaque;
+    size_t read_count;
+    struct symbol **reads;
+    size_t write_count;
+    struct symbol **writes;
+    size_t callee_count;
+    struct symbol **callees;
+};
+
+#define BITS_PER_WORD (CHAR_BIT * sizeof(unsigned long))
+
+struct coalescer {
+    struct cfg cfg;
+    size_t tmp_count;
+    struct symbol **tmps;
+    size_t word_count;
+    /* one row of word_count words per block */
+    unsigned long *live_out;
+    /* one row of word_count words per temporary */
+    unsigned long *interference;
+    size_t *parents;
+};
+
+struct ssa_builder {
+    struct tac *tac;
+    struct cfg cfg;
+    size_t summary_count;
+    struct ssa_summary *summaries;
+    struct ssa_block *blocks;
+    size_t var_count;
+    struct ssa_var *vars;
+    size_t load_count;
+    struct symbol **loads;
+    size_t store_count;
+    struct tac_node **stores;
+};
+
+struct synced_phi {
+    struct tac_node *node;
+    int is_synced;
+};
+
+static struct ssa_summary *collect_summaries(
+    struct tac *tac,
+    size_t *summary_count
+);
+
+static int add_to_set(
+    struct symbol ***set,
+    size_t *length,
+    struct symbol *symbol
+);
+
+static int set_contains(
+    struct symbol *const *set,
+    size_t length,
+    struct symbol *symbol
+);
+
+static struct ssa_summary const *callee_summary(
+    struct ssa_builder *builder,
+    struct tac_node *call_node
+);
+
+static int summary_reads(
+    struct ssa_summary const *summary,
+    struct symbol *symbol
+);
+
+static int summary_writes(
+    struct ssa_summary const *summary,
+    struct symbol *symbol
+);
+
+static struct tac_node *construct_function(
+    struct tac *tac,
+    struct tac_node *beginfun_node,
+    size_t summary_count,
+    struct ssa_summary *summaries
+);
+
+static void ensure_entry_block(struct tac *tac, struct tac_node *beginfun_node);
+
+static void anchor_join_predecessors(struct tac *tac, struct cfg *cfg);
+
+static int is_ssa_candidate(struct symbol *symbol);
+
+static size_t find_var(struct ssa_builder *builder, struct symbol *symbol);
+
+static size_t add_var(
+    struct ssa_builder *builder,
+    struct symbol *symbol,
+    enum ssa_var_kind kind
+);
+
+static void collect_vars(struct ssa_builder *builder);
+
+static void collect_use(
+    struct ssa_builder *builder,
+    struct symbol *symbol,
+    size_t block
+);
+
+static void collect_def(
+    struct ssa_builder *builder,
+    struct symbol *symbol,
+    size_t block
+);
+
+static void place_phis(struct ssa_builder *builder);
+
+static void insert_phi(struct ssa_builder *builder, size_t block, size_t var);
+
+static void rename_block(struct ssa_builder *builder, size_t block);
+
+static struct symbol *rename_use(
+    struct ssa_builder *builder,
+    struct symbol *symbol
+);
+
+static struct symbol *push_version(
+    struct ssa_builder *builder,
+    size_t var,
+    size_t **pushed,
+    size_t *pushed_length
+);
+
+static struct symbol *top_version(struct ssa_builder *builder, size_t var);
+
+static void insert_global_stores(
+    struct ssa_builder *builder,
+    struct tac_node *before,
+    struct ssa_summary const *callee
+);
+
+static struct tac_node *insert_global_loads(
+    struct ssa_builder *builder,
+    size_t block,
+    struct tac_node *after,
+    struct symbol *skipped,
+    struct ssa_summary const *callee,
+    size_t **pushed,
+    size_t *pushed_length
+);
+
+static int is_load_version(struct ssa_builder *builder, struct symbol *symbol);
+
+static void remove_synced_stores(struct ssa_builder *builder);
+
+static int is_synced_version(
+    struct ssa_builder *builder,
+    size_t phi_count,
+    struct synced_phi *phis,
+    struct symbol *symbol
+);
+
+static void fill_successor_phis(struct ssa_builder *builder, size_t block);
+
+static void builder_free(struct ssa_builder *builder);
+
+static struct tac_node *destruct_function(
+    struct tac *tac,
+    struct tac_node *beginfun_node
+);
+
+static void insert_at_block_end(
+    struct tac *tac,
+    struct cfg_block *block,
+    struct tac_instruction instruction
+);
+
+static void remove_unused_labels(
+    struct tac *tac,
+    struct tac_node *beginfun_node
+);
+
+static void coalesce_copies(struct tac *tac, struct tac_node *beginfun_node);
+
+static size_t coalescer_index(struct coalescer *coalescer, struct symbol *symbol);
+
+static void coalescer_number(struct coalescer *coalescer, struct symbol *symbol);
+
+static void coalescer_transfer(
+    struct coalescer *coalescer,
+    struct tac_node *node,
+    unsigned long *live
+);
+
+static void coalescer_liveness(struct coalescer *coalescer);
+
+static void coalescer_interference(struct coalescer *coalescer);
+
+static void coalescer_merge(struct coalescer *coalescer);
+
+static size_t coalescer_find(struct coalescer *coalescer, size_t index);
+
+static void coalescer_rewrite(
+    struct coalescer *coalescer,
+    struct tac *tac,
+    struct tac_node *beginfun_node
+);
+
+static struct symbol *coalescer_rename(
+    struct coalescer *coalescer,
+    struct symbol *symbol
+);
+
+static int bit_test(unsigned long const *row, size_t index);
+
+static void bit_set(unsigned long *row, size_t index);
+
+static void bit_clear(unsigned long *row, size_t index);
+
+void ssa_construct(struct tac *tac)
+{
+    size_t i, summary_count;
+    struct ssa_summary *summaries;
+    struct tac_node *node;
+
+    summaries = collect_summaries(tac, &summary_count);
+
+    node = tac_find_function_start(tac->first);
+    while (node != NULL) {
+        node = construct_function(tac, node, summary_count, summaries);
+        node = tac_find_function_start(node);
+    }
+
+    for (i = 0; i < summary_count; i++) {
+        free(summaries[i].reads);
+        free(summaries[i].writes);
+        free(summaries[i].callees);
+    }
+    free(summaries);
+}
+
+void ssa_destruct(struct tac *tac)
+{
+    struct tac_node *node;
+
+    node = tac_find_function_start(tac->first);
+    while (node != NULL) {
+        node = destruct_function(tac, node);
+        node = tac_find_function_start(node);
+    }
+}
+
+/*
+ * Parameters count as globals here, since the callee writes them on every
+ * call and they may live in static memory.
+ */
+static struct ssa_summary *collect_summaries(
+    struct tac *tac,
+    size_t *summary_count
+)
+{
+    size_t i, j, k;
+    int changed;
+    struct ssa_summary *summaries;
+    struct ssa_summary *summary;
+    struct ssa_summary const *callee;
+    struct ssa_summary new_summary;
+    struct tac_node *node;
+
+    summaries = vector_empty(summary_count);
+    summary = NULL;
+    for (node = tac->first; node != NULL; node = node->next) {
+        switch (node->instruction.opcode) {
+            case TAC_BEGINFUN:
+                new_summary.function = node->instruction.dest;
+                new_summary.is_opaque = 0;
+                new_summary.reads = vector_empty(&new_summary.read_count);
+                new_summary.writes = vector_empty(&new_summary.write_count);
+                new_summary.callees = vector_empty(&new_summary.callee_count);
+                summaries = vector_push(
+                    summaries,
+                    sizeof(*summaries),
+                    summary_count,
+                    &new_summary
+                );
+                summary = &summaries[*summary_count - 1];
+                break;
+
+            case TAC_ENDFUN:
+                summary = NULL;
+                break;
+
+            default:
+                if (summary == NULL || node->instruction.opcode == TAC_LABEL) {
+                    break;
+                }
+                for (i = 0; i < 2; i++) {
+                    if (
+                        node->instruction.srcs[i] != NULL
+                        && node->instruction.srcs[i]->type == SYM_SCALAR_VAR
+                    ) {
+                        add_to_set(
+                            &summary->reads,
+                            &summary->read_count,
+                            node->instruction.srcs[i]
+                        );
+                    }
+                }
+                if (
+                    tac_defines_dest(node->instruction.opcode)
+                    && node->instruction.dest->type == SYM_SCALAR_VAR
+                ) {
+                    add_to_set(
+                        &summary->writes,
+                        &summary->write_count,
+                        node->instruction.dest
+                    );
+                    if (node->instruction.opcode == TAC_DEFP) {
+                        add_to_set(
+                            &summary->reads,
+                            &summary->read_count,
+                            node->instruction.dest
+                        );
+                    }
+                }
+                if (node->instruction.opcode == TAC_CALL) {
+                    add_to_set(
+                        &summary->callees,
+                        &summary->callee_count,
+                        node->instruction.srcs[0]
+                    );
+                }
+                break;
+        }
+    }
+
+    do {
+        changed = 0;
+        for (i = 0; i < *summary_count; i++) {
+            summary = &summaries[i];
+            for (j = 0; j < summary->callee_count && !summary->is_opaque; j++) {
+                callee = NULL;
+                for (k = 0; k < *summary_count; k++) {
+                    if (summaries[k].function == summary->callees[j]) {
+                        callee = &summaries[k];
+                    }
+                }
+                if (callee == NULL || callee->is_opaque) {
+                    summary->is_opaque = 1;
+                    changed = 1;
+                    break;
+                }
+                for (k = 0; k < callee->read_count; k++) {
+                    changed |= add_to_set(
+                        &summary->reads,
+                        &summary->read_count,
+                        callee->reads[k]
+                    );
+                }
+                for (k = 0; k < callee->write_count; k++) {
+                    changed |= add_to_set(
+                        &summary->writes,
+                        &summary->write_count,
+                        callee->writes[k]
+                    );
+                }
+            }
+        }
+    } while (changed);
+
+    return summaries;
+}
+
+static int add_to_set(
+    struct symbol ***set,
+    size_t *length,
+    struct symbol *symbol
+)
+{
+    if (set_contains(*set, *length, symbol)) {
+        return 0;
+    }
+    *set = vector_push(*set, sizeof(**set), length, &symbol);
+    return 1;
+}
+
+static int set_contains(
+    struct symbol *const *set,
+    size_t length,
+    struct symbol *symbol
+)
+{
+    size_t i;
+
+    for (i = 0; i < length; i++) {
+        if (set[i] == symbol) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* NULL when the callee may access any global */
+static struct ssa_summary const *callee_summary(
+    struct ssa_builder *builder,
+    struct tac_node *call_node
+)
+{
+    size_t i;
+
+    for (i = 0; i < builder->summary_count; i++) {
+        if (builder->summaries[i].function == call_node->instruction.srcs[0]) {
+            return builder->summaries[i].is_opaque
+                ? NULL
+                : &builder->summaries[i];
+        }
+    }
+    return NULL;
+}
+
+static int summary_reads(
+    struct ssa_summary const *summary,
+    struct symbol *symbol
+)
+{
+    return summary == NULL
+        || set_contains(summary->reads, summary->read_count, symbol);
+}
+
+static int summary_writes(
+    struct ssa_summary const *summary,
+    struct symbol *symbol
+)
+{
+    return summary == NULL
+        || set_contains(summary->writes, summary->write_count, symbol);
+}
+
+static struct tac_node *construct_function(
+    struct tac *tac,
+    struct tac_node *beginfun_node,
+    size_t summary_count,
+    struct ssa_summary *summaries
+)
+{
+    size_t i;
+    struct tac_node *endfun_node;
+    struct ssa_builder builder;
+
+    ensure_entry_block(tac, beginfun_node);
+
+    builder.tac = tac;
+    builder.summary_count = summary_count;
+    builder.summaries = summaries;
+    builder.cfg = cfg_build(beginfun_node);
+    anchor_join_predecessors(tac, &builder.cfg);
+    builder.vars = vector_empty(&builder.var_count);
+    builder.loads = vector_empty(&builder.load_count);
+    builder.stores = vector_empty(&builder.store_count);
+    builder.blocks = aborting_malloc(
+        sizeof(*builder.blocks) * (builder.cfg.block_count + 1)
+    );
+    for (i = 0; i < builder.cfg.block_count; i++) {
+        builder.blocks[i].phis = vector_empty(&builder.blocks[i].phi_count);
+    }
+
+    collect_vars(&builder);
+    place_phis(&builder);
+    if (builder.cfg.block_count > 0) {
+        rename_block(&builder, 0);
+        remove_synced_stores(&builder);
+    }
+
+    endfun_node = builder.cfg.endfun_node;
+    builder_free(&builder);
+    return endfun_node;
+}
+
+/*
+ * The entry block must not have predecessors, otherwise there would be no
+ * place for the initial versions to come from, and it must not become empty
+ * when passes remove code from it, otherwise the block order the phis rely on
+ * would change. A label of its own right after the parameters ensures both,
+ * and it is removed again when leaving SSA form, as every unused label is.
+ */
+static void ensure_entry_block(struct tac *tac, struct tac_node *beginfun_node)
+{
+    struct tac_node *node;
+    struct tac_instruction instruction;
+
+    node = beginfun_node;
+    while (node->next->instruction.opcode == TAC_DEFP) {
+        node = node->next;
+    }
+
+    instruction.opcode = TAC_LABEL;
+    instruction.dest = NULL;
+    instruction.srcs[0] = symbol_table_create_tmp_label();
+    instruction.srcs[1] = NULL;
+    tac_insert_after(tac, node, instruction);
+}
+
+/*
+ * For the same reason, a block falling through into a join must not become
+ * empty: its predecessor would then both jump and fall through into the join,
+ * and the CFG would keep a single edge for two phi arguments.
+ */
+static void anchor_join_predecessors(struct tac *tac, struct cfg *cfg)
+{
+    size_t i, j;
+    struct cfg_block *block;
+    struct tac_instruction instruction;
+
+    for (i = 0; i < cfg->block_count; i++) {
+        if (cfg->blocks[i].predecessor_count < 2) {
+            continue;
+        }
+        for (j = 0; j < cfg->blocks[i].predecessor_count; j++) {
+            block = &cfg->blocks[cfg->blocks[i].predecessors[j]];
+            if (
+                block->first->instruction.opcode == TAC_LABEL
+                || block->last->instruction.opcode == TAC_JUMP
+                || block->last->instruction.opcode == TAC_IFZ
+            ) {
+                continue;
+            }
+            instruction.opcode = TAC_LABEL;
+            instruction.dest = NULL;
+            instruction.srcs[0] = symbol_table_create_tmp_label();
+            instruction.srcs[1] = NULL;
+            block->first = tac_insert_before(tac, block->first, instruction);
+        }
+    }
+}
+
+static int is_ssa_candidate(struct symbol *symbol)
+{
+    return symbol != NULL
+        && (symbol->type == SYM_TMP_VAR || symbol->type == SYM_SCALAR_VAR);
+}
+
+static size_t find_var(struct ssa_builder *builder, struct symbol *symbol)
+{
+    size_t index = symbol->data.variable.ssa_index;
+
+    if (index < builder->var_count && builder->vars[index].symbol == symbol) {
+        return index;
+    }
+    return SIZE_MAX;
+}
+
+static size_t add_var(
+    struct ssa_builder *builder,
+    struct symbol *symbol,
+    enum ssa_var_kind kind
+)
+{
+    struct ssa_var var;
+
+    var.symbol = symbol;
+    var.kind = kind;
+    var.is_assigned = 0;
+    var.is_non_local = 0;
+    var.defined_in = CFG_NO_BLOCK;
+    var.def_blocks = vector_empty(&var.def_block_count);
+    var.stack = vector_empty(&var.stack_length);
+
+    symbol->data.variable.ssa_index = builder->var_count;
+    builder->vars = vector_push(
+        builder->vars,
+        sizeof(*builder->vars),
+        &builder->var_count,
+        &var
+    );
+    return builder->var_count - 1;
+}
+
+static void collect_vars(struct ssa_builder *builder)
+{
+    size_t i, j;
+    struct tac_node *node;
+    struct cfg_block *block;
+    struct ssa_summary const *callee;
+
+    /* parameters must be known before anything else is taken as a global */
+    for (
+        node = builder->cfg.beginfun_node->next;
+        node != NULL && node->instruction.opcode == TAC_DEFP;
+        node = node->next
+    ) {
+        add_var(builder, node->instruction.dest, SSA_VAR_PARAM);
+    }
+
+    for (i = 0; i < builder->cfg.reverse_postorder_length; i++) {
+        block = &builder->cfg.blocks[builder->cfg.reverse_postorder[i]];
+        node = block->first;
+        for (;;) {
+            collect_use(builder, node->instruction.srcs[0], i);
+            collect_use(builder, node->instruction.srcs[1], i);
+            if (tac_defines_dest(node->instruction.opcode)) {
+                collect_def(builder, node->instruction.dest, i);
+            }
+            if (node == block->last) {
+                break;
+            }
+            node = node->next;
+        }
+    }
+
+    /* the loads at the entry and after calls define the globals */
+    for (i = 0; i < builder->var_count; i++) {
+        if (builder->vars[i].kind == SSA_VAR_GLOBAL) {
+            builder->vars[i].is_non_local = 1;
+            builder->vars[i].def_blocks = vector_push(
+                builder->vars[i].def_blocks,
+                sizeof(*builder->vars[i].def_blocks),
+                &builder->vars[i].def_block_count,
+                &builder->cfg.reverse_postorder[0]
+            );
+        }
+    }
+
+    /* globals are reloaded after calls that may write them */
+    for (i = 0; i < builder->cfg.block_count; i++) {
+        if (builder->cfg.blocks[i].postorder_index == CFG_NO_BLOCK) {
+            continue;
+        }
+        node = builder->cfg.blocks[i].first;
+        for (;;) {
+            if (node->instruction.opcode == TAC_CALL) {
+                callee = callee_summary(builder, node);
+                for (j = 0; j < builder->var_count; j++) {
+                    if (
+                        builder->vars[j].kind == SSA_VAR_GLOBAL
+                        && summary_writes(callee, builder->vars[j].symbol)
+                    ) {
+                        builder->vars[j].def_blocks = vector_push(
+                            builder->vars[j].def_blocks,
+                            sizeof(*builder->vars[j].def_blocks),
+                            &builder->vars[j].def_block_count,
+                            &i
+                        );
+                    }
+                }
+            }
+            if (node == builder->cfg.blocks[i].last) {
+                break;
+            }
+            node = node->next;
+        }
+    }
+}
+
+/*
+ * Blocks are visited in reverse postorder and identified by that position,
+ * so "defined_in" tells whether a variable was assigned earlier in the same
+ * block being scanned.
+ */
+static void collect_use(
+    struct ssa_builder *builder,
+    struct symbol *symbol,
+    size_t block
+)
+{
+    size_t var;
+
+    if (!is_ssa_candidate(symbol)) {
+        return;
+    }
+
+    var = find_var(builder, symbol);
+    if (var == SIZE_MAX) {
+        var = add_var(
+            builder,
+            symbol,
+            symbol->type == SYM_TMP_VAR ? SSA_VAR_TMP : SSA_VAR_GLOBAL
+        );
+    }
+
+    if (builder->vars[var].defined_in != block) {
+        builder->vars[var].is_non_local = 1;
+    }
+}
+
+static void collect_def(
+    struct ssa_builder *builder,
+    struct symbol *symbol,
+    size_t block
+)
+{
+    size_t var, block_index;
+
+    if (!is_ssa_candidate(symbol)) {
+        return;
+    }
+
+    var = find_var(builder, symbol);
+    if (var == SIZE_MAX) {
+        var = add_var(
+            builder,
+            symbol,
+            symbol->type == SYM_TMP_VAR ? SSA_VAR_TMP : SSA_VAR_GLOBAL
+        );
+    }
+
+    builder->vars[var].is_assigned = 1;
+    if (builder->vars[var].defined_in != block) {
+        builder->vars[var].defined_in = block;
+        block_index = builder->cfg.reverse_postorder[block];
+        builder->vars[var].def_blocks = vector_push(
+            builder->vars[var].def_blocks,
+            sizeof(*builder->vars[var].def_blocks),
+            &builder->vars[var].def_block_count,
+            &block_index
+        );
+    }
+}
+
+static void place_phis(struct ssa_builder *builder)
+{
+    size_t i, j, block, frontier, worklist_length;
+    size_t *worklist;
+    int *has_phi;
+    int *queued;
+    struct cfg_block *cfg_block;
+
+    has_phi = aborting_malloc(sizeof(*has_phi) * (builder->cfg.block_count + 1));
+    queued = aborting_malloc(sizeof(*queued) * (builder->cfg.block_count + 1));
+
+    for (i = 0; i < builder->var_count; i++) {
+        if (!builder->vars[i].is_non_local) {
+            continue;
+        }
+
+        for (j = 0; j < builder->cfg.block_count; j++) {
+            has_phi[j] = 0;
+            queued[j] = 0;
+        }
+
+        worklist = vector_empty(&worklist_length);
+        for (j = 0; j < builder->vars[i].def_block_count; j++) {
+            block = builder->vars[i].def_blocks[j];
+            if (!queued[block]) {
+                queued[block] = 1;
+                worklist = vector_push(
+                    worklist,
+                    sizeof(*worklist),
+                    &worklist_length,
+                    &block
+                );
+            }
+        }
+
+        while (worklist_length > 0) {
+            worklist = vector_pop(
+                worklist,
+                sizeof(*worklist),
+                &worklist_length,
+                &block
+            );
+            cfg_block = &builder->cfg.blocks[block];
+            for (j = 0; j < cfg_block->dominance_frontier_count; j++) {
+                frontier = cfg_block->dominance_frontier[j];
+                if (has_phi[frontier]) {
+                    continue;
+                }
+                has_phi[frontier] = 1;
+                insert_phi(builder, frontier, i);
+                if (!queued[frontier]) {
+                    queued[frontier] = 1;
+                    worklist = vector_push(
+                        worklist,
+                        sizeof(*worklist),
+                        &worklist_length,
+                        &frontier
+                    );
+                }
+            }
+        }
+
+        free(worklist);
+    }
+
+    free(has_phi);
+    free(queued);
+}
+
+static void insert_phi(struct ssa_builder *builder, size_t block, size_t var)
+{
+    size_t i;
+    struct tac_instruction instruction;
+    struct cfg_block *cfg_block;
+    struct ssa_phi phi;
+
+    cfg_block = &builder->cfg.blocks[block];
+
+    instruction.opcode = TAC_PHI;
+    instruction.dest = builder->vars[var].symbol;
+    instruction.srcs[0] = NULL;
+    instruction.srcs[1] = NULL;
+    instruction.phi_arg_count = cfg_block->predecessor_count;
+    instruction.phi_args = aborting_malloc(
+        sizeof(*instruction.phi_args) * (cfg_block->predecessor_count + 1)
+    );
+    for (i = 0; i < cfg_block->predecessor_count; i++) {
+        instruction.phi_args[i] = NULL;
+    }
+
+    /* only labeled blocks can have more than one predecessor */
+    if (cfg_block->first->instruction.opcode != TAC_LABEL) {
+        panic("phi placed in a block without label");
+    }
+    phi.node = tac_insert_after(builder->tac, cfg_block->first, instruction);
+    if (cfg_block->last == cfg_block->first) {
+        cfg_block->last = phi.node;
+    }
+
+    phi.var = var;
+    builder->blocks[block].phis = vector_push(
+        builder->blocks[block].phis,
+        sizeof(*builder->blocks[block].phis),
+        &builder->blocks[block].phi_count,
+        &phi
+    );
+}
+
+static void rename_block(struct ssa_builder *builder, size_t block)
+{
+    size_t i, var, pushed_length;
+    size_t *pushed;
+    int entry_loads_pending;
+    struct symbol *defined;
+    struct tac_node *node;
+    struct cfg_block *cfg_block;
+    struct ssa_summary const *callee;
+
+    cfg_block = &builder->cfg.blocks[block];
+    pushed = vector_empty(&pushed_length);
+    entry_loads_pending = block == 0;
+
+    node = cfg_block->first;
+    for (;;) {
+        if (
+            entry_loads_pending
+            && node->instruction.opcode != TAC_LABEL
+            && node->instruction.opcode != TAC_DEFP
+        ) {
+            entry_loads_pending = 0;
+            insert_global_loads(
+                builder,
+                block,
+                node->prev,
+                NULL,
+                NULL,
+                &pushed,
+                &pushed_length
+            );
+        }
+
+        switch (node->instruction.opcode) {
+            case TAC_PHI:
+                var = find_var(builder, node->instruction.dest);
+                node->instruction.dest =
+                    push_version(builder, var, &pushed, &pushed_length);
+                break;
+
+            case TAC_DEFP:
+                var = find_var(builder, node->instruction.dest);
+                builder->vars[var].stack = vector_push(
+                    builder->vars[var].stack,
+                    sizeof(*builder->vars[var].stack),
+                    &builder->vars[var].stack_length,
+                    &node->instruction.dest
+                );
+                pushed = vector_push(
+                    pushed,
+                    sizeof(*pushed),
+                    &pushed_length,
+                    &var
+                );
+                break;
+
+            default:
+                node->instruction.srcs[0] =
+                    rename_use(builder, node->instruction.srcs[0]);
+                node->instruction.srcs[1] =
+                    rename_use(builder, node->instruction.srcs[1]);
+
+                callee = NULL;
+                if (node->instruction.opcode == TAC_CALL) {
+                    callee = callee_summary(builder, node);
+                    insert_global_stores(builder, node, callee);
+                } else if (node->instruction.opcode == TAC_RET) {
+                    insert_global_stores(builder, node, NULL);
+                }
+
+                /* a call may assign its result directly to a global */
+                defined = node->instruction.dest;
+                if (
+                    tac_defines_dest(node->instruction.opcode)
+                    && is_ssa_candidate(node->instruction.dest)
+                ) {
+                    var = find_var(builder, node->instruction.dest);
+                    node->instruction.dest =
+                        push_version(builder, var, &pushed, &pushed_length);
+                }
+
+                if (node->instruction.opcode == TAC_CALL) {
+                    node = insert_global_loads(
+                        builder,
+                        block,
+                        node,
+                        defined,
+                        callee,
+                        &pushed,
+                        &pushed_length
+                    );
+                }
+                break;
+        }
+
+        if (node == cfg_block->last) {
+            break;
+        }
+        node = node->next;
+    }
+
+    if (entry_loads_pending) {
+        insert_global_loads(
+            builder,
+            block,
+            cfg_block->last,
+            NULL,
+            NULL,
+            &pushed,
+            &pushed_length
+        );
+    }
+
+    fill_successor_phis(builder, block);
+
+    for (i = 0; i < cfg_block->dominated_count; i++) {
+        rename_block(builder, cfg_block->dominated[i]);
+    }
+
+    for (i = 0; i < pushed_length; i++) {
+        builder->vars[pushed[i]].stack = vector_pop(
+            builder->vars[pushed[i]].stack,
+            sizeof(*builder->vars[pushed[i]].stack),
+            &builder->vars[pushed[i]].stack_length,
+            &node
+        );
+    }
+    free(pushed);
+}
+
+static struct symbol *rename_use(
+    struct ssa_builder *builder,
+    struct symbol *symbol
+)
+{
+    size_t var;
+    struct symbol *version;
+
+    if (!is_ssa_candidate(symbol)) {
+        return symbol;
+    }
+
+    var = find_var(builder, symbol);
+    if (var == SIZE_MAX) {
+        return symbol;
+    }
+
+    version = top_version(builder, var);
+    return version != NULL ? version : symbol;
+}
+
+static struct symbol *push_version(
+    struct ssa_builder *builder,
+    size_t var,
+    size_t **pushed,
+    size_t *pushed_length
+)
+{
+    struct symbol *version;
+
+    version = symbol_table_create_tmp_scalar_var(
+        builder->vars[var].symbol->data.variable.type
+    );
+    builder->vars[var].stack = vector_push(
+        builder->vars[var].stack,
+        sizeof(*builder->vars[var].stack),
+        &builder->vars[var].stack_length,
+        &version
+    );
+    *pushed = vector_push(*pushed, sizeof(**pushed), pushed_length, &var);
+    return version;
+}
+
+static struct symbol *top_version(struct ssa_builder *builder, size_t var)
+{
+    if (builder->vars[var].stack_length == 0) {
+        return NULL;
+    }
+    return builder->vars[var].stack[builder->vars[var].stack_length - 1];
+}
+
+/*
+ * A global whose current version was loaded from memory and not reassigned
+ * since then is still in sync with memory, so it needs no store. Neither does
+ * a global the callee never accesses.
+ */
+static void insert_global_stores(
+    struct ssa_builder *builder,
+    struct tac_node *before,
+    struct ssa_summary const *callee
+)
+{
+    size_t i;
+    struct symbol *version;
+    struct tac_node *store;
+    struct tac_instruction instruction;
+
+    for (i = 0; i < builder->var_count; i++) {
+        if (
+            builder->vars[i].kind != SSA_VAR_GLOBAL
+            || !builder->vars[i].is_assigned
+            || (
+                !summary_reads(callee, builder->vars[i].symbol)
+                && !summary_writes(callee, builder->vars[i].symbol)
+            )
+        ) {
+            continue;
+        }
+        version = top_version(builder, i);
+        if (version == NULL || is_load_version(builder, version)) {
+            continue;
+        }
+        instruction.opcode = TAC_MOVE;
+        instruction.dest = builder->vars[i].symbol;
+        instruction.srcs[0] = version;
+        instruction.srcs[1] = NULL;
+        store = tac_insert_before(builder->tac, before, instruction);
+        builder->stores = vector_push(
+            builder->stores,
+            sizeof(*builder->stores),
+            &builder->store_count,
+            &store
+        );
+    }
+}
+
+static struct tac_node *insert_global_loads(
+    struct ssa_builder *builder,
+    size_t block,
+    struct tac_node *after,
+    struct symbol *skipped,
+    struct ssa_summary const *callee,
+    size_t **pushed,
+    size_t *pushed_length
+)
+{
+    size_t i;
+    struct tac_instruction instruction;
+    struct cfg_block *cfg_block;
+
+    cfg_block = &builder->cfg.blocks[block];
+
+    for (i = 0; i < builder->var_count; i++) {
+        if (
+            builder->vars[i].kind != SSA_VAR_GLOBAL
+            || builder->vars[i].symbol == skipped
+            || !summary_writes(callee, builder->vars[i].symbol)
+        ) {
+            continue;
+        }
+        instruction.opcode = TAC_MOVE;
+        instruction.dest = push_version(builder, i, pushed, pushed_length);
+        instruction.srcs[0] = builder->vars[i].symbol;
+        instruction.srcs[1] = NULL;
+        builder->loads = vector_push(
+            builder->loads,
+            sizeof(*builder->loads),
+            &builder->load_count,
+            &instruction.dest
+        );
+        if (after == cfg_block->last) {
+            after = tac_insert_after(builder->tac, after, instruction);
+            cfg_block->last = after;
+        } else {
+            after = tac_insert_after(builder->tac, after, instruction);
+        }
+    }
+
+    return after;
+}
+
+static int is_load_version(struct ssa_builder *builder, struct symbol *symbol)
+{
+    size_t i;
+
+    for (i = builder->load_count; i > 0; i--) {
+        if (builder->loads[i - 1] == symbol) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Stores are inserted before the phi arguments coming from back edges are
+ * known, so some stores of phi versions only write what memory already holds.
+ * A phi is in sync with memory if all of its arguments are, which is solved
+ * optimistically for loops: every phi of a global starts in sync until one of
+ * its arguments is shown not to be.
+ */
+static void remove_synced_stores(struct ssa_builder *builder)
+{
+    size_t i, j, k, phi_count;
+    int changed;
+    struct synced_phi *phis;
+    struct synced_phi phi;
+    struct tac_node *node;
+
+    phis = vector_empty(&phi_count);
+    for (i = 0; i < builder->cfg.block_count; i++) {
+        for (j = 0; j < builder->blocks[i].phi_count; j++) {
+            if (
+                builder->vars[builder->blocks[i].phis[j].var].kind
+                == SSA_VAR_GLOBAL
+            ) {
+                phi.node = builder->blocks[i].phis[j].node;
+                phi.is_synced = 1;
+                phis = vector_push(phis, sizeof(*phis), &phi_count, &phi);
+            }
+        }
+    }
+
+    do {
+        changed = 0;
+        for (i = 0; i < phi_count; i++) {
+            if (!phis[i].is_synced) {
+                continue;
+            }
+            node = phis[i].node;
+            for (k = 0; k < node->instruction.phi_arg_count; k++) {
+                if (
+                    node->instruction.phi_args[k] != NULL
+                    && !is_synced_version(
+                        builder,
+                        phi_count,
+                        phis,
+                        node->instruction.phi_args[k]
+                    )
+                ) {
+                    phis[i].is_synced = 0;
+                    changed = 1;
+                    break;
+                }
+            }
+        }
+    } while (changed);
+
+    for (i = 0; i < builder->store_count; i++) {
+        if (
+            is_synced_version(
+                builder,
+                phi_count,
+                phis,
+                builder->stores[i]->instruction.srcs[0]
+            )
+        ) {
+            tac_remove(builder->tac, builder->stores[i]);
+        }
+    }
+
+    free(phis);
+}
+
+static int is_synced_version(
+    struct ssa_builder *builder,
+    size_t phi_count,
+    struct synced_phi *phis,
+    struct symbol *symbol
+)
+{
+    size_t i;
+
+    if (is_load_version(builder, symbol)) {
+        return 1;
+    }
+
+    for (i = 0; i < phi_count; i++) {
+        if (phis[i].node->instruction.dest == symbol) {
+            return phis[i].is_synced;
+        }
+    }
+
+    return 0;
+}
+
+static void fill_successor_phis(struct ssa_builder *builder, size_t block)
+{
+    size_t i, j, predecessor_index, successor;
+    struct symbol *version;
+    struct cfg_block *cfg_block;
+    struct ssa_phi *phi;
+
+    cfg_block = &builder->cfg.blocks[block];
+
+    for (i = 0; i < cfg_block->successor_count; i++) {
+        successor = cfg_block->successors[i];
+
+        predecessor_index = 0;
+        while (
+            builder->cfg.blocks[successor].predecessors[predecessor_index]
+            != block
+        ) {
+            predecessor_index++;
+        }
+
+        for (j = 0; j < builder->blocks[successor].phi_count; j++) {
+            phi = &builder->blocks[successor].phis[j];
+            version = top_version(builder, phi->var);
+            if (version == NULL) {
+                version = builder->vars[phi->var].symbol;
+            }
+            phi->node->instruction.phi_args[predecessor_index] = version;
+        }
+    }
+}
+
+static void builder_free(struct ssa_builder *builder)
+{
+    size_t i;
+
+    for (i = 0; i < builder->var_count; i++) {
+        free(builder->vars[i].def_blocks);
+        free(builder->vars[i].stack);
+    }
+    for (i = 0; i < builder->cfg.block_count; i++) {
+        free(builder->blocks[i].phis);
+    }
+    free(builder->vars);
+    free(builder->loads);
+    free(builder->stores);
+    free(builder->blocks);
+    cfg_free(builder->cfg);
+}
+
+static struct tac_node *destruct_function(
+    struct tac *tac,
+    struct tac_node *beginfun_node
+)
+{
+    size_t i, j;
+    struct cfg cfg;
+    struct tac_node *node;
+    struct tac_node *endfun_node;
+    struct symbol *incoming;
+    struct tac_instruction instruction;
+    struct cfg_block *block;
+
+    cfg = cfg_build(beginfun_node);
+
+    for (i = 0; i < cfg.block_count; i++) {
+        block = &cfg.blocks[i];
+        for (
+            node = block->first;
+            node != block->last->next
+                && (
+                    node->instruction.opcode == TAC_LABEL
+                    || node->instruction.opcode == TAC_PHI
+                );
+            node = node->next
+        ) {
+            if (node->instruction.opcode != TAC_PHI) {
+                continue;
+            }
+
+            incoming = symbol_table_create_tmp_scalar_var(
+                node->instruction.dest->data.variable.type
+            );
+            for (j = 0; j < node->instruction.phi_arg_count; j++) {
+                if (node->instruction.phi_args[j] == NULL) {
+                    continue;
+                }
+                instruction.opcode = TAC_MOVE;
+                instruction.dest = incoming;
+                instruction.srcs[0] = node->instruction.phi_args[j];
+                instruction.srcs[1] = NULL;
+                insert_at_block_end(
+                    tac,
+                    &cfg.blocks[block->predecessors[j]],
+                    instruction
+                );
+            }
+
+            free(node->instruction.phi_args);
+            node->instruction.opcode = TAC_MOVE;
+            node->instruction.srcs[0] = incoming;
+            node->instruction.srcs[1] = NULL;
+        }
+    }
+
+    endfun_node = cfg.endfun_node;
+    cfg_free(cfg);
+    coalesce_copies(tac, beginfun_node);
+    remove_unused_labels(tac, beginfun_node);
+    return endfun_node;
+}
+
+/*
+ * Copies go before the jump ending the block, if any. The copied-into
+ * temporaries are only read by the phi's block, so it does not matter that a
+ * conditional jump also runs them on its other edge.
+ */
+static void insert_at_block_end(
+    struct tac *tac,
+    struct cfg_block *block,
+    struct tac_instruction instruction
+)
+{
+    switch (block->last->instruction.opcode) {
+        case TAC_JUMP:
+        case TAC_IFZ:
+            tac_insert_before(tac, block->last, instruction);
+            break;
+        default:
+            block->last = tac_insert_after(tac, block->last, instruction);
+            break;
+    }
+}
+
+static void remove_unused_labels(
+    struct tac *tac,
+    struct tac_node *beginfun_node
+)
+{
+    size_t target_count;
+    struct symbol **targets;
+    struct tac_node *node;
+    struct tac_node *next;
+
+    targets = vector_empty(&target_count);
+    for (
+        node = beginfun_node;
+        node->instruction.opcode != TAC_ENDFUN;
+        node = node->next
+    ) {
+        if (
+            node->instruction.opcode == TAC_JUMP
+            || node->instruction.opcode == TAC_IFZ
+        ) {
+            add_to_set(&targets, &target_count, node->instruction.dest);
+        }
+    }
+
+    for (
+        node = beginfun_node;
+        node->instruction.opcode != TAC_ENDFUN;
+        node = next
+    ) {
+        next = node->next;
+        if (
+            node->instruction.opcode == TAC_LABEL
+            && !set_contains(targets, target_count, node->instruction.srcs[0])
+        ) {
+            tac_remove(tac, node);
+        }
+    }
+
+    free(targets);
+}
+
+/*
+ * Gives the same name to temporaries related by a copy whenever their
+ * lifetimes do not overlap, and removes the copies this makes redundant. This
+ * undoes most of the copies leaving SSA form introduces.
+ */
+static void coalesce_copies(struct tac *tac, struct tac_node *beginfun_node)
+{
+    size_t i;
+    struct tac_node *node;
+    struct coalescer coalescer;
+
+    coalescer.cfg = cfg_build(beginfun_node);
+    coalescer.tmps = vector_empty(&coalescer.tmp_count);
+
+    for (
+        node = beginfun_node->next;
+        node->instruction.opcode != TAC_ENDFUN;
+        node = node->next
+    ) {
+        if (node->instruction.opcode != TAC_LABEL) {
+            coalescer_number(&coalescer, node->instruction.dest);
+            coalescer_number(&coalescer, node->instruction.srcs[0]);
+            coalescer_number(&coalescer, node->instruction.srcs[1]);
+        }
+    }
+
+    coalescer.word_count =
+        (coalescer.tmp_count + BITS_PER_WORD - 1) / BITS_PER_WORD;
+    coalescer.live_out = aborting_malloc(
+        sizeof(*coalescer.live_out)
+            * (coalescer.cfg.block_count * coalescer.word_count + 1)
+    );
+    coalescer.interference = aborting_malloc(
+        sizeof(*coalescer.interference)
+            * (coalescer.tmp_count * coalescer.word_count + 1)
+    );
+    coalescer.parents = aborting_malloc(
+        sizeof(*coalescer.parents) * (coalescer.tmp_count + 1)
+    );
+    for (i = 0; i < coalescer.tmp_count; i++) {
+        coalescer.parents[i] = i;
+    }
+
+    coalescer_liveness(&coalescer);
+    coalescer_interference(&coalescer);
+    coalescer_merge(&coalescer);
+    cfg_free(coalescer.cfg);
+    coalescer_rewrite(&coalescer, tac, beginfun_node);
+
+    free(coalescer.tmps);
+    free(coalescer.live_out);
+    free(coalescer.interference);
+    free(coalescer.parents);
+}
+
+static size_t coalescer_index(struct coalescer *coalescer, struct symbol *symbol)
+{
+    size_t index;
+
+    if (symbol == NULL || symbol->type != SYM_TMP_VAR) {
+        return SIZE_MAX;
+    }
+
+    index = symbol->data.variable.ssa_index;
+    if (index < coalescer->tmp_count && coalescer->tmps[index] == symbol) {
+        return index;
+    }
+    return SIZE_MAX;
+}
+
+static void coalescer_number(struct coalescer *coalescer, struct symbol *symbol)
+{
+    if (
+        symbol == NULL
+        || symbol->type != SYM_TMP_VAR
+        || coalescer_index(coalescer, symbol) != SIZE_MAX
+    ) {
+        return;
+    }
+
+    symbol->data.variable.ssa_index = coalescer->tmp_count;
+    coalescer->tmps = vector_push(
+        coalescer->tmps,
+        sizeof(*coalescer->tmps),
+        &coalescer->tmp_count,
+        &symbol
+    );
+}
+
+/*
+ * Turns the set of temporaries live after the node into the set of those
+ * live before it.
+ */
+static void coalescer_transfer(
+    struct coalescer *coalescer,
+    struct tac_node *node,
+    unsigned long *live
+)
+{
+    size_t index;
+
+    if (node->instruction.opcode == TAC_LABEL) {
+        return;
+    }
+
+    if (tac_defines_dest(node->instruction.opcode)) {
+        index = coalescer_index(coalescer, node->instruction.dest);
+        if (index != SIZE_MAX) {
+            bit_clear(live, index);
+        }
+    }
+
+    index = coalescer_index(coalescer, node->instruction.srcs[0]);
+    if (index != SIZE_MAX) {
+        bit_set(live, index);
+    }
+    index = coalescer_index(coalescer, node->instruction.srcs[1]);
+    if (index != SIZE_MAX) {
+        bit_set(live, index);
+    }
+}
+
+static void coalescer_liveness(struct coalescer *coalescer)
+{
+    size_t i, j, k, word_count;
+    int changed;
+    unsigned long *live;
+    unsigned long *out;
+    struct tac_node *node;
+    struct cfg_block *block;
+
+    word_count = coalescer->word_count;
+    live = aborting_malloc(sizeof(*live) * (word_count + 1));
+    memset(
+        coalescer->live_out,
+        0,
+        sizeof(*coalescer->live_out) * coalescer->cfg.block_count * word_count
+    );
+
+    do {
+        changed = 0;
+        for (i = coalescer->cfg.block_count; i > 0; i--) {
+            block = &coalescer->cfg.blocks[i - 1];
+            memcpy(
+                live,
+                &coalescer->live_out[(i - 1) * word_count],
+                sizeof(*live) * word_count
+            );
+            node = block->last;
+            for (;;) {
+                coalescer_transfer(coalescer, node, live);
+                if (node == block->first) {
+                    break;
+                }
+                node = node->prev;
+            }
+
+            for (j = 0; j < block->predecessor_count; j++) {
+                out = &coalescer->live_out[
+                    block->predecessors[j] * word_count
+                ];
+                for (k = 0; k < word_count; k++) {
+                    if ((out[k] | live[k]) != out[k]) {
+                        out[k] |= live[k];
+                        changed = 1;
+                    }
+                }
+            }
+        }
+    } while (changed);
+
+    free(live);
+}
+
+/*
+ * A definition interferes with everything live right after it, except with
+ * the source of a copy, which holds the same value.
+ */
+static void coalescer_interference(struct coalescer *coalescer)
+{
+    size_t i, j, dest, source, word_count;
+    unsigned long *live;
+    struct tac_node *node;
+    struct cfg_block *block;
+
+    word_count = coalescer->word_count;
+    live = aborting_malloc(sizeof(*live) * (word_count + 1));
+    memset(
+        coalescer->interference,
+        0,
+        sizeof(*coalescer->interference) * coalescer->tmp_count * word_count
+    );
+
+    for (i = 0; i < coalescer->cfg.block_count; i++) {
+        block = &coalescer->cfg.blocks[i];
+        memcpy(
+            live,
+            &coalescer->live_out[i * word_count],
+            sizeof(*live) * word_count
+        );
+        node = block->last;
+        for (;;) {
+            dest = tac_defines_dest(node->instruction.opcode)
+                ? coalescer_index(coalescer, node->instruction.dest)
+                : SIZE_MAX;
+            if (dest != SIZE_MAX) {
+                source = node->instruction.opcode == TAC_MOVE
+                    ? coalescer_index(coalescer, node->instruction.srcs[0])
+                    : SIZE_MAX;
+                for (j = 0; j < coalescer->tmp_count; j++) {
+                    if (bit_test(live, j) && j != dest && j != source) {
+                        bit_set(
+                            &coalescer->interference[dest * word_count],
+                            j
+                        );
+                        bit_set(
+                            &coalescer->interference[j * word_count],
+                            dest
+                        );
+                    }
+                }
+            }
+            coalescer_transfer(coalescer, node, live);
+            if (node == block->first) {
+                break;
+            }
+            node = node->prev;
+        }
+    }
+
+    free(live);
+}
+
+/*
+ * Copies in deeper loops are merged first, since they run more often. The
+ * interference rows of merged classes are kept up to date for the class
+ * representatives.
+ */
+static void coalescer_merge(struct coalescer *coalescer)
+{
+    size_t i, j, k, depth, max_depth, dest, source, word_count;
+    struct tac_node *node;
+    struct cfg_block *block;
+    unsigned long *dest_row;
+    unsigned long *source_row;
+
+    word_count = coalescer->word_count;
+
+    max_depth = 0;
+    for (i = 0; i < coalescer->cfg.block_count; i++) {
+        if (coalescer->cfg.blocks[i].loop_depth > max_depth) {
+            max_depth = coalescer->cfg.blocks[i].loop_depth;
+        }
+    }
+
+    for (depth = max_depth + 1; depth > 0; depth--) {
+        for (i = 0; i < coalescer->cfg.block_count; i++) {
+            block = &coalescer->cfg.blocks[i];
+            if (block->loop_depth != depth - 1) {
+                continue;
+            }
+            node = block->first;
+            for (;;) {
+                if (node->instruction.opcode == TAC_MOVE) {
+                    dest = coalescer_index(coalescer, node->instruction.dest);
+                    source = coalescer_index(
+                        coalescer,
+                        node->instruction.srcs[0]
+                    );
+                    if (
+                        dest != SIZE_MAX
+                        && source != SIZE_MAX
+                        && node->instruction.dest->data.variable.type
+                            == node->instruction.srcs[0]->data.variable.type
+                    ) {
+                        dest = coalescer_find(coalescer, dest);
+                        source = coalescer_find(coalescer, source);
+                        dest_row = &coalescer->interference[dest * word_count];
+                        source_row =
+                            &coalescer->interference[source * word_count];
+                        if (dest != source && !bit_test(dest_row, source)) {
+                            coalescer->parents[source] = dest;
+                            for (j = 0; j < word_count; j++) {
+                                dest_row[j] |= source_row[j];
+                            }
+                            for (k = 0; k < coalescer->tmp_count; k++) {
+                                if (bit_test(source_row, k)) {
+                                    bit_set(
+                                        &coalescer->interference[
+                                            k * word_count
+                                        ],
+                                        dest
+                                    );
+                                }
+                            }
+                        }
+                    }
+                }
+                if (node == block->last) {
+                    break;
+                }
+                node = node->next;
+            }
+        }
+    }
+}
+
+static size_t coalescer_find(struct coalescer *coalescer, size_t index)
+{
+    while (coalescer->parents[index] != index) {
+        coalescer->parents[index] =
+            coalescer->parents[coalescer->parents[index]];
+        index = coalescer->parents[index];
+    }
+    return index;
+}
+
+static void coalescer_rewrite(
+    struct coalescer *coalescer,
+    struct tac *tac,
+    struct tac_node *beginfun_node
+)
+{
+    struct tac_node *node;
+    struct tac_node *next;
+
+    for (
+        node = beginfun_node->next;
+        node->instruction.opcode != TAC_ENDFUN;
+        node = next
+    ) {
+        next = node->next;
+        if (node->instruction.opcode == TAC_LABEL) {
+            continue;
+        }
+        node->instruction.dest =
+            coalescer_rename(coalescer, node->instruction.dest);
+        node->instruction.srcs[0] =
+            coalescer_rename(coalescer, node->instruction.srcs[0]);
+        node->instruction.srcs[1] =
+            coalescer_rename(coalescer, node->instruction.srcs[1]);
+        if (
+            node->instruction.opcode == TAC_MOVE
+            && node->instruction.dest == node->instruction.srcs[0]
+        ) {
+            tac_remove(tac, node);
+        }
+    }
+}
+
+static struct symbol *coalescer_rename(
+    struct coalescer *coalescer,
+    struct symbol *symbol
+)
+{
+    size_t index;
+
+    index = coalescer_index(coalescer, symbol);
+    if (index == SIZE_MAX) {
+        return symbol;
+    }
+    return coalescer->tmps[coalescer_find(coalescer, index)];
+}
+
+static int bit_test(unsigned long const *row, size_t index)
+{
+    return (row[index / BITS_PER_WORD] >> (index % BITS_PER_WORD)) & 1;
+}
+
+static void bit_set(unsigned long *row, size_t index)
+{
+    row[index / BITS_PER_WORD] |= 1UL << (index % BITS_PER_WORD);
+}
+
+static void bit_clear(unsigned long *row, size_t index)
+{
+    row[index / BITS_PER_WORD] &= ~(1UL << (index % BITS_PER_WORD));
+}
@@ -0,0 +1,27 @@
+#ifndef SSA_H_
+#define SSA_H_ 1
+
+#include "tac.h"
+
+/**
+ * Puts every function of the TAC in semi-pruned SSA form: each
+ * temporary, parameter and scalar global gets one new temporary per
+ * assignment, and .phi nodes are placed on the dominance frontiers of the
+ * assignments.
+ *
+ * Scalar globals are kept in temporaries inside a function: they are loaded
+ * at the function entry and after each call that may write them, and stored
+ * back before each return and before each call that may access them, so
+ * callees still observe them.
+ */
+void ssa_construct(struct tac *tac);
+
+/**
+ * Replaces every .phi node by copies: a copy of each argument into a fresh
+ * temporary at the end of the corresponding predecessor, and a copy of that
+ * temporary into the phi's destination where the phi was. Copies between
+ * temporaries that do not interfere are then coalesced away.
+ */
+void ssa_destruct(struct tac *tac);
+
+#endif
@@ -53,6 +53,8 @@ void symbol_table_free(void)
                 case SYM_UNKNOWN_IDENT:
                 case SYM_SCALAR_VAR:
                 case SYM_TMP_VAR:
+                case SYM_TMP_VECTOR_VAR:
+                case SYM_TMP_PACKED_VAR:
                 case SYM_VECTOR_VAR:
                 case SYM_LIT_INT:
                 case SYM_LIT_FLOAT:
@@ -167,6 +169,8 @@ char const *symbol_type_to_str(enum symbol_type type)
         case SYM_VECTOR_VAR: return "vector variable";
         case SYM_FUNCTION: return "function identifier";
         case SYM_TMP_VAR: return "temporary scalar variable";
+        case SYM_TMP_VECTOR_VAR: return "temporary vector variable";
+        case SYM_TMP_PACKED_VAR: return "temporary packed variable";
     }
     panic("symbol type %i's to string not implemented", type);
 }
@@ -183,6 +187,49 @@ struct symbol *symbol_table_create_tmp_scalar_var(enum datatype datatype)
     symbol->type = SYM_TMP_VAR;
     symbol->data.variable.type = datatype;
     symbol->data.variable.stack_frame_index = SIZE_MAX;
+    symbol->data.variable.register_index = SIZE_MAX;
+    symbol->data.variable.ssa_index = SIZE_MAX;
+    return symbol;
+}
+
+struct symbol *symbol_table_create_tmp_vector_var(
+    enum datatype datatype,
+    size_t length
+)
+{
+    static unsigned long id = 0;
+    struct symbol *symbol;
+    char buf[100];
+
+    snprintf(buf, sizeof(buf), "@vector_%lu", id);
+    id++;
+    symbol = symbol_table_insert(buf);
+    symbol->type = SYM_TMP_VECTOR_VAR;
+    symbol->data.variable.type = datatype;
+    symbol->data.variable.stack_frame_index = SIZE_MAX;
+    symbol->data.variable.register_index = SIZE_MAX;
+    symbol->data.variable.ssa_index = SIZE_MAX;
+    symbol->data.variable.length = length;
+    return symbol;
+}
+
+struct symbol *symbol_table_create_tmp_packed_var(
+    enum datatype datatype,
+    size_t register_index
+)
+{
+    static unsigned long id = 0;
+    struct symbol *symbol;
+    char buf[100];
+
+    snprintf(buf, sizeof(buf), "@packed_%lu", id);
+    id++;
+    symbol = symbol_table_insert(buf);
+    symbol->type = SYM_TMP_PACKED_VAR;
+    symbol->data.variable.type = datatype;
+    symbol->data.variable.stack_frame_index = SIZE_MAX;
+    symbol->data.variable.register_index = register_index;
+    symbol->data.variable.ssa_index = SIZE_MAX;
     return symbol;
 }
 
@@ -357,6 +404,8 @@ int symbol_cmp(struct symbol *left, struct symbol *right)
             return cmp;
         case SYM_UNKNOWN_IDENT:
         case SYM_TMP_VAR:
+        case SYM_TMP_VECTOR_VAR:
+        case SYM_TMP_PACKED_VAR:
         case SYM_SCALAR_VAR:
         case SYM_VECTOR_VAR:
         case SYM_FUNCTION:
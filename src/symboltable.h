@@ -14,6 +14,8 @@ enum symbol_type {
     SYM_LIT_STR,
     SYM_UNKNOWN_IDENT,
     SYM_TMP_VAR,
+    SYM_TMP_VECTOR_VAR,
+    SYM_TMP_PACKED_VAR,
     SYM_SCALAR_VAR,
     SYM_VECTOR_VAR,
     SYM_FUNCTION,
@@ -27,8 +29,12 @@ enum symbol_type {
 struct sym_var_data {
     enum datatype type;
     size_t stack_frame_index;
+    size_t register_index;
+    size_t ssa_index;
     int in_scope;
     struct symbol *replacement;
+    /* element count, only for temporary vectors */
+    size_t length;
 };
 
 struct str_lit_data {
@@ -68,6 +74,17 @@ char const *symbol_type_to_str(enum symbol_type type);
 /* makeTemp */
 struct symbol *symbol_table_create_tmp_scalar_var(enum datatype datatype);
 
+struct symbol *symbol_table_create_tmp_vector_var(
+    enum datatype datatype,
+    size_t length
+);
+
+/* register_index is the packed register the temporary takes */
+struct symbol *symbol_table_create_tmp_packed_var(
+    enum datatype datatype,
+    size_t register_index
+);
+
 /* makeLabel */
 struct symbol *symbol_table_create_tmp_label(void);
 
@@ -24,6 +24,11 @@ static void compute_ids(struct tac *tac);
 
 static void compute_local_values(struct tac *tac);
 
+static int is_redefinition(
+    struct tac_node *node,
+    struct tac_local_value *local_value
+);
+
 static int opcode_needs_indent(enum tac_opcode opcode);
 
 static int opcode_needs_colon(enum tac_opcode opcode);
@@ -48,9 +53,15 @@ char const *tac_opcode_mnemonic(enum tac_opcode opcode)
         case TAC_NE: return "ne";
         case TAC_SHMUL: return "shmul";
         case TAC_SHDIV: return "shdiv";
+        case TAC_MHDIV: return "mhdiv";
         case TAC_AND: return "and";
         case TAC_OR: return "or";
+        case TAC_XOR: return "xor";
+        case TAC_SHL: return "shl";
+        case TAC_SAR: return "sar";
+        case TAC_ROL: return "rol";
         case TAC_NOT: return "not";
+        case TAC_COMPL: return "compl";
         case TAC_LABEL: return "";
         case TAC_DEFS: return ".defs";
         case TAC_DEFV: return ".defv";
@@ -66,6 +77,21 @@ char const *tac_opcode_mnemonic(enum tac_opcode opcode)
         case TAC_RET: return "ret";
         case TAC_PRINT: return "print";
         case TAC_READ: return "read";
+        case TAC_PLOAD: return "pload";
+        case TAC_PSTORE: return "pstore";
+        case TAC_PSPLAT: return "psplat";
+        case TAC_PADD: return "padd";
+        case TAC_PSUB: return "psub";
+        case TAC_PMUL: return "pmul";
+        case TAC_PDIV: return "pdiv";
+        case TAC_PAND: return "pand";
+        case TAC_POR: return "por";
+        case TAC_PXOR: return "pxor";
+        case TAC_PSUM: return "psum";
+        case TAC_REP: return "rep";
+        case TAC_FILL: return "fill";
+        case TAC_COPY: return "copy";
+        case TAC_PHI: return "phi";
     }
     panic("TAC opcode %i's mnemonic not implemented", opcode);
 }
@@ -88,9 +114,15 @@ char const *tac_opcode_raw_mnemonic(enum tac_opcode opcode)
         case TAC_NE: return "TAC_NE";
         case TAC_SHMUL: return "TAC_SHMUL";
         case TAC_SHDIV: return "TAC_SHDIV";
+        case TAC_MHDIV: return "TAC_MHDIV";
         case TAC_AND: return "TAC_AND";
         case TAC_OR: return "TAC_OR";
+        case TAC_XOR: return "TAC_XOR";
+        case TAC_SHL: return "TAC_SHL";
+        case TAC_SAR: return "TAC_SAR";
+        case TAC_ROL: return "TAC_ROL";
         case TAC_NOT: return "TAC_NOT";
+        case TAC_COMPL: return "TAC_COMPL";
         case TAC_LABEL: return "TAC_LABEL";
         case TAC_DEFS: return "TAC_DEFS";
         case TAC_DEFV: return "TAC_DEFV";
@@ -106,6 +138,21 @@ char const *tac_opcode_raw_mnemonic(enum tac_opcode opcode)
         case TAC_RET: return "TAC_RET";
         case TAC_PRINT: return "TAC_PRINT";
         case TAC_READ: return "TAC_READ";
+        case TAC_PLOAD: return "TAC_PLOAD";
+        case TAC_PSTORE: return "TAC_PSTORE";
+        case TAC_PSPLAT: return "TAC_PSPLAT";
+        case TAC_PADD: return "TAC_PADD";
+        case TAC_PSUB: return "TAC_PSUB";
+        case TAC_PMUL: return "TAC_PMUL";
+        case TAC_PDIV: return "TAC_PDIV";
+        case TAC_PAND: return "TAC_PAND";
+        case TAC_POR: return "TAC_POR";
+        case TAC_PXOR: return "TAC_PXOR";
+        case TAC_PSUM: return "TAC_PSUM";
+        case TAC_REP: return "TAC_REP";
+        case TAC_FILL: return "TAC_FILL";
+        case TAC_COPY: return "TAC_COPY";
+        case TAC_PHI: return "TAC_PHI";
     }
     panic("TAC opcode %i's raw debug mnemonic not implemented", opcode);
 }
@@ -115,6 +162,8 @@ void tac_instruction_print(
     struct tac_render_params params
 )
 {
+    size_t i;
+
     if (opcode_needs_indent(instruction.opcode)) {
         write_indent(params);
     }
@@ -138,6 +187,18 @@ void tac_instruction_print(
         fprintf(params.output, " %s", instruction.srcs[1]->content);
     }
 
+    if (instruction.opcode == TAC_PHI) {
+        for (i = 0; i < instruction.phi_arg_count; i++) {
+            fprintf(
+                params.output,
+                ", %s",
+                instruction.phi_args[i] != NULL
+                    ? instruction.phi_args[i]->content
+                    : "@0"
+            );
+        }
+    }
+
     if (opcode_needs_colon(instruction.opcode)) {
         fputc(':', params.output);
     }
@@ -237,6 +298,57 @@ int tac_pop(struct tac *tac, struct tac_instruction *output)
     return 0;
 }
 
+struct tac_node *tac_insert_before(
+    struct tac *tac,
+    struct tac_node *next,
+    struct tac_instruction instruction
+)
+{
+    struct tac_node *node = tac_create_node(instruction);
+    node->next = next;
+    node->prev = next->prev;
+    if (next->prev == NULL) {
+        tac->first = node;
+    } else {
+        next->prev->next = node;
+    }
+    next->prev = node;
+    return node;
+}
+
+struct tac_node *tac_insert_after(
+    struct tac *tac,
+    struct tac_node *prev,
+    struct tac_instruction instruction
+)
+{
+    struct tac_node *node = tac_create_node(instruction);
+    node->prev = prev;
+    node->next = prev->next;
+    if (prev->next == NULL) {
+        tac->last = node;
+    } else {
+        prev->next->prev = node;
+    }
+    prev->next = node;
+    return node;
+}
+
+void tac_remove(struct tac *tac, struct tac_node *node)
+{
+    if (node->prev == NULL) {
+        tac->first = node->next;
+    } else {
+        node->prev->next = node->next;
+    }
+    if (node->next == NULL) {
+        tac->last = node->prev;
+    } else {
+        node->next->prev = node->prev;
+    }
+    free_node(node);
+}
+
 struct tac tac_vjoin(size_t count, va_list vargs)
 {
     size_t i;
@@ -338,12 +450,33 @@ int tac_is_block_boundary(enum tac_opcode opcode)
         case TAC_NE:
         case TAC_SHMUL:
         case TAC_SHDIV:
+        case TAC_MHDIV:
         case TAC_AND:
         case TAC_OR:
+        case TAC_XOR:
+        case TAC_SHL:
+        case TAC_SAR:
+        case TAC_ROL:
         case TAC_NOT:
+        case TAC_COMPL:
         case TAC_ARG:
         case TAC_PRINT:
         case TAC_READ:
+        case TAC_PLOAD:
+        case TAC_PSTORE:
+        case TAC_PSPLAT:
+        case TAC_PADD:
+        case TAC_PSUB:
+        case TAC_PMUL:
+        case TAC_PDIV:
+        case TAC_PAND:
+        case TAC_POR:
+        case TAC_PXOR:
+        case TAC_PSUM:
+        case TAC_REP:
+        case TAC_FILL:
+        case TAC_COPY:
+        case TAC_PHI:
             return 0;
         case TAC_LABEL:
         case TAC_DEFS:
@@ -485,7 +618,9 @@ static void compute_local_values(struct tac *tac)
                     current->instruction.opcode != TAC_ENDFUN
                     && local_value->start_id != TAC_ID_NON_LOCAL
                 ) {
-                    if (
+                    if (is_redefinition(current, local_value)) {
+                        tac_mark_non_local_value(local_value);
+                    } else if (
                         local_value->symbol_in_use == current->instruction.dest
                         || local_value->symbol_in_use
                             == current->instruction.srcs[0]
@@ -494,7 +629,15 @@ static void compute_local_values(struct tac *tac)
                     ) {
                         if (local_value->block_id == current->block_id) {
                             tac_draft_local_value_end(current, local_value);
-                        } else if (current->block_id <= TAC_ID_MAX_OK) {
+                        } else if (
+                            current->block_id <= TAC_ID_MAX_OK
+                            || current->prev != target
+                        ) {
+                            /*
+                             * only a boundary right after the definition,
+                             * such as a jump on a condition, reads the value
+                             * without keeping it live across other code
+                             */
                             tac_mark_non_local_value(local_value);
                         }
                     }
@@ -506,7 +649,9 @@ static void compute_local_values(struct tac *tac)
                     current != target
                     && local_value->start_id != TAC_ID_NON_LOCAL
                 ) {
-                    if (
+                    if (is_redefinition(current, local_value)) {
+                        tac_mark_non_local_value(local_value);
+                    } else if (
                         local_value->symbol_in_use == current->instruction.dest
                         || local_value->symbol_in_use
                             == current->instruction.srcs[0]
@@ -534,6 +679,20 @@ static void compute_local_values(struct tac *tac)
     }
 }
 
+/*
+ * Only the assignment starting a value gets its temporary renamed, so a
+ * temporary assigned more than once, as the ones holding local variables
+ * are, must keep its name everywhere.
+ */
+static int is_redefinition(
+    struct tac_node *node,
+    struct tac_local_value *local_value
+)
+{
+    return node->instruction.dest == local_value->symbol_in_use
+        && tac_defines_dest(node->instruction.opcode);
+}
+
 struct tac_node *tac_find_next_block_start(struct tac_node *from)
 {
     struct tac_node *block_start = from;
@@ -715,6 +874,9 @@ int tac_remove_local_value(
 
 static void free_node(struct tac_node *node)
 {
+    if (node->instruction.opcode == TAC_PHI) {
+        free(node->instruction.phi_args);
+    }
     if (node->owns_starting_local_value) {
         free(node->starting_local_value);
     }
@@ -752,6 +914,84 @@ void tac_debug_locality(struct tac tac)
     }
 }
 
+int tac_defines_dest(enum tac_opcode opcode)
+{
+    switch (opcode) {
+        case TAC_MOVE:
+        case TAC_MOVI:
+        case TAC_ADD:
+        case TAC_SUB:
+        case TAC_MUL:
+        case TAC_DIV:
+        case TAC_LT:
+        case TAC_GT:
+        case TAC_LE:
+        case TAC_GE:
+        case TAC_EQ:
+        case TAC_NE:
+        case TAC_SHMUL:
+        case TAC_SHDIV:
+        case TAC_MHDIV:
+        case TAC_AND:
+        case TAC_OR:
+        case TAC_XOR:
+        case TAC_SHL:
+        case TAC_SAR:
+        case TAC_ROL:
+        case TAC_NOT:
+        case TAC_COMPL:
+        case TAC_CALL:
+        case TAC_READ:
+        case TAC_PLOAD:
+        case TAC_PSPLAT:
+        case TAC_PADD:
+        case TAC_PSUB:
+        case TAC_PMUL:
+        case TAC_PDIV:
+        case TAC_PAND:
+        case TAC_POR:
+        case TAC_PXOR:
+        case TAC_PSUM:
+        case TAC_DEFP:
+        case TAC_PHI:
+            return 1;
+        case TAC_MOVV:
+        case TAC_PSTORE:
+        case TAC_REP:
+        case TAC_FILL:
+        case TAC_COPY:
+        case TAC_ARG:
+        case TAC_PRINT:
+        case TAC_IFZ:
+        case TAC_JUMP:
+        case TAC_RET:
+        case TAC_LABEL:
+        case TAC_DEFS:
+        case TAC_DEFV:
+        case TAC_BEGINVEC:
+        case TAC_ENDVEC:
+        case TAC_BEGINFUN:
+        case TAC_ENDFUN:
+            return 0;
+    }
+    panic("TAC opcode %i's dest definition test not implemented", opcode);
+}
+
+int tac_has_side_effects(struct tac tac)
+{
+    struct tac_node *node;
+
+    for (node = tac.first; node != NULL; node = node->next) {
+        if (
+            node->instruction.opcode == TAC_CALL
+            || node->instruction.opcode == TAC_READ
+        ) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
 int tac_is_directive(enum tac_opcode opcode)
 {
     switch (opcode) {
@@ -770,9 +1010,15 @@ int tac_is_directive(enum tac_opcode opcode)
         case TAC_NE:
         case TAC_SHMUL:
         case TAC_SHDIV:
+        case TAC_MHDIV:
         case TAC_AND:
         case TAC_OR:
+        case TAC_XOR:
+        case TAC_SHL:
+        case TAC_SAR:
+        case TAC_ROL:
         case TAC_NOT:
+        case TAC_COMPL:
         case TAC_ARG:
         case TAC_PRINT:
         case TAC_READ:
@@ -781,6 +1027,21 @@ int tac_is_directive(enum tac_opcode opcode)
         case TAC_CALL:
         case TAC_RET:
         case TAC_LABEL:
+        case TAC_PLOAD:
+        case TAC_PSTORE:
+        case TAC_PSPLAT:
+        case TAC_PADD:
+        case TAC_PSUB:
+        case TAC_PMUL:
+        case TAC_PDIV:
+        case TAC_PAND:
+        case TAC_POR:
+        case TAC_PXOR:
+        case TAC_PSUM:
+        case TAC_REP:
+        case TAC_FILL:
+        case TAC_COPY:
+        case TAC_PHI:
             return 0;
         case TAC_DEFS:
         case TAC_DEFV:
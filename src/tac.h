@@ -7,6 +7,12 @@
 
 #define TAC_MAX_OPERANDS 3
 
+/* bytes held by a packed variable */
+#define TAC_PACKED_SIZE 16
+
+/* packed variables that may be alive at the same time */
+#define TAC_PACKED_COUNT 6
+
 #define TAC_ID_UNKNOWN ULONG_MAX
 #define TAC_ID_BOUNDARY (ULONG_MAX - 1)
 #define TAC_ID_NON_LOCAL (ULONG_MAX - 2)
@@ -110,12 +116,22 @@ enum tac_opcode {
     TAC_NE,
 
     /**
-     * perform binary logical operation
+     * perform binary bitwise operation, which is also logical on booleans
      *
      * <binop> x, y, z  --  x = y <binop> z
      */
     TAC_AND,
     TAC_OR,
+    TAC_XOR,
+
+    /**
+     * perform shift or rotation, arithmetic on right shifts
+     *
+     * <shift> x, y, z  --  x = y <shift> z
+     */
+    TAC_SHL,
+    TAC_SAR,
+    TAC_ROL,
 
     /**
      * perform multiplication by power of two
@@ -131,6 +147,13 @@ enum tac_opcode {
      */
     TAC_SHDIV,
 
+    /**
+     * perform division by a constant through a multiply-high
+     *
+     *  mhdiv x, y, z     -- x = y / z
+     */
+    TAC_MHDIV,
+
     /**
      * perform unary logical operation
      *
@@ -138,6 +161,13 @@ enum tac_opcode {
      */
     TAC_NOT,
 
+    /**
+     * perform bitwise complement
+     *
+     * compl x, y       -- x = ~y
+     */
+    TAC_COMPL,
+
     /**
      * mark label entry point
      *
@@ -190,13 +220,90 @@ enum tac_opcode {
     /**
      * read x           -- x = entrada;
      */
-    TAC_READ
+    TAC_READ,
+
+    /**
+     * move to packed destination with as many vector elements as it holds,
+     * starting at the index
+     *
+     * pload x, y, z    --  x = y[z], y[z + 1], ...
+     */
+    TAC_PLOAD,
+
+    /**
+     * move every element of a packed source to a vector, starting at the index
+     *
+     * pstore x, y, z   --  x[y], x[y + 1], ... = z
+     */
+    TAC_PSTORE,
+
+    /**
+     * fill every element of a packed destination with a scalar source
+     *
+     * psplat x, y      --  x = y, y, ...
+     */
+    TAC_PSPLAT,
+
+    /**
+     * perform binary operation on each element of packed operands
+     *
+     * <pbinop> x, y, z --  x = y <binop> z, element-wise
+     */
+    TAC_PADD,
+    TAC_PSUB,
+    TAC_PMUL,
+    TAC_PDIV,
+    TAC_PAND,
+    TAC_POR,
+    TAC_PXOR,
+
+    /**
+     * add up the elements of a packed source into a scalar destination
+     *
+     * psum x, y        --  x = y[0] + y[1] + ...
+     */
+    TAC_PSUM,
+
+    /**
+     * set how many elements the fill or copy right after it moves
+     *
+     * rep  , y         -- repeat the next fill or copy y times
+     */
+    TAC_REP,
+
+    /**
+     * move a scalar source to consecutive vector elements, starting at the
+     * index
+     *
+     * fill x, y, z     --  x[y], x[y + 1], ... = z
+     */
+    TAC_FILL,
+
+    /**
+     * move consecutive vector elements to the same places of another vector,
+     * starting at the index
+     *
+     * copy x, y, z     --  x[z], x[z + 1], ... = y[z], y[z + 1], ...
+     */
+    TAC_COPY,
+
+    /**
+     * select a value by the predecessor block control came from, only
+     * present while the TAC is in SSA form
+     *
+     * phi x, a, b, ... -- x = a if coming from the 1st predecessor, b if
+     *                     coming from the 2nd predecessor, and so on
+     */
+    TAC_PHI
 };
 
 struct tac_instruction {
     enum tac_opcode opcode;
     struct symbol *dest;
     struct symbol *srcs[2];
+    /* only meaningful for TAC_PHI, in the order of the block predecessors */
+    size_t phi_arg_count;
+    struct symbol **phi_args;
 };
 
 struct tac_local_value {
@@ -266,6 +373,20 @@ void tac_append(struct tac *tac, struct tac_instruction instruction);
 
 int tac_pop(struct tac *tac, struct tac_instruction *output);
 
+struct tac_node *tac_insert_before(
+    struct tac *tac,
+    struct tac_node *next,
+    struct tac_instruction instruction
+);
+
+struct tac_node *tac_insert_after(
+    struct tac *tac,
+    struct tac_node *prev,
+    struct tac_instruction instruction
+);
+
+void tac_remove(struct tac *tac, struct tac_node *node);
+
 struct tac tac_vjoin(size_t count, va_list vargs);
 
 struct tac tac_join(size_t count, ...);
@@ -274,6 +395,18 @@ void tac_free(struct tac tac);
 
 int tac_is_block_boundary(enum tac_opcode opcode);
 
+/**
+ * Tells whether the instruction assigns a value to its dest operand, as
+ * opposed to using it as a label, a function or a vector to store into.
+ */
+int tac_defines_dest(enum tac_opcode opcode);
+
+/**
+ * Tells whether running the code may do more than compute values, that is,
+ * whether it calls a function or reads input.
+ */
+int tac_has_side_effects(struct tac tac);
+
 struct tac_local_value *tac_create_local_value(void);
 
 void tac_draft_local_value_start(
@@ -1,8 +1,12 @@
 #include "tacgen.h"
 #include "const_eval.h"
 #include "panic.h"
+#include "alloc.h"
 #include <stdlib.h>
 
+/* zeroing at most this many vector elements is unrolled instead of looped */
+#define MAX_UNROLLED_ZEROES 4
+
 struct tac gen_tac_for_ast(struct ast ast)
 {
     size_t i;
@@ -48,6 +52,14 @@ struct tac gen_tac_for_scalar_var_decl(struct ast_scalar_var_decl declaration)
             }
             src_symbol = symbol_table_create_int_lit(const_int);
             break;
+        case DATATYPE_NATU:
+            if (!const_eval_int_expression(declaration.init, &const_int)) {
+                const_int = 0;
+            }
+            src_symbol = symbol_table_create_int_lit(
+                (unsigned long) const_int & DATATYPE_NATU_MASK
+            );
+            break;
         case DATATYPE_CARA:
             if (!const_eval_char_expression(declaration.init, &const_char)) {
                 const_char = 0;
@@ -108,6 +120,17 @@ struct tac gen_tac_for_vector_var_decl(struct ast_vector_var_decl declaration)
                 }
                 src_symbol = symbol_table_create_int_lit(const_int);
                 break;
+            case DATATYPE_NATU:
+                if (!const_eval_int_expression(
+                    declaration.init.expressions[i],
+                    &const_int
+                )) {
+                    const_int = 0;
+                }
+                src_symbol = symbol_table_create_int_lit(
+                    (unsigned long) const_int & DATATYPE_NATU_MASK
+                );
+                break;
             case DATATYPE_CARA:
                 if (!const_eval_char_expression(
                     declaration.init.expressions[i],
@@ -177,6 +200,7 @@ struct tac gen_tac_for_function_decl(struct ast_function_decl declaration)
                 default_ret_value = symbol_table_create_char_lit(0);
                 break;
             case DATATYPE_INTE:
+            case DATATYPE_NATU:
                 default_ret_value = symbol_table_create_int_lit(0);
                 break;
             case DATATYPE_REAL:
@@ -218,7 +242,32 @@ struct tac gen_tac_for_scalar_var_assign(
     struct ast_scalar_var_assign scalar_var_assign
 )
 {
-    struct tac tac = gen_tac_for_expr(scalar_var_assign.assigned_value);
+    struct symbol *symbol;
+    struct tac_instruction instruction;
+    struct tac tac;
+
+    /*
+     * natu operations are told apart by their destination, so they must not
+     * be written straight into other variables, nor other operations into
+     * natu variables
+     */
+    if (
+        (scalar_var_assign.variable->data.variable.type == DATATYPE_NATU)
+        != (scalar_var_assign.assigned_value.semantic_type == SEMANTIC_NAT)
+    ) {
+        tac = gen_tac_for_expr_with_dest(
+            scalar_var_assign.assigned_value,
+            &symbol
+        );
+        instruction.opcode = TAC_MOVE;
+        instruction.dest = scalar_var_assign.variable;
+        instruction.srcs[0] = symbol;
+        instruction.srcs[1] = NULL;
+        tac_append(&tac, instruction);
+        return tac;
+    }
+
+    tac = gen_tac_for_expr(scalar_var_assign.assigned_value);
     if (tac.last != NULL) {
         tac.last->instruction.dest = scalar_var_assign.variable;
     }
@@ -259,10 +308,9 @@ struct tac gen_tac_for_subscripted_assign(
 
 struct tac gen_tac_for_if(struct ast_if if_)
 {
-    struct symbol *condition_symbol;
     struct symbol *post_then_label;
     struct symbol *post_else_label;
-    struct tac_instruction ifz_instruction, jump_instruction;
+    struct tac_instruction jump_instruction;
     struct tac_instruction post_then_instr, post_else_instr;
     struct tac condition_tac, then_tac, else_tac;
 
@@ -271,16 +319,7 @@ struct tac gen_tac_for_if(struct ast_if if_)
     then_tac = tac_empty();
     else_tac = tac_empty();
 
-    condition_tac = gen_tac_for_expr_with_dest(
-        if_.condition,
-        &condition_symbol
-    );
-
-    ifz_instruction.opcode = TAC_IFZ;
-    ifz_instruction.dest = post_then_label;
-    ifz_instruction.srcs[0] = condition_symbol;
-    ifz_instruction.srcs[1] = NULL;
-    tac_append(&condition_tac, ifz_instruction);
+    condition_tac = gen_tac_for_condition(if_.condition, post_then_label);
 
     if (if_.then != NULL) {
         then_tac = gen_tac_for_stmt(*if_.then);
@@ -348,10 +387,9 @@ struct tac gen_tac_for_write(struct ast_write write)
 
 struct tac gen_tac_for_while(struct ast_while while_)
 {
-    struct symbol *condition_symbol;
     struct symbol *pre_cond_label;
     struct symbol *post_do_label;
-    struct tac_instruction ifz_instruction, jump_instruction;
+    struct tac_instruction jump_instruction;
     struct tac_instruction pre_cond_instr, post_do_instr;
     struct tac condition_tac, do_tac;
 
@@ -359,10 +397,7 @@ struct tac gen_tac_for_while(struct ast_while while_)
     post_do_label = symbol_table_create_tmp_label();
     do_tac = tac_empty();
 
-    condition_tac = gen_tac_for_expr_with_dest(
-        while_.condition,
-        &condition_symbol
-    );
+    condition_tac = gen_tac_for_condition(while_.condition, post_do_label);
 
     pre_cond_instr.opcode = TAC_LABEL; 
     pre_cond_instr.dest = NULL; 
@@ -370,12 +405,6 @@ struct tac gen_tac_for_while(struct ast_while while_)
     pre_cond_instr.srcs[1] = NULL; 
     tac_prepend(&condition_tac, pre_cond_instr);
 
-    ifz_instruction.opcode = TAC_IFZ;
-    ifz_instruction.dest = post_do_label;
-    ifz_instruction.srcs[0] = condition_symbol;
-    ifz_instruction.srcs[1] = NULL;
-    tac_append(&condition_tac, ifz_instruction);
-
     if (while_.do_ != NULL) {
         do_tac = gen_tac_for_stmt(*while_.do_);
     }
@@ -419,6 +448,145 @@ struct tac gen_tac_for_expr_stmt(struct ast_expression expression)
     return gen_tac_for_expr_with_dest(expression, &symbol);
 }
 
+struct tac gen_tac_for_local_var_decl(struct ast_local_var_decl declaration)
+{
+    size_t i, length, init_length;
+    struct symbol *value_symbol;
+    struct ast_scalar_var_assign assign;
+    struct tac_instruction instruction;
+    struct tac tac;
+
+    if (declaration.declaration.tag == AST_SCALAR_VAR_DECL) {
+        assign.variable = declaration.variable;
+        assign.assigned_value = declaration.declaration.data.scalar_var.init;
+        return gen_tac_for_scalar_var_assign(assign);
+    }
+
+    /* unlike globals, local vectors are initialized at every declaration */
+    tac = tac_empty();
+    length = declaration.variable->data.variable.length;
+    init_length = declaration.declaration.data.vector_var.init.length;
+    if (init_length > length) {
+        init_length = length;
+    }
+
+    for (i = 0; i < init_length; i++) {
+        tac = tac_join(
+            2,
+            tac,
+            gen_tac_for_expr_with_dest(
+                declaration.declaration.data.vector_var.init.expressions[i],
+                &value_symbol
+            )
+        );
+        instruction.opcode = TAC_MOVV;
+        instruction.dest = declaration.variable;
+        instruction.srcs[0] = symbol_table_create_int_lit(i);
+        instruction.srcs[1] = value_symbol;
+        tac_append(&tac, instruction);
+    }
+
+    return tac_join(
+        2,
+        tac,
+        gen_tac_for_vector_zeroes(declaration.variable, init_length, length)
+    );
+}
+
+struct tac gen_tac_for_vector_zeroes(
+    struct symbol *vector,
+    size_t start,
+    size_t end
+)
+{
+    size_t i;
+    struct symbol *zero;
+    struct symbol *index;
+    struct symbol *condition;
+    struct symbol *pre_cond_label;
+    struct symbol *post_loop_label;
+    struct tac_instruction instruction;
+    struct tac tac = tac_empty();
+
+    switch (vector->data.variable.type) {
+        case DATATYPE_CARA:
+            zero = symbol_table_create_char_lit(0);
+            break;
+        case DATATYPE_REAL:
+            zero = symbol_table_create_float_lit(0.0);
+            break;
+        default:
+            zero = symbol_table_create_int_lit(0);
+            break;
+    }
+
+    if (end - start <= MAX_UNROLLED_ZEROES) {
+        for (i = start; i < end; i++) {
+            instruction.opcode = TAC_MOVV;
+            instruction.dest = vector;
+            instruction.srcs[0] = symbol_table_create_int_lit(i);
+            instruction.srcs[1] = zero;
+            tac_append(&tac, instruction);
+        }
+        return tac;
+    }
+
+    index = symbol_table_create_tmp_scalar_var(DATATYPE_INTE);
+    condition = symbol_table_create_tmp_scalar_var(DATATYPE_INTE);
+    pre_cond_label = symbol_table_create_tmp_label();
+    post_loop_label = symbol_table_create_tmp_label();
+
+    instruction.opcode = TAC_MOVE;
+    instruction.dest = index;
+    instruction.srcs[0] = symbol_table_create_int_lit(start);
+    instruction.srcs[1] = NULL;
+    tac_append(&tac, instruction);
+
+    instruction.opcode = TAC_LABEL;
+    instruction.dest = NULL;
+    instruction.srcs[0] = pre_cond_label;
+    instruction.srcs[1] = NULL;
+    tac_append(&tac, instruction);
+
+    instruction.opcode = TAC_LT;
+    instruction.dest = condition;
+    instruction.srcs[0] = index;
+    instruction.srcs[1] = symbol_table_create_int_lit(end);
+    tac_append(&tac, instruction);
+
+    instruction.opcode = TAC_IFZ;
+    instruction.dest = post_loop_label;
+    instruction.srcs[0] = condition;
+    instruction.srcs[1] = NULL;
+    tac_append(&tac, instruction);
+
+    instruction.opcode = TAC_MOVV;
+    instruction.dest = vector;
+    instruction.srcs[0] = index;
+    instruction.srcs[1] = zero;
+    tac_append(&tac, instruction);
+
+    instruction.opcode = TAC_ADD;
+    instruction.dest = index;
+    instruction.srcs[0] = index;
+    instruction.srcs[1] = symbol_table_create_int_lit(1);
+    tac_append(&tac, instruction);
+
+    instruction.opcode = TAC_JUMP;
+    instruction.dest = pre_cond_label;
+    instruction.srcs[0] = NULL;
+    instruction.srcs[1] = NULL;
+    tac_append(&tac, instruction);
+
+    instruction.opcode = TAC_LABEL;
+    instruction.dest = NULL;
+    instruction.srcs[0] = post_loop_label;
+    instruction.srcs[1] = NULL;
+    tac_append(&tac, instruction);
+
+    return tac;
+}
+
 struct tac gen_tac_for_stmt(struct ast_statement statement)
 {
     switch (statement.tag) {
@@ -442,6 +610,8 @@ struct tac gen_tac_for_stmt(struct ast_statement statement)
             return gen_tac_for_body(statement.data.body);
         case AST_EXPRESSION_STATEMENT:
             return gen_tac_for_expr_stmt(statement.data.expression);
+        case AST_LOCAL_VAR_DECL:
+            return gen_tac_for_local_var_decl(*statement.data.local_var_decl);
     }
     panic("statement tag %i's TAC generation not implemented", statement.tag);
 }
@@ -501,6 +671,12 @@ enum tac_opcode bin_operator_to_tac_opcode(enum ast_binary_operator operator)
         case AST_NOT_EQUAL: return TAC_NE;
         case AST_AND: return TAC_AND;
         case AST_OR: return TAC_OR;
+        case AST_BIT_AND: return TAC_AND;
+        case AST_BIT_OR: return TAC_OR;
+        case AST_BIT_XOR: return TAC_XOR;
+        case AST_SHIFT_LEFT: return TAC_SHL;
+        case AST_SHIFT_RIGHT: return TAC_SAR;
+        case AST_ROTATE_LEFT: return TAC_ROL;
     }
     panic("binary operator %i's TAC generation not implemented", operator);
 }
@@ -509,6 +685,7 @@ enum tac_opcode unary_operator_to_tac_opcode(enum ast_unary_operator operator)
 {
     switch (operator) {
        case AST_NOT: return TAC_NOT;
+       case AST_BIT_NOT: return TAC_COMPL;
     }
     panic("unary operator %i's TAC generation not implemented", operator);
 }
@@ -530,6 +707,28 @@ struct tac gen_tac_for_bin_operation(struct ast_binary_operation operation)
     );
 
     tac = tac_join(2, left_tac, right_tac);
+
+    /* shift counts are the only operands not wrapped into natu */
+    switch (operation.operator) {
+        case AST_SHIFT_LEFT:
+        case AST_SHIFT_RIGHT:
+        case AST_ROTATE_LEFT:
+            break;
+        default:
+            if (
+                operation.left_operand->semantic_type == SEMANTIC_NAT
+                || operation.right_operand->semantic_type == SEMANTIC_NAT
+            ) {
+                tac = tac_join(
+                    3,
+                    tac,
+                    gen_tac_for_natu_operand(&left_symbol),
+                    gen_tac_for_natu_operand(&right_symbol)
+                );
+            }
+            break;
+    }
+
     instruction.opcode = bin_operator_to_tac_opcode(operation.operator);
     instruction.dest = NULL;
     instruction.srcs[0] = left_symbol;
@@ -538,6 +737,38 @@ struct tac gen_tac_for_bin_operation(struct ast_binary_operation operation)
     return tac;
 }
 
+/* literals are reduced modulo 2^32, other variables moved into natu */
+struct tac gen_tac_for_natu_operand(struct symbol **operand)
+{
+    struct tac_instruction instruction;
+    struct symbol *symbol = *operand;
+
+    switch (symbol->type) {
+        case SYM_LIT_INT:
+            *operand = symbol_table_create_int_lit(
+                (unsigned long) symbol->data.parsed_int & DATATYPE_NATU_MASK
+            );
+            return tac_empty();
+        case SYM_LIT_CHAR:
+            *operand = symbol_table_create_int_lit(
+                (unsigned char) symbol->data.parsed_char
+            );
+            return tac_empty();
+        default:
+            if (symbol->data.variable.type == DATATYPE_NATU) {
+                return tac_empty();
+            }
+            break;
+    }
+
+    *operand = symbol_table_create_tmp_scalar_var(DATATYPE_NATU);
+    instruction.opcode = TAC_MOVE;
+    instruction.dest = *operand;
+    instruction.srcs[0] = symbol;
+    instruction.srcs[1] = NULL;
+    return tac_singleton(instruction);
+}
+
 struct tac gen_tac_for_unary_operation(struct ast_unary_operation operation)
 {
     struct tac_instruction instruction;
@@ -559,27 +790,65 @@ struct tac gen_tac_for_unary_operation(struct ast_unary_operation operation)
 
 struct tac gen_tac_for_function_call(struct ast_function_call function_call)
 {
-    size_t i;
-    struct symbol *arg_symbol;
+    size_t i, j;
+    int later_call;
+    struct symbol **arg_symbols;
     struct tac_instruction instruction;
-    struct tac tac, arg_tac;
+    struct tac_node *node;
+    struct tac tac;
+    struct tac *arg_tacs;
 
     tac = tac_empty();
+    arg_symbols = aborting_malloc(
+        sizeof(*arg_symbols) * (function_call.argument_list.length + 1)
+    );
+    arg_tacs = aborting_malloc(
+        sizeof(*arg_tacs) * (function_call.argument_list.length + 1)
+    );
 
+    /*
+     * arguments may contain calls themselves, so they are all evaluated
+     * before the first of them is passed
+     */
     for (i = 0; i < function_call.argument_list.length; i++) {
-        arg_tac = gen_tac_for_expr_with_dest(
+        arg_tacs[i] = gen_tac_for_expr_with_dest(
             function_call.argument_list.expressions[i],
-            &arg_symbol
+            &arg_symbols[i]
         );
+    }
+
+    /* a variable passed before a call must be read before that call */
+    for (i = 0; i < function_call.argument_list.length; i++) {
+        later_call = 0;
+        for (j = i + 1; j < function_call.argument_list.length; j++) {
+            for (node = arg_tacs[j].first; node != NULL; node = node->next) {
+                if (node->instruction.opcode == TAC_CALL) {
+                    later_call = 1;
+                }
+            }
+        }
+        if (later_call && arg_symbols[i]->type == SYM_SCALAR_VAR) {
+            instruction.opcode = TAC_MOVE;
+            instruction.dest = symbol_table_create_tmp_scalar_var(
+                arg_symbols[i]->data.variable.type
+            );
+            instruction.srcs[0] = arg_symbols[i];
+            instruction.srcs[1] = NULL;
+            tac_append(&arg_tacs[i], instruction);
+            arg_symbols[i] = instruction.dest;
+        }
+        tac = tac_join(2, tac, arg_tacs[i]);
+    }
+    free(arg_tacs);
 
+    for (i = 0; i < function_call.argument_list.length; i++) {
         instruction.opcode = TAC_ARG;
         instruction.dest = NULL;
-        instruction.srcs[0] = arg_symbol;
+        instruction.srcs[0] = arg_symbols[i];
         instruction.srcs[1] = NULL;
-        tac_append(&arg_tac, instruction);
-
-        tac = tac_join(2, tac, arg_tac);
+        tac_append(&tac, instruction);
     }
+    free(arg_symbols);
 
     instruction.opcode = TAC_CALL;
     instruction.dest = NULL;
@@ -614,6 +883,78 @@ struct tac gen_tac_for_expr_with_dest(
     return tac;
 }
 
+/*
+ * Jumps to the given label when the condition is false and falls through
+ * otherwise. Logical & and | become chains of branches that skip their right
+ * operand whenever the left one decides, unless the right operand would call a
+ * function or read input, in which case both are still evaluated.
+ */
+struct tac gen_tac_for_condition(
+    struct ast_expression condition,
+    struct symbol *false_label
+)
+{
+    struct symbol *condition_symbol, *right_label, *true_label;
+    struct ast_binary_operation operation;
+    struct tac_instruction instruction;
+    struct tac tac, left_tac, right_tac;
+
+    operation = condition.data.binary_operation;
+    if (
+        condition.tag == AST_BINARY_OPERATION
+        && (operation.operator == AST_AND || operation.operator == AST_OR)
+    ) {
+        right_tac = gen_tac_for_condition(
+            *operation.right_operand,
+            false_label
+        );
+        if (!tac_has_side_effects(right_tac)) {
+            if (operation.operator == AST_AND) {
+                left_tac = gen_tac_for_condition(
+                    *operation.left_operand,
+                    false_label
+                );
+                return tac_join(2, left_tac, right_tac);
+            }
+
+            right_label = symbol_table_create_tmp_label();
+            true_label = symbol_table_create_tmp_label();
+            left_tac = gen_tac_for_condition(
+                *operation.left_operand,
+                right_label
+            );
+
+            instruction.opcode = TAC_JUMP;
+            instruction.dest = true_label;
+            instruction.srcs[0] = NULL;
+            instruction.srcs[1] = NULL;
+            tac_append(&left_tac, instruction);
+
+            instruction.opcode = TAC_LABEL;
+            instruction.dest = NULL;
+            instruction.srcs[0] = right_label;
+            instruction.srcs[1] = NULL;
+            tac_prepend(&right_tac, instruction);
+
+            instruction.srcs[0] = true_label;
+            tac_append(&right_tac, instruction);
+
+            return tac_join(2, left_tac, right_tac);
+        }
+        tac_free(right_tac);
+    }
+
+    tac = gen_tac_for_expr_with_dest(condition, &condition_symbol);
+
+    instruction.opcode = TAC_IFZ;
+    instruction.dest = false_label;
+    instruction.srcs[0] = condition_symbol;
+    instruction.srcs[1] = NULL;
+    tac_append(&tac, instruction);
+
+    return tac;
+}
+
 struct tac gen_tac_for_expr(struct ast_expression expression)
 {
     switch (expression.tag) {
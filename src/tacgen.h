@@ -34,6 +34,14 @@ struct tac gen_tac_for_return(struct ast_return return_);
 
 struct tac gen_tac_for_expr_stmt(struct ast_expression expression);
 
+struct tac gen_tac_for_local_var_decl(struct ast_local_var_decl declaration);
+
+struct tac gen_tac_for_vector_zeroes(
+    struct symbol *vector,
+    size_t start,
+    size_t end
+);
+
 struct tac gen_tac_for_stmt(struct ast_statement statement);
 
 struct tac gen_tac_for_expr_with_dest(
@@ -41,6 +49,11 @@ struct tac gen_tac_for_expr_with_dest(
     struct symbol **dest
 );
 
+struct tac gen_tac_for_condition(
+    struct ast_expression condition,
+    struct symbol *false_label
+);
+
 struct tac gen_tac_for_input(void);
 
 struct tac gen_tac_for_subscription(struct ast_subscription subscription);
@@ -51,6 +64,8 @@ enum tac_opcode bin_operator_to_tac_opcode(enum ast_binary_operator operator);
 
 struct tac gen_tac_for_bin_operation(struct ast_binary_operation operation);
 
+struct tac gen_tac_for_natu_operand(struct symbol **operand);
+
 struct tac gen_tac_for_unary_operation(struct ast_unary_operation operation);
 
 struct tac gen_tac_for_function_call(struct ast_function_call function_call);
@@ -1,21 +1,469 @@
 #include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include "tacopt.h"
+#include "ssa.h"
+#include "inliner.h"
+#include "unroll.h"
+#include "vectorize.h"
+#include "idioms.h"
+#include "cfg.h"
+#include "alloc.h"
 #include "symboltable.h"
 #include "vector.h"
+#include "panic.h"
+
+#define TAC_OPT_SSA_PASSES \
+    ( \
+        TAC_OPT_SSA \
+        | TAC_OPT_CONST_PROP \
+        | TAC_OPT_DCE \
+        | TAC_OPT_GVN \
+        | TAC_OPT_LICM \
+        | TAC_OPT_STRENGTH_REDUCE \
+    )
+
+enum const_prop_state {
+    CONST_PROP_UNDEFINED,
+    CONST_PROP_CONSTANT,
+    CONST_PROP_VARYING
+};
+
+struct const_prop_use {
+    struct tac_node *node;
+    size_t block;
+};
+
+struct const_prop_value {
+    struct symbol *symbol;
+    enum const_prop_state state;
+    struct symbol *constant;
+    size_t use_count;
+    struct const_prop_use *uses;
+};
+
+struct const_prop_edge {
+    size_t from;
+    size_t to;
+};
+
+struct dce_value {
+    struct symbol *symbol;
+    int is_live;
+    size_t def_count;
+    struct tac_node **defs;
+};
+
+struct gvn_leader {
+    struct symbol *symbol;
+    struct symbol *leader;
+};
+
+struct gvn_expr {
+    enum tac_opcode opcode;
+    struct symbol *srcs[2];
+    enum datatype type;
+    struct symbol *value;
+};
+
+struct licm_def {
+    struct symbol *symbol;
+    size_t block;
+};
+
+struct licm {
+    struct tac *tac;
+    struct cfg cfg;
+    size_t param_count;
+    struct symbol **params;
+    /* indexed through the ssa_index of the temporaries */
+    size_t def_count;
+    struct licm_def *defs;
+};
+
+struct iv {
+    struct tac_node *phi_node;
+    struct symbol *init;
+    struct tac_node *step_node;
+    size_t step_block;
+    enum tac_opcode step_opcode;
+    long step;
+};
+
+struct iv_derived {
+    size_t iv;
+    long factor;
+    struct symbol *current;
+    struct symbol *next;
+};
+
+struct gvn {
+    struct tac *tac;
+    struct cfg cfg;
+    size_t param_count;
+    struct symbol **params;
+    /* indexed through the ssa_index of the temporaries */
+    size_t leader_count;
+    struct gvn_leader *leaders;
+    /* expressions computed in the dominators of the current block */
+    size_t expr_count;
+    struct gvn_expr *exprs;
+    /* vector reads of the current block not clobbered yet */
+    size_t load_count;
+    struct gvn_expr *loads;
+    size_t redundant_count;
+    struct tac_node **redundant;
+};
+
+struct const_prop {
+    struct tac *tac;
+    struct cfg cfg;
+    int *block_executable;
+    /* per block, indexed like the block predecessors */
+    int **edge_executable;
+    size_t value_count;
+    struct const_prop_value *values;
+    size_t edge_worklist_length;
+    struct const_prop_edge *edge_worklist;
+    size_t use_worklist_length;
+    struct const_prop_use *use_worklist;
+};
 
 static int exact_log2(long integer, int *log);
 
 static void power_of_two(struct tac *tac);
 
+static void magic_division(struct tac *tac);
+
 static void reuse_tmps(struct tac *tac);
 
-void optimize_tac(struct tac *tac, tac_opt_flags_type flags)
+static void merge_prints(struct tac *tac);
+
+static int merge_prints_is_constant(struct symbol *symbol);
+
+static char *merge_prints_render(
+    char *buf,
+    size_t *length,
+    struct symbol *symbol
+);
+
+static void const_prop(struct tac *tac);
+
+static struct tac_node *const_prop_function(
+    struct tac *tac,
+    struct tac_node *beginfun_node
+);
+
+static void const_prop_collect(struct const_prop *const_prop);
+
+static size_t const_prop_find(
+    struct const_prop *const_prop,
+    struct symbol *symbol
+);
+
+static void const_prop_add_use(
+    struct const_prop *const_prop,
+    struct symbol *symbol,
+    struct tac_node *node,
+    size_t block
+);
+
+static void const_prop_run(struct const_prop *const_prop);
+
+static void const_prop_push_edge(
+    struct const_prop *const_prop,
+    size_t from,
+    size_t to
+);
+
+static void const_prop_visit_edge(
+    struct const_prop *const_prop,
+    struct const_prop_edge edge
+);
+
+static void const_prop_visit(
+    struct const_prop *const_prop,
+    struct tac_node *node,
+    size_t block
+);
+
+static void const_prop_visit_ifz(
+    struct const_prop *const_prop,
+    struct tac_node *node,
+    size_t block
+);
+
+static enum const_prop_state const_prop_eval_phi(
+    struct const_prop *const_prop,
+    struct tac_node *node,
+    size_t block,
+    struct symbol **constant
+);
+
+static enum const_prop_state const_prop_eval(
+    struct const_prop *const_prop,
+    struct tac_instruction instruction,
+    struct symbol **constant
+);
+
+static enum const_prop_state const_prop_lookup(
+    struct const_prop *const_prop,
+    struct symbol *symbol,
+    struct symbol **constant
+);
+
+static struct symbol *const_prop_fold(
+    enum tac_opcode opcode,
+    struct symbol *left,
+    struct symbol *right,
+    enum datatype type
+);
+
+static int literal_has_type(struct symbol *literal, enum datatype type);
+
+static int const_prop_ifz_target(
+    struct const_prop *const_prop,
+    size_t block,
+    size_t *target
+);
+
+static size_t const_prop_dropped_successor(
+    struct const_prop *const_prop,
+    size_t block
+);
+
+static void const_prop_prune_phis(struct const_prop *const_prop);
+
+static void const_prop_rewrite(struct const_prop *const_prop);
+
+static void const_prop_free(struct const_prop *const_prop);
+
+static void dce_values(struct tac *tac);
+
+static struct tac_node *dce_values_function(
+    struct tac *tac,
+    struct tac_node *beginfun_node
+);
+
+static int dce_is_critical(struct tac_instruction instruction);
+
+static void dce_mark_live(
+    size_t value_count,
+    struct dce_value *values,
+    struct symbol *symbol,
+    size_t **worklist,
+    size_t *worklist_length
+);
+
+static struct symbol **function_params(
+    struct tac_node *beginfun_node,
+    size_t *param_count
+);
+
+static int is_param(
+    size_t param_count,
+    struct symbol **params,
+    struct symbol *symbol
+);
+
+static void gvn(struct tac *tac);
+
+static struct tac_node *gvn_function(
+    struct tac *tac,
+    struct tac_node *beginfun_node
+);
+
+static void gvn_block(struct gvn *gvn, size_t block);
+
+static void gvn_visit(struct gvn *gvn, struct tac_node *node);
+
+static int gvn_is_value(struct gvn *gvn, struct symbol *symbol);
+
+static int gvn_is_commutative(enum tac_opcode opcode);
+
+static struct symbol *gvn_find_expr(
+    size_t expr_count,
+    struct gvn_expr *exprs,
+    struct gvn_expr expr
+);
+
+static void gvn_set_leader(
+    struct gvn *gvn,
+    struct symbol *symbol,
+    struct symbol *leader
+);
+
+static struct symbol *gvn_leader(struct gvn *gvn, struct symbol *symbol);
+
+static void gvn_rewrite(struct gvn *gvn);
+
+static void licm(struct tac *tac);
+
+static struct tac_node *licm_function(
+    struct tac *tac,
+    struct tac_node *beginfun_node
+);
+
+static size_t loop_entry(struct cfg const *cfg, size_t loop);
+
+static int loop_split(struct tac *tac, struct cfg const *cfg, size_t loop);
+
+static size_t loop_preheader(struct cfg const *cfg, size_t loop);
+
+static void licm_collect_defs(struct licm *licm);
+
+static void licm_loop(struct licm *licm, size_t loop, size_t preheader);
+
+static int licm_is_invariant(
+    struct licm *licm,
+    size_t loop,
+    struct tac_instruction instruction
+);
+
+static int licm_is_invariant_operand(
+    struct licm *licm,
+    size_t loop,
+    struct symbol *symbol
+);
+
+static int licm_can_trap(enum tac_opcode opcode);
+
+static int licm_executes_always(struct licm *licm, size_t loop, size_t block);
+
+static int licm_hoist(
+    struct licm *licm,
+    size_t block,
+    struct tac_node *node,
+    size_t preheader
+);
+
+static void licm_set_def_block(
+    struct licm *licm,
+    struct symbol *symbol,
+    size_t block
+);
+
+static size_t licm_def_block(struct licm *licm, struct symbol *symbol);
+
+static void iv_reduce(struct tac *tac);
+
+static struct tac_node *iv_reduce_function(
+    struct tac *tac,
+    struct tac_node *beginfun_node
+);
+
+static void iv_reduce_loop(
+    struct tac *tac,
+    struct cfg *cfg,
+    size_t loop,
+    size_t preheader
+);
+
+static struct iv *iv_collect(struct cfg const *cfg, size_t loop);
+
+static int iv_match_product(
+    struct tac_instruction instruction,
+    struct iv iv,
+    long *factor,
+    int *uses_next
+);
+
+static struct iv_derived iv_create(
+    struct tac *tac,
+    struct cfg *cfg,
+    size_t loop,
+    size_t preheader,
+    struct iv iv,
+    long factor
+);
+
+static void insert_at_block_end(
+    struct tac *tac,
+    struct cfg_block *block,
+    struct tac_instruction instruction
+);
+
+static void dce_control(struct tac *tac);
+
+static struct tac_node *dce_control_function(
+    struct tac *tac,
+    struct tac_node *beginfun_node
+);
+
+static int dce_unreachable_blocks(
+    struct tac *tac,
+    struct tac_node *beginfun_node
+);
+
+static int dce_jumps_to_next(
+    struct tac *tac,
+    struct tac_node *beginfun_node
+);
+
+static int dce_unused_labels(
+    struct tac *tac,
+    struct tac_node *beginfun_node
+);
+
+void optimize_tac(
+    struct tac *tac,
+    tac_opt_flags_type flags,
+    struct tac_opt_params params
+)
 {
+    if (flags & TAC_OPT_INLINE) {
+        inline_calls(tac, params.inline_limit);
+    }
+
+    if (flags & TAC_OPT_LOOP_IDIOMS) {
+        replace_loop_idioms(tac);
+    }
+
+    if (flags & TAC_OPT_VECTORIZE) {
+        vectorize_loops(tac);
+    }
+
+    if (flags & TAC_OPT_UNROLL_LOOPS) {
+        unroll_loops(tac, params.unroll_factor);
+    }
+
+    if (flags & TAC_OPT_SSA_PASSES) {
+        ssa_construct(tac);
+        if (flags & TAC_OPT_CONST_PROP) {
+            const_prop(tac);
+        }
+        if (flags & TAC_OPT_GVN) {
+            gvn(tac);
+        }
+        if (flags & TAC_OPT_LICM) {
+            licm(tac);
+        }
+        if (flags & TAC_OPT_STRENGTH_REDUCE) {
+            iv_reduce(tac);
+        }
+        if (flags & TAC_OPT_DCE) {
+            dce_values(tac);
+        }
+        ssa_destruct(tac);
+    }
+
+    if (flags & TAC_OPT_DCE) {
+        dce_control(tac);
+    }
+
+    if (flags & TAC_OPT_MERGE_PRINTS) {
+        merge_prints(tac);
+    }
+
     if (flags & TAC_OPT_POWER_OF_TWO) {
         power_of_two(tac);
     }
 
+    if (flags & TAC_OPT_MAGIC_DIV) {
+        magic_division(tac);
+    }
+
     if (flags & TAC_OPT_REUSE_TMPS) {
         reuse_tmps(tac);
     }
@@ -40,8 +488,11 @@ static void power_of_two(struct tac *tac)
                             &log2
                         );
                         if (is_power_of_two) {
+                            /* the shift amount always goes on the right */
                             node->instruction.opcode = TAC_SHMUL;
                             node->instruction.srcs[i] =
+                                node->instruction.srcs[1 - i];
+                            node->instruction.srcs[1] =
                                 symbol_table_create_int_lit(log2);
                         }
                     }
@@ -54,7 +505,8 @@ static void power_of_two(struct tac *tac)
                         node->instruction.srcs[1]->data.parsed_int,
                         &log2
                     );
-                    if (is_power_of_two) {
+                    /* the rounding bias is added as a 32-bit displacement */
+                    if (is_power_of_two && abs(log2) < 32) {
                         node->instruction.opcode = TAC_SHDIV;
                         node->instruction.srcs[1] =
                             symbol_table_create_int_lit(log2);
@@ -67,9 +519,161 @@ static void power_of_two(struct tac *tac)
     }
 }
 
+/*
+ * Dividing by -1 is a negation, which, unlike the division instruction, does
+ * not trap on the smallest long. Powers of two only get here when
+ * power_of_two left them, and the multiplier works for them as well. The
+ * smallest long is left to the division instruction, since its magnitude does
+ * not fit the multiplier, and so are the negative divisors of natu values,
+ * which are divided unsigned.
+ */
+static void magic_division(struct tac *tac)
+{
+    struct tac_node *node;
+    long divisor;
+
+    for (node = tac->first; node != NULL; node = node->next) {
+        if (
+            node->instruction.opcode != TAC_DIV
+            || node->instruction.srcs[1]->type != SYM_LIT_INT
+            || node->instruction.dest->data.variable.type == DATATYPE_REAL
+        ) {
+            continue;
+        }
+        divisor = node->instruction.srcs[1]->data.parsed_int;
+        if (
+            divisor < 0
+            && node->instruction.dest->data.variable.type == DATATYPE_NATU
+        ) {
+            continue;
+        }
+        if (divisor == -1) {
+            node->instruction.opcode = TAC_SUB;
+            node->instruction.srcs[1] = node->instruction.srcs[0];
+            node->instruction.srcs[0] = symbol_table_create_int_lit(0);
+        } else if (divisor != LONG_MIN && labs(divisor) > 1) {
+            node->instruction.opcode = TAC_MHDIV;
+        }
+    }
+}
+
+/*
+ * Renders runs of constant print arguments at compile time, so that each run
+ * becomes a single string literal written at once.
+ */
+static void merge_prints(struct tac *tac)
+{
+    size_t length;
+    char *buf;
+    struct string_literal literal;
+    struct tac_node *node;
+    struct tac_node *next;
+
+    for (node = tac->first; node != NULL; node = node->next) {
+        if (
+            node->instruction.opcode != TAC_PRINT
+            || !merge_prints_is_constant(node->instruction.srcs[0])
+        ) {
+            continue;
+        }
+
+        next = node->next;
+        if (
+            node->instruction.srcs[0]->type != SYM_LIT_INT
+            && (
+                next == NULL
+                || next->instruction.opcode != TAC_PRINT
+                || !merge_prints_is_constant(next->instruction.srcs[0])
+            )
+        ) {
+            continue;
+        }
+
+        buf = vector_empty(&length);
+        buf = merge_prints_render(buf, &length, node->instruction.srcs[0]);
+
+        while (
+            next != NULL
+            && next->instruction.opcode == TAC_PRINT
+            && merge_prints_is_constant(next->instruction.srcs[0])
+        ) {
+            buf = merge_prints_render(buf, &length, next->instruction.srcs[0]);
+            tac_remove(tac, next);
+            next = node->next;
+        }
+
+        literal.buf = buf;
+        literal.length = length;
+        node->instruction.srcs[0] = symbol_table_rev_create_str_lit(literal);
+        free(buf);
+    }
+}
+
+static int merge_prints_is_constant(struct symbol *symbol)
+{
+    switch (symbol->type) {
+        case SYM_LIT_STR:
+        case SYM_LIT_CHAR:
+        case SYM_LIT_INT:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/* appends the text the runtime would print for the given literal */
+static char *merge_prints_render(
+    char *buf,
+    size_t *length,
+    struct symbol *symbol
+)
+{
+    size_t i;
+    char int_buf[32];
+
+    switch (symbol->type) {
+        case SYM_LIT_STR:
+            for (i = 0; i < symbol->data.string.literal.length; i++) {
+                buf = vector_push(
+                    buf,
+                    sizeof(*buf),
+                    length,
+                    &symbol->data.string.literal.buf[i]
+                );
+            }
+            break;
+        case SYM_LIT_CHAR:
+            buf = vector_push(
+                buf,
+                sizeof(*buf),
+                length,
+                &symbol->data.parsed_char
+            );
+            break;
+        case SYM_LIT_INT:
+            snprintf(int_buf, sizeof(int_buf), "%ld", symbol->data.parsed_int);
+            for (i = 0; int_buf[i] != 0; i++) {
+                buf = vector_push(buf, sizeof(*buf), length, &int_buf[i]);
+            }
+            break;
+        default:
+            panic("symbol type %i cannot be merged into a print", symbol->type);
+    }
+
+    return buf;
+}
+
+/*
+ * Negative powers of two give a negative logarithm, so -1 is rejected, since
+ * its logarithm could not carry the sign, and so is the smallest long, whose
+ * magnitude does not fit.
+ */
 static int exact_log2(long integer, int *log)
 {
     int is_neg = integer < 0;
+    if (integer == -1 || integer == LONG_MIN) {
+        return 0;
+    }
     if (is_neg) {
         integer = -integer;
     }
@@ -92,7 +696,7 @@ static int exact_log2(long integer, int *log)
 
 static void reuse_tmps(struct tac *tac)
 {
-    size_t i;
+    size_t i, j;
     struct tac_node *node;
     struct tac_local_value *local_value;
     struct tac_local_value_set free_symbol_owners;
@@ -143,15 +747,29 @@ static void reuse_tmps(struct tac *tac)
                                 node->ending_local_values
                                     .ordered_values[i]->symbol_in_use;
                     }
-                    if (
-                        node->starting_local_value != NULL
-                        && free_symbol_owners.length > 0
-                    ) {
-                        free_symbol_owners.ordered_values = vector_pop(
+                    j = free_symbol_owners.length;
+                    if (node->starting_local_value != NULL) {
+                        while (
+                            j > 0
+                            && free_symbol_owners.ordered_values[j - 1]
+                                ->symbol_offered->data.variable.type
+                                != node->starting_local_value
+                                    ->old_symbol->data.variable.type
+                        ) {
+                            j--;
+                        }
+                    }
+                    if (node->starting_local_value != NULL && j > 0) {
+                        local_value = free_symbol_owners.ordered_values[j - 1];
+                        free_symbol_owners.ordered_values = vector_splice(
                             free_symbol_owners.ordered_values,
                             sizeof(*free_symbol_owners.ordered_values),
                             &free_symbol_owners.length,
-                            &local_value
+                            j - 1,
+                            j,
+                            NULL,
+                            0,
+                            NULL
                         );
                         node->starting_local_value->symbol_in_use =
                             local_value->symbol_offered;
@@ -173,3 +791,2478 @@ static void reuse_tmps(struct tac *tac)
         }
     }
 }
+
+/*
+ * Sparse conditional constant propagation (Wegman and Zadeck), run while the
+ * TAC is in SSA form. Only temporaries are tracked, since after SSA
+ * construction every reachable temporary has a single definition.
+ */
+static void const_prop(struct tac *tac)
+{
+    struct tac_node *node;
+
+    node = tac_find_function_start(tac->first);
+    while (node != NULL) {
+        node = const_prop_function(tac, node);
+        node = tac_find_function_start(node);
+    }
+}
+
+static struct tac_node *const_prop_function(
+    struct tac *tac,
+    struct tac_node *beginfun_node
+)
+{
+    size_t i, j;
+    struct tac_node *endfun_node;
+    struct const_prop const_prop;
+
+    const_prop.tac = tac;
+    const_prop.cfg = cfg_build(beginfun_node);
+    const_prop.block_executable = aborting_malloc(
+        sizeof(*const_prop.block_executable)
+        * (const_prop.cfg.block_count + 1)
+    );
+    const_prop.edge_executable = aborting_malloc(
+        sizeof(*const_prop.edge_executable) * (const_prop.cfg.block_count + 1)
+    );
+    for (i = 0; i < const_prop.cfg.block_count; i++) {
+        const_prop.block_executable[i] = 0;
+        const_prop.edge_executable[i] = aborting_malloc(
+            sizeof(**const_prop.edge_executable)
+            * (const_prop.cfg.blocks[i].predecessor_count + 1)
+        );
+        for (j = 0; j < const_prop.cfg.blocks[i].predecessor_count; j++) {
+            const_prop.edge_executable[i][j] = 0;
+        }
+    }
+    const_prop.values = vector_empty(&const_prop.value_count);
+    const_prop.edge_worklist = vector_empty(&const_prop.edge_worklist_length);
+    const_prop.use_worklist = vector_empty(&const_prop.use_worklist_length);
+
+    const_prop_collect(&const_prop);
+    if (const_prop.cfg.block_count > 0) {
+        const_prop_push_edge(&const_prop, CFG_NO_BLOCK, 0);
+        const_prop_run(&const_prop);
+        const_prop_prune_phis(&const_prop);
+        const_prop_rewrite(&const_prop);
+    }
+
+    endfun_node = const_prop.cfg.endfun_node;
+    const_prop_free(&const_prop);
+    return endfun_node;
+}
+
+static void const_prop_collect(struct const_prop *const_prop)
+{
+    size_t i, j, block, index;
+    struct tac_node *node;
+    struct const_prop_value value;
+
+    for (i = 0; i < const_prop->cfg.reverse_postorder_length; i++) {
+        block = const_prop->cfg.reverse_postorder[i];
+        node = const_prop->cfg.blocks[block].first;
+        for (;;) {
+            if (
+                tac_defines_dest(node->instruction.opcode)
+                && node->instruction.dest->type == SYM_TMP_VAR
+            ) {
+                index = const_prop_find(const_prop, node->instruction.dest);
+                if (index == SIZE_MAX) {
+                    value.symbol = node->instruction.dest;
+                    value.state = CONST_PROP_UNDEFINED;
+                    value.constant = NULL;
+                    value.uses = vector_empty(&value.use_count);
+                    node->instruction.dest->data.variable.ssa_index =
+                        const_prop->value_count;
+                    const_prop->values = vector_push(
+                        const_prop->values,
+                        sizeof(*const_prop->values),
+                        &const_prop->value_count,
+                        &value
+                    );
+                } else {
+                    /* not in SSA form, nothing can be assumed */
+                    const_prop->values[index].state = CONST_PROP_VARYING;
+                }
+            }
+            if (node == const_prop->cfg.blocks[block].last) {
+                break;
+            }
+            node = node->next;
+        }
+    }
+
+    for (i = 0; i < const_prop->cfg.reverse_postorder_length; i++) {
+        block = const_prop->cfg.reverse_postorder[i];
+        node = const_prop->cfg.blocks[block].first;
+        for (;;) {
+            if (node->instruction.opcode == TAC_PHI) {
+                for (j = 0; j < node->instruction.phi_arg_count; j++) {
+                    const_prop_add_use(
+                        const_prop,
+                        node->instruction.phi_args[j],
+                        node,
+                        block
+                    );
+                }
+            } else if (node->instruction.opcode != TAC_LABEL) {
+                const_prop_add_use(
+                    const_prop,
+                    node->instruction.srcs[0],
+                    node,
+                    block
+                );
+                const_prop_add_use(
+                    const_prop,
+                    node->instruction.srcs[1],
+                    node,
+                    block
+                );
+            }
+            if (node == const_prop->cfg.blocks[block].last) {
+                break;
+            }
+            node = node->next;
+        }
+    }
+}
+
+static size_t const_prop_find(
+    struct const_prop *const_prop,
+    struct symbol *symbol
+)
+{
+    size_t index;
+
+    if (symbol == NULL || symbol->type != SYM_TMP_VAR) {
+        return SIZE_MAX;
+    }
+
+    index = symbol->data.variable.ssa_index;
+    if (
+        index < const_prop->value_count
+        && const_prop->values[index].symbol == symbol
+    ) {
+        return index;
+    }
+    return SIZE_MAX;
+}
+
+static void const_prop_add_use(
+    struct const_prop *const_prop,
+    struct symbol *symbol,
+    struct tac_node *node,
+    size_t block
+)
+{
+    size_t index;
+    struct const_prop_use use;
+    struct const_prop_value *value;
+
+    index = const_prop_find(const_prop, symbol);
+    if (index == SIZE_MAX) {
+        return;
+    }
+
+    value = &const_prop->values[index];
+    use.node = node;
+    use.block = block;
+    value->uses = vector_push(
+        value->uses,
+        sizeof(*value->uses),
+        &value->use_count,
+        &use
+    );
+}
+
+static void const_prop_run(struct const_prop *const_prop)
+{
+    struct const_prop_edge edge;
+    struct const_prop_use use;
+
+    while (
+        const_prop->edge_worklist_length > 0
+        || const_prop->use_worklist_length > 0
+    ) {
+        if (const_prop->edge_worklist_length > 0) {
+            const_prop->edge_worklist = vector_pop(
+                const_prop->edge_worklist,
+                sizeof(*const_prop->edge_worklist),
+                &const_prop->edge_worklist_length,
+                &edge
+            );
+            const_prop_visit_edge(const_prop, edge);
+        } else {
+            const_prop->use_worklist = vector_pop(
+                const_prop->use_worklist,
+                sizeof(*const_prop->use_worklist),
+                &const_prop->use_worklist_length,
+                &use
+            );
+            if (const_prop->block_executable[use.block]) {
+                const_prop_visit(const_prop, use.node, use.block);
+            }
+        }
+    }
+}
+
+static void const_prop_push_edge(
+    struct const_prop *const_prop,
+    size_t from,
+    size_t to
+)
+{
+    struct const_prop_edge edge;
+
+    edge.from = from;
+    edge.to = to;
+    const_prop->edge_worklist = vector_push(
+        const_prop->edge_worklist,
+        sizeof(*const_prop->edge_worklist),
+        &const_prop->edge_worklist_length,
+        &edge
+    );
+}
+
+static void const_prop_visit_edge(
+    struct const_prop *const_prop,
+    struct const_prop_edge edge
+)
+{
+    size_t i;
+    struct tac_node *node;
+    struct cfg_block *block;
+
+    block = &const_prop->cfg.blocks[edge.to];
+
+    if (edge.from != CFG_NO_BLOCK) {
+        for (i = 0; block->predecessors[i] != edge.from; i++) {
+        }
+        if (const_prop->edge_executable[edge.to][i]) {
+            return;
+        }
+        const_prop->edge_executable[edge.to][i] = 1;
+    }
+
+    /* phis see one more argument, the rest of the block only runs once */
+    node = block->first;
+    for (;;) {
+        if (
+            node->instruction.opcode == TAC_PHI
+            || !const_prop->block_executable[edge.to]
+        ) {
+            const_prop_visit(const_prop, node, edge.to);
+        }
+        if (node == block->last) {
+            break;
+        }
+        node = node->next;
+    }
+
+    if (!const_prop->block_executable[edge.to]) {
+        const_prop->block_executable[edge.to] = 1;
+        if (block->last->instruction.opcode != TAC_IFZ) {
+            for (i = 0; i < block->successor_count; i++) {
+                const_prop_push_edge(
+                    const_prop,
+                    edge.to,
+                    block->successors[i]
+                );
+            }
+        }
+    }
+}
+
+static void const_prop_visit(
+    struct const_prop *const_prop,
+    struct tac_node *node,
+    size_t block
+)
+{
+    size_t i, index;
+    enum const_prop_state state;
+    struct symbol *constant;
+    struct const_prop_value *value;
+
+    if (node->instruction.opcode == TAC_IFZ) {
+        const_prop_visit_ifz(const_prop, node, block);
+        return;
+    }
+
+    if (!tac_defines_dest(node->instruction.opcode)) {
+        return;
+    }
+    index = const_prop_find(const_prop, node->instruction.dest);
+    if (index == SIZE_MAX) {
+        return;
+    }
+    value = &const_prop->values[index];
+    if (value->state == CONST_PROP_VARYING) {
+        return;
+    }
+
+    constant = NULL;
+    if (node->instruction.opcode == TAC_PHI) {
+        state = const_prop_eval_phi(const_prop, node, block, &constant);
+    } else {
+        state = const_prop_eval(const_prop, node->instruction, &constant);
+    }
+
+    if (
+        state == CONST_PROP_CONSTANT
+        && !literal_has_type(constant, value->symbol->data.variable.type)
+    ) {
+        state = CONST_PROP_VARYING;
+    }
+
+    if (
+        state == CONST_PROP_CONSTANT
+        && value->state == CONST_PROP_CONSTANT
+        && constant != value->constant
+    ) {
+        state = CONST_PROP_VARYING;
+    }
+
+    if (state > value->state) {
+        value->state = state;
+        value->constant = constant;
+        for (i = 0; i < value->use_count; i++) {
+            const_prop->use_worklist = vector_push(
+                const_prop->use_worklist,
+                sizeof(*const_prop->use_worklist),
+                &const_prop->use_worklist_length,
+                &value->uses[i]
+            );
+        }
+    }
+}
+
+static void const_prop_visit_ifz(
+    struct const_prop *const_prop,
+    struct tac_node *node,
+    size_t block
+)
+{
+    size_t i, target;
+    struct symbol *constant;
+    struct cfg_block *cfg_block;
+
+    cfg_block = &const_prop->cfg.blocks[block];
+
+    if (const_prop_ifz_target(const_prop, block, &target)) {
+        const_prop_push_edge(const_prop, block, target);
+    } else if (
+        const_prop_lookup(const_prop, node->instruction.srcs[0], &constant)
+        != CONST_PROP_UNDEFINED
+    ) {
+        for (i = 0; i < cfg_block->successor_count; i++) {
+            const_prop_push_edge(
+                const_prop,
+                block,
+                cfg_block->successors[i]
+            );
+        }
+    }
+}
+
+static enum const_prop_state const_prop_eval_phi(
+    struct const_prop *const_prop,
+    struct tac_node *node,
+    size_t block,
+    struct symbol **constant
+)
+{
+    size_t i;
+    enum const_prop_state state, arg_state;
+    struct symbol *arg_constant;
+
+    state = CONST_PROP_UNDEFINED;
+
+    for (i = 0; i < node->instruction.phi_arg_count; i++) {
+        if (
+            !const_prop->edge_executable[block][i]
+            || node->instruction.phi_args[i] == NULL
+        ) {
+            continue;
+        }
+        arg_state = const_prop_lookup(
+            const_prop,
+            node->instruction.phi_args[i],
+            &arg_constant
+        );
+        switch (arg_state) {
+            case CONST_PROP_UNDEFINED:
+                break;
+            case CONST_PROP_CONSTANT:
+                if (state == CONST_PROP_UNDEFINED) {
+                    state = CONST_PROP_CONSTANT;
+                    *constant = arg_constant;
+                } else if (*constant != arg_constant) {
+                    return CONST_PROP_VARYING;
+                }
+                break;
+            case CONST_PROP_VARYING:
+                return CONST_PROP_VARYING;
+        }
+    }
+
+    return state;
+}
+
+static enum const_prop_state const_prop_eval(
+    struct const_prop *const_prop,
+    struct tac_instruction instruction,
+    struct symbol **constant
+)
+{
+    enum const_prop_state left_state, right_state;
+    struct symbol *left, *right;
+
+    switch (instruction.opcode) {
+        case TAC_MOVE:
+            return const_prop_lookup(const_prop, instruction.srcs[0], constant);
+
+        case TAC_NOT:
+        case TAC_COMPL:
+            left_state =
+                const_prop_lookup(const_prop, instruction.srcs[0], &left);
+            if (left_state != CONST_PROP_CONSTANT) {
+                return left_state;
+            }
+            *constant = const_prop_fold(
+                instruction.opcode,
+                left,
+                NULL,
+                instruction.dest->data.variable.type
+            );
+            return *constant == NULL
+                ? CONST_PROP_VARYING
+                : CONST_PROP_CONSTANT;
+
+        case TAC_ADD:
+        case TAC_SUB:
+        case TAC_MUL:
+        case TAC_DIV:
+        case TAC_LT:
+        case TAC_GT:
+        case TAC_LE:
+        case TAC_GE:
+        case TAC_EQ:
+        case TAC_NE:
+        case TAC_AND:
+        case TAC_OR:
+        case TAC_XOR:
+        case TAC_SHL:
+        case TAC_SAR:
+        case TAC_ROL:
+            left_state =
+                const_prop_lookup(const_prop, instruction.srcs[0], &left);
+            right_state =
+                const_prop_lookup(const_prop, instruction.srcs[1], &right);
+            if (
+                left_state == CONST_PROP_VARYING
+                || right_state == CONST_PROP_VARYING
+            ) {
+                return CONST_PROP_VARYING;
+            }
+            if (
+                left_state == CONST_PROP_UNDEFINED
+                || right_state == CONST_PROP_UNDEFINED
+            ) {
+                return CONST_PROP_UNDEFINED;
+            }
+            *constant = const_prop_fold(
+                instruction.opcode,
+                left,
+                right,
+                instruction.dest->data.variable.type
+            );
+            return *constant == NULL
+                ? CONST_PROP_VARYING
+                : CONST_PROP_CONSTANT;
+
+        default:
+            return CONST_PROP_VARYING;
+    }
+}
+
+static enum const_prop_state const_prop_lookup(
+    struct const_prop *const_prop,
+    struct symbol *symbol,
+    struct symbol **constant
+)
+{
+    size_t index;
+
+    switch (symbol->type) {
+        case SYM_LIT_INT:
+        case SYM_LIT_CHAR:
+        case SYM_LIT_FLOAT:
+            *constant = symbol;
+            return CONST_PROP_CONSTANT;
+        default:
+            break;
+    }
+
+    index = const_prop_find(const_prop, symbol);
+    if (index == SIZE_MAX) {
+        return CONST_PROP_VARYING;
+    }
+    *constant = const_prop->values[index].constant;
+    return const_prop->values[index].state;
+}
+
+/*
+ * Folds only operands of the same literal kind into a result of the kind the
+ * destination is stored with, since the backend reads and writes every
+ * operand with its own size. Whatever would trap or is not representable as
+ * a literal is left to run.
+ */
+static struct symbol *const_prop_fold(
+    enum tac_opcode opcode,
+    struct symbol *left,
+    struct symbol *right,
+    enum datatype type
+)
+{
+    long left_int, right_int, result_int;
+    double left_float, right_float, result_float;
+
+    if (opcode == TAC_NOT) {
+        if (left->type != SYM_LIT_INT || type != DATATYPE_INTE) {
+            return NULL;
+        }
+        return symbol_table_create_int_lit(~left->data.parsed_int & 1);
+    }
+
+    if (opcode == TAC_COMPL) {
+        if (left->type == SYM_LIT_INT && type == DATATYPE_INTE) {
+            return symbol_table_create_int_lit(~left->data.parsed_int);
+        }
+        if (left->type == SYM_LIT_INT && type == DATATYPE_NATU) {
+            return symbol_table_create_int_lit(
+                ~left->data.parsed_int & DATATYPE_NATU_MASK
+            );
+        }
+        if (left->type == SYM_LIT_CHAR && type == DATATYPE_CARA) {
+            return symbol_table_create_char_lit(~left->data.parsed_char);
+        }
+        return NULL;
+    }
+
+    if (left->type != right->type) {
+        return NULL;
+    }
+
+    if (left->type == SYM_LIT_FLOAT) {
+        left_float = left->data.float_.parsed;
+        right_float = right->data.float_.parsed;
+        if (left_float != left_float || right_float != right_float) {
+            return NULL;
+        }
+        switch (opcode) {
+            case TAC_ADD:
+                result_float = left_float + right_float;
+                break;
+            case TAC_SUB:
+                result_float = left_float - right_float;
+                break;
+            case TAC_MUL:
+                result_float = left_float * right_float;
+                break;
+            case TAC_DIV:
+                if (right_float == 0.0) {
+                    return NULL;
+                }
+                result_float = left_float / right_float;
+                break;
+            case TAC_LT:
+                result_int = left_float < right_float;
+                break;
+            case TAC_GT:
+                result_int = left_float > right_float;
+                break;
+            case TAC_LE:
+                result_int = left_float <= right_float;
+                break;
+            case TAC_GE:
+                result_int = left_float >= right_float;
+                break;
+            case TAC_EQ:
+                result_int = left_float == right_float;
+                break;
+            case TAC_NE:
+                result_int = left_float != right_float;
+                break;
+            default:
+                return NULL;
+        }
+        switch (opcode) {
+            case TAC_ADD:
+            case TAC_SUB:
+            case TAC_MUL:
+            case TAC_DIV:
+                /* infinities have no literal */
+                if (type != DATATYPE_REAL || result_float - result_float != 0) {
+                    return NULL;
+                }
+                return symbol_table_create_float_lit(result_float);
+            default:
+                if (type != DATATYPE_INTE) {
+                    return NULL;
+                }
+                return symbol_table_create_int_lit(result_int);
+        }
+    }
+
+    switch (left->type) {
+        case SYM_LIT_INT:
+            left_int = left->data.parsed_int;
+            right_int = right->data.parsed_int;
+            break;
+        case SYM_LIT_CHAR:
+            left_int = left->data.parsed_char;
+            right_int = right->data.parsed_char;
+            break;
+        default:
+            return NULL;
+    }
+
+    /* natu operands are 32-bit, and so is the width they shift in */
+    if (type == DATATYPE_NATU) {
+        left_int &= DATATYPE_NATU_MASK;
+        right_int &= DATATYPE_NATU_MASK;
+    }
+
+    switch (opcode) {
+        case TAC_ADD:
+            result_int = (unsigned long) left_int + (unsigned long) right_int;
+            break;
+        case TAC_SUB:
+            result_int = (unsigned long) left_int - (unsigned long) right_int;
+            break;
+        case TAC_MUL:
+            result_int = (unsigned long) left_int * (unsigned long) right_int;
+            break;
+        case TAC_DIV:
+            if (
+                right_int == 0
+                || (
+                    right_int == -1
+                    && (left_int == LONG_MIN || left_int == CHAR_MIN)
+                )
+            ) {
+                return NULL;
+            }
+            result_int = left_int / right_int;
+            break;
+        case TAC_LT:
+            return type == DATATYPE_INTE
+                ? symbol_table_create_int_lit(left_int < right_int)
+                : NULL;
+        case TAC_GT:
+            return type == DATATYPE_INTE
+                ? symbol_table_create_int_lit(left_int > right_int)
+                : NULL;
+        case TAC_LE:
+            return type == DATATYPE_INTE
+                ? symbol_table_create_int_lit(left_int <= right_int)
+                : NULL;
+        case TAC_GE:
+            return type == DATATYPE_INTE
+                ? symbol_table_create_int_lit(left_int >= right_int)
+                : NULL;
+        case TAC_EQ:
+            return type == DATATYPE_INTE
+                ? symbol_table_create_int_lit(left_int == right_int)
+                : NULL;
+        case TAC_NE:
+            return type == DATATYPE_INTE
+                ? symbol_table_create_int_lit(left_int != right_int)
+                : NULL;
+        case TAC_AND:
+            result_int = left_int & right_int;
+            break;
+        case TAC_OR:
+            result_int = left_int | right_int;
+            break;
+        case TAC_XOR:
+            result_int = left_int ^ right_int;
+            break;
+        case TAC_SHL:
+        case TAC_SAR:
+        case TAC_ROL:
+            /* byte counts are masked to five bits, not to the byte width */
+            if (left->type != SYM_LIT_INT) {
+                return NULL;
+            }
+            if (type == DATATYPE_NATU) {
+                right_int &= 31;
+                if (opcode == TAC_SHL) {
+                    result_int = left_int << right_int;
+                } else if (opcode == TAC_SAR) {
+                    result_int = left_int >> right_int;
+                } else if (right_int == 0) {
+                    result_int = left_int;
+                } else {
+                    result_int = left_int << right_int
+                        | left_int >> (32 - right_int);
+                }
+                break;
+            }
+            right_int &= 63;
+            if (opcode == TAC_SHL) {
+                result_int = (unsigned long) left_int << right_int;
+            } else if (opcode == TAC_SAR) {
+                result_int = left_int >> right_int;
+            } else if (right_int == 0) {
+                result_int = left_int;
+            } else {
+                result_int = (unsigned long) left_int << right_int
+                    | (unsigned long) left_int >> (64 - right_int);
+            }
+            break;
+        default:
+            return NULL;
+    }
+
+    if (left->type == SYM_LIT_INT && type == DATATYPE_INTE) {
+        return symbol_table_create_int_lit(result_int);
+    }
+    if (left->type == SYM_LIT_INT && type == DATATYPE_NATU) {
+        return symbol_table_create_int_lit(result_int & DATATYPE_NATU_MASK);
+    }
+    if (left->type == SYM_LIT_CHAR && type == DATATYPE_CARA) {
+        return symbol_table_create_char_lit(result_int);
+    }
+    return NULL;
+}
+
+static int literal_has_type(struct symbol *literal, enum datatype type)
+{
+    switch (literal->type) {
+        case SYM_LIT_INT:
+            return type == DATATYPE_INTE
+                || (
+                    type == DATATYPE_NATU
+                    && (unsigned long) literal->data.parsed_int
+                        <= DATATYPE_NATU_MASK
+                );
+        case SYM_LIT_CHAR:
+            return type == DATATYPE_CARA;
+        case SYM_LIT_FLOAT:
+            return type == DATATYPE_REAL;
+        default:
+            return 0;
+    }
+}
+
+/*
+ * Finds the only successor the conditional jump ending the given block can
+ * take, if its condition is a known integer.
+ */
+static int const_prop_ifz_target(
+    struct const_prop *const_prop,
+    size_t block,
+    size_t *target
+)
+{
+    int is_zero;
+    struct symbol *constant;
+    struct tac_node *last;
+
+    last = const_prop->cfg.blocks[block].last;
+    if (
+        last->instruction.opcode != TAC_IFZ
+        || const_prop_lookup(const_prop, last->instruction.srcs[0], &constant)
+            != CONST_PROP_CONSTANT
+    ) {
+        return 0;
+    }
+
+    switch (constant->type) {
+        case SYM_LIT_INT:
+            is_zero = constant->data.parsed_int == 0;
+            break;
+        case SYM_LIT_CHAR:
+            is_zero = constant->data.parsed_char == 0;
+            break;
+        default:
+            return 0;
+    }
+
+    if (is_zero) {
+        *target = cfg_find_label_block(
+            &const_prop->cfg,
+            last->instruction.dest
+        );
+    } else {
+        *target = block + 1;
+    }
+    return 1;
+}
+
+/*
+ * Tells which successor loses its edge from the given block once its
+ * conditional jump is folded, CFG_NO_BLOCK if nothing is folded there.
+ */
+static size_t const_prop_dropped_successor(
+    struct const_prop *const_prop,
+    size_t block
+)
+{
+    size_t target, label_block;
+
+    if (
+        !const_prop->block_executable[block]
+        || !const_prop_ifz_target(const_prop, block, &target)
+    ) {
+        return CFG_NO_BLOCK;
+    }
+
+    label_block = cfg_find_label_block(
+        &const_prop->cfg,
+        const_prop->cfg.blocks[block].last->instruction.dest
+    );
+    if (label_block == block + 1) {
+        return CFG_NO_BLOCK;
+    }
+    return target == label_block ? block + 1 : label_block;
+}
+
+/*
+ * Removes the phi arguments of the edges that folding conditional jumps is
+ * about to remove, keeping the arguments in the order of the predecessors the
+ * CFG will have afterwards.
+ */
+static void const_prop_prune_phis(struct const_prop *const_prop)
+{
+    size_t i, j, k, count;
+    struct tac_node *node;
+    struct cfg_block *block;
+
+    for (i = 0; i < const_prop->cfg.block_count; i++) {
+        block = &const_prop->cfg.blocks[i];
+        for (
+            node = block->first->next;
+            node != block->last->next
+                && node->instruction.opcode == TAC_PHI;
+            node = node->next
+        ) {
+            count = 0;
+            for (j = 0; j < node->instruction.phi_arg_count; j++) {
+                k = block->predecessors[j];
+                if (const_prop_dropped_successor(const_prop, k) != i) {
+                    node->instruction.phi_args[count] =
+                        node->instruction.phi_args[j];
+                    count++;
+                }
+            }
+            node->instruction.phi_arg_count = count;
+        }
+    }
+}
+
+static void const_prop_rewrite(struct const_prop *const_prop)
+{
+    size_t i, j, index, dropped;
+    struct tac_node *node, *next;
+    struct cfg_block *block;
+
+    for (i = 0; i < const_prop->cfg.block_count; i++) {
+        if (!const_prop->block_executable[i]) {
+            continue;
+        }
+        block = &const_prop->cfg.blocks[i];
+        dropped = const_prop_dropped_successor(const_prop, i);
+
+        node = block->first;
+        for (;;) {
+            next = node->next;
+
+            if (node->instruction.opcode == TAC_PHI) {
+                for (j = 0; j < node->instruction.phi_arg_count; j++) {
+                    index = const_prop_find(
+                        const_prop,
+                        node->instruction.phi_args[j]
+                    );
+                    if (
+                        index != SIZE_MAX
+                        && const_prop->values[index].state
+                            == CONST_PROP_CONSTANT
+                    ) {
+                        node->instruction.phi_args[j] =
+                            const_prop->values[index].constant;
+                    }
+                }
+            } else if (node->instruction.opcode != TAC_LABEL) {
+                for (j = 0; j < 2; j++) {
+                    index = const_prop_find(
+                        const_prop,
+                        node->instruction.srcs[j]
+                    );
+                    if (
+                        index != SIZE_MAX
+                        && const_prop->values[index].state
+                            == CONST_PROP_CONSTANT
+                    ) {
+                        node->instruction.srcs[j] =
+                            const_prop->values[index].constant;
+                    }
+                }
+
+                index = tac_defines_dest(node->instruction.opcode)
+                    ? const_prop_find(const_prop, node->instruction.dest)
+                    : SIZE_MAX;
+                if (
+                    index != SIZE_MAX
+                    && const_prop->values[index].state == CONST_PROP_CONSTANT
+                ) {
+                    node->instruction.opcode = TAC_MOVE;
+                    node->instruction.srcs[0] =
+                        const_prop->values[index].constant;
+                    node->instruction.srcs[1] = NULL;
+                }
+            }
+
+            if (node == block->last) {
+                break;
+            }
+            node = next;
+        }
+
+        if (dropped == i + 1) {
+            node->instruction.opcode = TAC_JUMP;
+            node->instruction.srcs[0] = NULL;
+        } else if (dropped != CFG_NO_BLOCK) {
+            tac_remove(const_prop->tac, node);
+        }
+    }
+}
+
+static void const_prop_free(struct const_prop *const_prop)
+{
+    size_t i;
+
+    for (i = 0; i < const_prop->value_count; i++) {
+        free(const_prop->values[i].uses);
+    }
+    for (i = 0; i < const_prop->cfg.block_count; i++) {
+        free(const_prop->edge_executable[i]);
+    }
+    free(const_prop->values);
+    free(const_prop->edge_executable);
+    free(const_prop->block_executable);
+    free(const_prop->edge_worklist);
+    free(const_prop->use_worklist);
+    cfg_free(const_prop->cfg);
+}
+
+/*
+ * Parameters are never assigned in SSA form, so unlike the other scalar
+ * variables they hold the same value in the whole function.
+ */
+static struct symbol **function_params(
+    struct tac_node *beginfun_node,
+    size_t *param_count
+)
+{
+    struct symbol **params;
+    struct tac_node *node;
+
+    params = vector_empty(param_count);
+    for (
+        node = beginfun_node->next;
+        node != NULL && node->instruction.opcode == TAC_DEFP;
+        node = node->next
+    ) {
+        params = vector_push(
+            params,
+            sizeof(*params),
+            param_count,
+            &node->instruction.dest
+        );
+    }
+
+    return params;
+}
+
+static int is_param(
+    size_t param_count,
+    struct symbol **params,
+    struct symbol *symbol
+)
+{
+    size_t i;
+
+    for (i = 0; i < param_count; i++) {
+        if (params[i] == symbol) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Numbers the values of the TAC in SSA form along the dominator tree: a copy
+ * or an expression already computed by a dominator is replaced by the
+ * temporary holding it. Vector reads are only reused inside a block, until a
+ * vector write, a call or a read clobbers them.
+ */
+static void gvn(struct tac *tac)
+{
+    struct tac_node *node;
+
+    node = tac_find_function_start(tac->first);
+    while (node != NULL) {
+        node = gvn_function(tac, node);
+        node = tac_find_function_start(node);
+    }
+}
+
+static struct tac_node *gvn_function(
+    struct tac *tac,
+    struct tac_node *beginfun_node
+)
+{
+    size_t i;
+    struct gvn gvn;
+    struct tac_node *endfun_node;
+
+    gvn.tac = tac;
+    gvn.cfg = cfg_build(beginfun_node);
+    gvn.params = function_params(beginfun_node, &gvn.param_count);
+    gvn.leaders = vector_empty(&gvn.leader_count);
+    gvn.exprs = vector_empty(&gvn.expr_count);
+    gvn.loads = vector_empty(&gvn.load_count);
+    gvn.redundant = vector_empty(&gvn.redundant_count);
+
+    if (gvn.cfg.block_count > 0) {
+        gvn_block(&gvn, 0);
+    }
+    gvn_rewrite(&gvn);
+
+    endfun_node = gvn.cfg.endfun_node;
+    cfg_free(gvn.cfg);
+
+    for (i = 0; i < gvn.redundant_count; i++) {
+        tac_remove(tac, gvn.redundant[i]);
+    }
+
+    free(gvn.params);
+    free(gvn.leaders);
+    free(gvn.exprs);
+    free(gvn.loads);
+    free(gvn.redundant);
+
+    return endfun_node;
+}
+
+static void gvn_block(struct gvn *gvn, size_t block)
+{
+    size_t i, expr_count;
+    struct tac_node *node;
+
+    expr_count = gvn->expr_count;
+    gvn->load_count = 0;
+
+    node = gvn->cfg.blocks[block].first;
+    for (;;) {
+        if (
+            node->instruction.opcode != TAC_LABEL
+            && node->instruction.opcode != TAC_PHI
+        ) {
+            gvn_visit(gvn, node);
+        }
+        if (node == gvn->cfg.blocks[block].last) {
+            break;
+        }
+        node = node->next;
+    }
+
+    for (i = 0; i < gvn->cfg.blocks[block].dominated_count; i++) {
+        gvn_block(gvn, gvn->cfg.blocks[block].dominated[i]);
+    }
+
+    gvn->expr_count = expr_count;
+}
+
+static void gvn_visit(struct gvn *gvn, struct tac_node *node)
+{
+    size_t i;
+    struct gvn_expr expr;
+    struct symbol *dest;
+    struct symbol *value;
+
+    for (i = 0; i < 2; i++) {
+        node->instruction.srcs[i] = gvn_leader(gvn, node->instruction.srcs[i]);
+    }
+
+    dest = node->instruction.dest;
+    expr.opcode = node->instruction.opcode;
+    expr.srcs[0] = node->instruction.srcs[0];
+    expr.srcs[1] = node->instruction.srcs[1];
+    expr.value = dest;
+
+    switch (node->instruction.opcode) {
+        case TAC_MOVE:
+            value = expr.srcs[0];
+            if (
+                dest->type == SYM_TMP_VAR
+                && gvn_is_value(gvn, value)
+                && (
+                    (
+                        value->type == SYM_TMP_VAR
+                        || value->type == SYM_SCALAR_VAR
+                    )
+                        ? value->data.variable.type
+                            == dest->data.variable.type
+                        : literal_has_type(value, dest->data.variable.type)
+                )
+            ) {
+                gvn_set_leader(gvn, dest, value);
+                gvn->redundant = vector_push(
+                    gvn->redundant,
+                    sizeof(*gvn->redundant),
+                    &gvn->redundant_count,
+                    &node
+                );
+            }
+            break;
+
+        case TAC_ADD:
+        case TAC_SUB:
+        case TAC_MUL:
+        case TAC_DIV:
+        case TAC_LT:
+        case TAC_GT:
+        case TAC_LE:
+        case TAC_GE:
+        case TAC_EQ:
+        case TAC_NE:
+        case TAC_AND:
+        case TAC_OR:
+        case TAC_XOR:
+        case TAC_SHL:
+        case TAC_SAR:
+        case TAC_ROL:
+        case TAC_SHMUL:
+        case TAC_SHDIV:
+        case TAC_MHDIV:
+        case TAC_NOT:
+        case TAC_COMPL:
+            if (
+                dest->type != SYM_TMP_VAR
+                || !gvn_is_value(gvn, expr.srcs[0])
+                || (expr.srcs[1] != NULL && !gvn_is_value(gvn, expr.srcs[1]))
+            ) {
+                break;
+            }
+            expr.type = dest->data.variable.type;
+            value = gvn_find_expr(gvn->expr_count, gvn->exprs, expr);
+            if (value != NULL) {
+                gvn_set_leader(gvn, dest, value);
+                gvn->redundant = vector_push(
+                    gvn->redundant,
+                    sizeof(*gvn->redundant),
+                    &gvn->redundant_count,
+                    &node
+                );
+            } else {
+                gvn->exprs = vector_push(
+                    gvn->exprs,
+                    sizeof(*gvn->exprs),
+                    &gvn->expr_count,
+                    &expr
+                );
+            }
+            break;
+
+        case TAC_MOVI:
+            if (
+                dest->type != SYM_TMP_VAR
+                || !gvn_is_value(gvn, expr.srcs[1])
+            ) {
+                break;
+            }
+            expr.type = dest->data.variable.type;
+            value = gvn_find_expr(gvn->load_count, gvn->loads, expr);
+            if (value != NULL) {
+                gvn_set_leader(gvn, dest, value);
+                gvn->redundant = vector_push(
+                    gvn->redundant,
+                    sizeof(*gvn->redundant),
+                    &gvn->redundant_count,
+                    &node
+                );
+            } else {
+                gvn->loads = vector_push(
+                    gvn->loads,
+                    sizeof(*gvn->loads),
+                    &gvn->load_count,
+                    &expr
+                );
+            }
+            break;
+
+        case TAC_MOVV:
+        case TAC_PSTORE:
+        case TAC_FILL:
+        case TAC_COPY:
+            /* distinct vectors never overlap */
+            i = 0;
+            while (i < gvn->load_count) {
+                if (gvn->loads[i].srcs[0] == dest) {
+                    gvn->loads[i] = gvn->loads[gvn->load_count - 1];
+                    gvn->load_count--;
+                } else {
+                    i++;
+                }
+            }
+            break;
+
+        case TAC_CALL:
+        case TAC_READ:
+            gvn->load_count = 0;
+            break;
+
+        default:
+            break;
+    }
+}
+
+static int gvn_is_value(struct gvn *gvn, struct symbol *symbol)
+{
+    switch (symbol->type) {
+        case SYM_TMP_VAR:
+        case SYM_LIT_INT:
+        case SYM_LIT_CHAR:
+        case SYM_LIT_FLOAT:
+            return 1;
+        case SYM_SCALAR_VAR:
+            return is_param(gvn->param_count, gvn->params, symbol);
+        default:
+            return 0;
+    }
+}
+
+static int gvn_is_commutative(enum tac_opcode opcode)
+{
+    switch (opcode) {
+        case TAC_ADD:
+        case TAC_MUL:
+        case TAC_EQ:
+        case TAC_NE:
+        case TAC_AND:
+        case TAC_OR:
+        case TAC_XOR:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static struct symbol *gvn_find_expr(
+    size_t expr_count,
+    struct gvn_expr *exprs,
+    struct gvn_expr expr
+)
+{
+    size_t i;
+
+    for (i = 0; i < expr_count; i++) {
+        if (exprs[i].opcode != expr.opcode || exprs[i].type != expr.type) {
+            continue;
+        }
+        if (
+            exprs[i].srcs[0] == expr.srcs[0]
+            && exprs[i].srcs[1] == expr.srcs[1]
+        ) {
+            return exprs[i].value;
+        }
+        if (
+            gvn_is_commutative(expr.opcode)
+            && exprs[i].srcs[0] == expr.srcs[1]
+            && exprs[i].srcs[1] == expr.srcs[0]
+        ) {
+            return exprs[i].value;
+        }
+    }
+
+    return NULL;
+}
+
+static void gvn_set_leader(
+    struct gvn *gvn,
+    struct symbol *symbol,
+    struct symbol *leader
+)
+{
+    struct gvn_leader entry;
+
+    entry.symbol = symbol;
+    entry.leader = leader;
+    symbol->data.variable.ssa_index = gvn->leader_count;
+    gvn->leaders = vector_push(
+        gvn->leaders,
+        sizeof(*gvn->leaders),
+        &gvn->leader_count,
+        &entry
+    );
+}
+
+static struct symbol *gvn_leader(struct gvn *gvn, struct symbol *symbol)
+{
+    size_t index;
+
+    if (symbol == NULL || symbol->type != SYM_TMP_VAR) {
+        return symbol;
+    }
+
+    index = symbol->data.variable.ssa_index;
+    if (index < gvn->leader_count && gvn->leaders[index].symbol == symbol) {
+        return gvn->leaders[index].leader;
+    }
+    return symbol;
+}
+
+/*
+ * The leader of a value dominates every use of the value, so uses not visited
+ * yet, such as phi arguments of back edges, are replaced at the end.
+ */
+static void gvn_rewrite(struct gvn *gvn)
+{
+    size_t i;
+    struct tac_node *node;
+
+    for (
+        node = gvn->cfg.beginfun_node;
+        node != gvn->cfg.endfun_node;
+        node = node->next
+    ) {
+        if (node->instruction.opcode == TAC_PHI) {
+            for (i = 0; i < node->instruction.phi_arg_count; i++) {
+                node->instruction.phi_args[i] = gvn_leader(
+                    gvn,
+                    node->instruction.phi_args[i]
+                );
+            }
+        } else if (node->instruction.opcode != TAC_LABEL) {
+            for (i = 0; i < 2; i++) {
+                node->instruction.srcs[i] = gvn_leader(
+                    gvn,
+                    node->instruction.srcs[i]
+                );
+            }
+        }
+    }
+}
+
+/*
+ * Hoists the computations of temporaries that do not change inside a loop to
+ * the end of the loop preheader, the only block entering the loop. Inner
+ * loops are handled first, so their invariants can still leave the outer
+ * loops.
+ */
+static void licm(struct tac *tac)
+{
+    struct tac_node *node;
+
+    node = tac_find_function_start(tac->first);
+    while (node != NULL) {
+        node = licm_function(tac, node);
+        node = tac_find_function_start(node);
+    }
+}
+
+static struct tac_node *licm_function(
+    struct tac *tac,
+    struct tac_node *beginfun_node
+)
+{
+    size_t i, preheader;
+    int split;
+    struct licm licm;
+    struct tac_node *endfun_node;
+
+    licm.tac = tac;
+    licm.cfg = cfg_build(beginfun_node);
+
+    split = 0;
+    for (i = 0; i < licm.cfg.loop_count; i++) {
+        if (loop_split(tac, &licm.cfg, i)) {
+            split = 1;
+        }
+    }
+    if (split) {
+        cfg_free(licm.cfg);
+        licm.cfg = cfg_build(beginfun_node);
+    }
+
+    licm.params = function_params(beginfun_node, &licm.param_count);
+    licm.defs = vector_empty(&licm.def_count);
+    licm_collect_defs(&licm);
+
+    for (i = licm.cfg.loop_count; i > 0; i--) {
+        preheader = loop_preheader(&licm.cfg, i - 1);
+        if (preheader != CFG_NO_BLOCK) {
+            licm_loop(&licm, i - 1, preheader);
+        }
+    }
+
+    endfun_node = licm.cfg.endfun_node;
+    cfg_free(licm.cfg);
+    free(licm.params);
+    free(licm.defs);
+
+    return endfun_node;
+}
+
+/*
+ * Finds the only block outside of the loop jumping into its header, if any.
+ */
+static size_t loop_entry(struct cfg const *cfg, size_t loop)
+{
+    size_t i, header, predecessor, entry;
+
+    header = cfg->loops[loop].header;
+    entry = CFG_NO_BLOCK;
+    for (i = 0; i < cfg->blocks[header].predecessor_count; i++) {
+        predecessor = cfg->blocks[header].predecessors[i];
+        if (!cfg_loop_contains(cfg, loop, predecessor)) {
+            if (entry != CFG_NO_BLOCK) {
+                return CFG_NO_BLOCK;
+            }
+            entry = predecessor;
+        }
+    }
+
+    return entry;
+}
+
+/*
+ * Gives the loop a preheader when its entry falls through into the header
+ * from a conditional jump, by labeling the header a second time: the first
+ * label starts the new block. Since the entry comes right before the header,
+ * the order of the header predecessors, which the phis rely on, is kept.
+ */
+static int loop_split(struct tac *tac, struct cfg const *cfg, size_t loop)
+{
+    size_t entry, header;
+    struct tac_instruction instruction;
+
+    header = cfg->loops[loop].header;
+    entry = loop_entry(cfg, loop);
+    if (
+        entry == CFG_NO_BLOCK
+        || entry + 1 != header
+        || cfg->blocks[entry].successor_count < 2
+        || cfg->blocks[entry].last->instruction.opcode != TAC_IFZ
+        || cfg->blocks[header].first->instruction.opcode != TAC_LABEL
+        || cfg->blocks[entry].last->instruction.dest
+            == cfg->blocks[header].first->instruction.srcs[0]
+    ) {
+        return 0;
+    }
+
+    instruction.opcode = TAC_LABEL;
+    instruction.dest = NULL;
+    instruction.srcs[0] = symbol_table_create_tmp_label();
+    instruction.srcs[1] = NULL;
+    instruction.phi_arg_count = 0;
+    instruction.phi_args = NULL;
+    tac_insert_before(tac, cfg->blocks[header].first, instruction);
+
+    return 1;
+}
+
+static size_t loop_preheader(struct cfg const *cfg, size_t loop)
+{
+    size_t entry;
+
+    entry = loop_entry(cfg, loop);
+    if (
+        entry == CFG_NO_BLOCK
+        || cfg->blocks[entry].postorder_index == CFG_NO_BLOCK
+        || cfg->blocks[entry].successor_count != 1
+    ) {
+        return CFG_NO_BLOCK;
+    }
+    return entry;
+}
+
+static void licm_collect_defs(struct licm *licm)
+{
+    size_t i, block;
+    struct tac_node *node;
+
+    for (i = 0; i < licm->cfg.reverse_postorder_length; i++) {
+        block = licm->cfg.reverse_postorder[i];
+        node = licm->cfg.blocks[block].first;
+        for (;;) {
+            if (
+                tac_defines_dest(node->instruction.opcode)
+                && node->instruction.dest->type == SYM_TMP_VAR
+            ) {
+                licm_set_def_block(licm, node->instruction.dest, block);
+            }
+            if (node == licm->cfg.blocks[block].last) {
+                break;
+            }
+            node = node->next;
+        }
+    }
+}
+
+static void licm_loop(struct licm *licm, size_t loop, size_t preheader)
+{
+    size_t i, block;
+    int changed;
+    struct tac_node *node, *next;
+
+    do {
+        changed = 0;
+        for (i = 0; i < licm->cfg.reverse_postorder_length; i++) {
+            block = licm->cfg.reverse_postorder[i];
+            if (!cfg_loop_contains(&licm->cfg, loop, block)) {
+                continue;
+            }
+            node = licm->cfg.blocks[block].first;
+            for (;;) {
+                next = node == licm->cfg.blocks[block].last
+                    ? NULL
+                    : node->next;
+                if (
+                    licm_is_invariant(licm, loop, node->instruction)
+                    && (
+                        !licm_can_trap(node->instruction.opcode)
+                        || licm_executes_always(licm, loop, block)
+                    )
+                    && licm_hoist(licm, block, node, preheader)
+                ) {
+                    changed = 1;
+                }
+                if (next == NULL) {
+                    break;
+                }
+                node = next;
+            }
+        }
+    } while (changed);
+}
+
+static int licm_is_invariant(
+    struct licm *licm,
+    size_t loop,
+    struct tac_instruction instruction
+)
+{
+    size_t i;
+    struct tac_node *node;
+
+    switch (instruction.opcode) {
+        case TAC_MOVE:
+        case TAC_ADD:
+        case TAC_SUB:
+        case TAC_MUL:
+        case TAC_DIV:
+        case TAC_LT:
+        case TAC_GT:
+        case TAC_LE:
+        case TAC_GE:
+        case TAC_EQ:
+        case TAC_NE:
+        case TAC_AND:
+        case TAC_OR:
+        case TAC_XOR:
+        case TAC_SHL:
+        case TAC_SAR:
+        case TAC_ROL:
+        case TAC_SHMUL:
+        case TAC_SHDIV:
+        case TAC_MHDIV:
+        case TAC_NOT:
+        case TAC_COMPL:
+            break;
+
+        case TAC_MOVI:
+            /* the vector must not be written in the loop, even by a call */
+            for (i = 0; i < licm->cfg.loops[loop].block_count; i++) {
+                node = licm->cfg.blocks[licm->cfg.loops[loop].blocks[i]].first;
+                for (;;) {
+                    if (
+                        node->instruction.opcode == TAC_CALL
+                        || (
+                            (
+                                node->instruction.opcode == TAC_MOVV
+                                || node->instruction.opcode == TAC_PSTORE
+                                || node->instruction.opcode == TAC_FILL
+                                || node->instruction.opcode == TAC_COPY
+                            )
+                            && node->instruction.dest == instruction.srcs[0]
+                        )
+                    ) {
+                        return 0;
+                    }
+                    if (
+                        node
+                        == licm->cfg.blocks[licm->cfg.loops[loop].blocks[i]]
+                            .last
+                    ) {
+                        break;
+                    }
+                    node = node->next;
+                }
+            }
+            return instruction.dest->type == SYM_TMP_VAR
+                && licm_is_invariant_operand(licm, loop, instruction.srcs[1]);
+
+        default:
+            return 0;
+    }
+
+    return instruction.dest->type == SYM_TMP_VAR
+        && licm_is_invariant_operand(licm, loop, instruction.srcs[0])
+        && (
+            instruction.srcs[1] == NULL
+            || licm_is_invariant_operand(licm, loop, instruction.srcs[1])
+        );
+}
+
+static int licm_is_invariant_operand(
+    struct licm *licm,
+    size_t loop,
+    struct symbol *symbol
+)
+{
+    size_t block;
+
+    switch (symbol->type) {
+        case SYM_LIT_INT:
+        case SYM_LIT_CHAR:
+        case SYM_LIT_FLOAT:
+            return 1;
+        case SYM_TMP_VAR:
+            block = licm_def_block(licm, symbol);
+            return block != CFG_NO_BLOCK
+                && !cfg_loop_contains(&licm->cfg, loop, block);
+        case SYM_SCALAR_VAR:
+            return is_param(licm->param_count, licm->params, symbol);
+        default:
+            return 0;
+    }
+}
+
+/* a division by zero or an index out of bounds */
+static int licm_can_trap(enum tac_opcode opcode)
+{
+    return opcode == TAC_DIV || opcode == TAC_MOVI;
+}
+
+/*
+ * Tells whether the block runs in every iteration that leaves the loop or
+ * goes back to its header, so that running its instructions ahead of the loop
+ * cannot raise a fault the loop itself would not.
+ */
+static int licm_executes_always(struct licm *licm, size_t loop, size_t block)
+{
+    size_t i, j, other, successor;
+    int leaves_iteration;
+
+    for (i = 0; i < licm->cfg.loops[loop].block_count; i++) {
+        other = licm->cfg.loops[loop].blocks[i];
+        leaves_iteration = licm->cfg.blocks[other].successor_count == 0;
+        for (j = 0; j < licm->cfg.blocks[other].successor_count; j++) {
+            successor = licm->cfg.blocks[other].successors[j];
+            if (
+                successor == licm->cfg.loops[loop].header
+                || !cfg_loop_contains(&licm->cfg, loop, successor)
+            ) {
+                leaves_iteration = 1;
+            }
+        }
+        if (
+            leaves_iteration
+            && !cfg_dominates(&licm->cfg, block, other)
+        ) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/*
+ * Moves the node to the end of the preheader. The blocks never become empty, since they must keep their place in the CFG.
+ */
+static int licm_hoist(
+    struct licm *licm,
+    size_t block,
+    struct tac_node *node,
+    size_t preheader
+)
+{
+    struct tac_instruction instruction;
+    struct cfg_block *from;
+
+    from = &licm->cfg.blocks[block];
+    if (from->first == from->last) {
+        return 0;
+    }
+    if (node == from->first) {
+        from->first = node->next;
+    } else if (node == from->last) {
+        from->last = node->prev;
+    }
+
+    instruction = node->instruction;
+    tac_remove(licm->tac, node);
+    insert_at_block_end(licm->tac, &licm->cfg.blocks[preheader], instruction);
+
+    licm_set_def_block(licm, instruction.dest, preheader);
+    return 1;
+}
+
+static void licm_set_def_block(
+    struct licm *licm,
+    struct symbol *symbol,
+    size_t block
+)
+{
+    size_t index;
+    struct licm_def def;
+
+    index = symbol->data.variable.ssa_index;
+    if (index < licm->def_count && licm->defs[index].symbol == symbol) {
+        licm->defs[index].block = block;
+    } else {
+        def.symbol = symbol;
+        def.block = block;
+        symbol->data.variable.ssa_index = licm->def_count;
+        licm->defs = vector_push(
+            licm->defs,
+            sizeof(*licm->defs),
+            &licm->def_count,
+            &def
+        );
+    }
+}
+
+static size_t licm_def_block(struct licm *licm, struct symbol *symbol)
+{
+    size_t index;
+
+    index = symbol->data.variable.ssa_index;
+    if (index < licm->def_count && licm->defs[index].symbol == symbol) {
+        return licm->defs[index].block;
+    }
+    return CFG_NO_BLOCK;
+}
+
+/*
+ * Replaces multiplications of a basic induction variable by a constant, that
+ * is, of a variable the loop header selects between its initial value and
+ * itself plus or minus a constant, with a new induction variable that grows by
+ * the step times the constant.
+ */
+static void iv_reduce(struct tac *tac)
+{
+    struct tac_node *node;
+
+    node = tac_find_function_start(tac->first);
+    while (node != NULL) {
+        node = iv_reduce_function(tac, node);
+        node = tac_find_function_start(node);
+    }
+}
+
+static struct tac_node *iv_reduce_function(
+    struct tac *tac,
+    struct tac_node *beginfun_node
+)
+{
+    size_t i, preheader;
+    int split;
+    struct cfg cfg;
+    struct tac_node *endfun_node;
+
+    cfg = cfg_build(beginfun_node);
+
+    split = 0;
+    for (i = 0; i < cfg.loop_count; i++) {
+        if (loop_split(tac, &cfg, i)) {
+            split = 1;
+        }
+    }
+    if (split) {
+        cfg_free(cfg);
+        cfg = cfg_build(beginfun_node);
+    }
+
+    for (i = cfg.loop_count; i > 0; i--) {
+        preheader = loop_preheader(&cfg, i - 1);
+        if (preheader != CFG_NO_BLOCK) {
+            iv_reduce_loop(tac, &cfg, i - 1, preheader);
+        }
+    }
+
+    endfun_node = cfg.endfun_node;
+    cfg_free(cfg);
+    return endfun_node;
+}
+
+static void iv_reduce_loop(
+    struct tac *tac,
+    struct cfg *cfg,
+    size_t loop,
+    size_t preheader
+)
+{
+    size_t i, j, k, block, iv_count, derived_count;
+    int uses_next;
+    long factor;
+    struct iv *ivs;
+    struct iv_derived *derived;
+    struct iv_derived new_derived;
+    struct tac_node *node;
+    struct symbol *reduced;
+
+    ivs = iv_collect(cfg, loop);
+    iv_count = 0;
+    while (ivs[iv_count].phi_node != NULL) {
+        iv_count++;
+    }
+    derived = vector_empty(&derived_count);
+
+    for (i = 0; i < cfg->loops[loop].block_count; i++) {
+        block = cfg->loops[loop].blocks[i];
+        node = cfg->blocks[block].first;
+        for (;;) {
+            if (
+                node->instruction.opcode == TAC_MUL
+                && node->instruction.dest->type == SYM_TMP_VAR
+            ) {
+                for (j = 0; j < iv_count; j++) {
+                    if (iv_match_product(
+                        node->instruction,
+                        ivs[j],
+                        &factor,
+                        &uses_next
+                    )) {
+                        break;
+                    }
+                }
+                if (j < iv_count) {
+                    for (k = 0; k < derived_count; k++) {
+                        if (derived[k].iv == j && derived[k].factor == factor) {
+                            break;
+                        }
+                    }
+                    if (k == derived_count) {
+                        new_derived = iv_create(
+                            tac,
+                            cfg,
+                            loop,
+                            preheader,
+                            ivs[j],
+                            factor
+                        );
+                        new_derived.iv = j;
+                        derived = vector_push(
+                            derived,
+                            sizeof(*derived),
+                            &derived_count,
+                            &new_derived
+                        );
+                    }
+                    reduced = uses_next
+                        ? derived[k].next
+                        : derived[k].current;
+                    node->instruction.opcode = TAC_MOVE;
+                    node->instruction.srcs[0] = reduced;
+                    node->instruction.srcs[1] = NULL;
+                }
+            }
+            if (node == cfg->blocks[block].last) {
+                break;
+            }
+            node = node->next;
+        }
+    }
+
+    free(ivs);
+    free(derived);
+}
+
+/*
+ * Finds the basic induction variables of the loop, ending the array with an
+ * entry whose phi node is NULL.
+ */
+static struct iv *iv_collect(struct cfg const *cfg, size_t loop)
+{
+    size_t i, j, header, entry, iv_count;
+    struct iv *ivs;
+    struct iv iv;
+    struct tac_node *node;
+    struct tac_node *step_node;
+    struct symbol *next;
+
+    header = cfg->loops[loop].header;
+    entry = loop_entry(cfg, loop);
+    ivs = vector_empty(&iv_count);
+
+    for (
+        node = cfg->blocks[header].first->next;
+        node != NULL && node->instruction.opcode == TAC_PHI;
+        node = node->next
+    ) {
+        if (node->instruction.dest->data.variable.type != DATATYPE_INTE) {
+            continue;
+        }
+
+        iv.init = NULL;
+        next = NULL;
+        for (i = 0; i < node->instruction.phi_arg_count; i++) {
+            if (cfg->blocks[header].predecessors[i] == entry) {
+                iv.init = node->instruction.phi_args[i];
+            } else if (next == NULL) {
+                next = node->instruction.phi_args[i];
+            } else if (next != node->instruction.phi_args[i]) {
+                next = NULL;
+                break;
+            }
+        }
+        if (next == NULL || next->type != SYM_TMP_VAR || iv.init == NULL) {
+            continue;
+        }
+
+        step_node = NULL;
+        for (i = 0; i < cfg->loops[loop].block_count && step_node == NULL; i++) {
+            iv.step_block = cfg->loops[loop].blocks[i];
+            step_node = cfg->blocks[iv.step_block].first;
+            for (;;) {
+                if (
+                    tac_defines_dest(step_node->instruction.opcode)
+                    && step_node->instruction.dest == next
+                ) {
+                    break;
+                }
+                if (step_node == cfg->blocks[iv.step_block].last) {
+                    step_node = NULL;
+                    break;
+                }
+                step_node = step_node->next;
+            }
+        }
+        if (step_node == NULL) {
+            continue;
+        }
+
+        iv.step_opcode = step_node->instruction.opcode;
+        if (iv.step_opcode != TAC_ADD && iv.step_opcode != TAC_SUB) {
+            continue;
+        }
+        for (j = 0; j < 2; j++) {
+            if (
+                step_node->instruction.srcs[j] == node->instruction.dest
+                && step_node->instruction.srcs[1 - j]->type == SYM_LIT_INT
+                && (iv.step_opcode == TAC_ADD || j == 0)
+            ) {
+                break;
+            }
+        }
+        if (j == 2) {
+            continue;
+        }
+
+        iv.phi_node = node;
+        iv.step_node = step_node;
+        iv.step = step_node->instruction.srcs[1 - j]->data.parsed_int;
+        ivs = vector_push(ivs, sizeof(*ivs), &iv_count, &iv);
+    }
+
+    iv.phi_node = NULL;
+    ivs = vector_push(ivs, sizeof(*ivs), &iv_count, &iv);
+    return ivs;
+}
+
+/*
+ * Tells whether the instruction multiplies the induction variable, before or
+ * after its step, by a constant.
+ */
+static int iv_match_product(
+    struct tac_instruction instruction,
+    struct iv iv,
+    long *factor,
+    int *uses_next
+)
+{
+    size_t i;
+
+    if (instruction.dest->data.variable.type != DATATYPE_INTE) {
+        return 0;
+    }
+
+    for (i = 0; i < 2; i++) {
+        if (instruction.srcs[1 - i]->type != SYM_LIT_INT) {
+            continue;
+        }
+        if (instruction.srcs[i] == iv.phi_node->instruction.dest) {
+            *uses_next = 0;
+        } else if (instruction.srcs[i] == iv.step_node->instruction.dest) {
+            *uses_next = 1;
+        } else {
+            continue;
+        }
+        *factor = instruction.srcs[1 - i]->data.parsed_int;
+        return 1;
+    }
+
+    return 0;
+}
+
+/*
+ * Creates the induction variable holding the given one times the factor: it
+ * starts at the initial value times the factor in the preheader, is selected
+ * by a phi in the header and steps right after the original one.
+ */
+static struct iv_derived iv_create(
+    struct tac *tac,
+    struct cfg *cfg,
+    size_t loop,
+    size_t preheader,
+    struct iv iv,
+    long factor
+)
+{
+    size_t i, header;
+    struct iv_derived derived;
+    struct tac_instruction instruction;
+    struct symbol *init;
+
+    header = cfg->loops[loop].header;
+    derived.factor = factor;
+    derived.current = symbol_table_create_tmp_scalar_var(DATATYPE_INTE);
+    derived.next = symbol_table_create_tmp_scalar_var(DATATYPE_INTE);
+
+    instruction.srcs[1] = NULL;
+    instruction.phi_arg_count = 0;
+    instruction.phi_args = NULL;
+
+    if (iv.init->type == SYM_LIT_INT) {
+        init = symbol_table_create_int_lit(iv.init->data.parsed_int * factor);
+    } else {
+        init = symbol_table_create_tmp_scalar_var(DATATYPE_INTE);
+        instruction.opcode = TAC_MUL;
+        instruction.dest = init;
+        instruction.srcs[0] = iv.init;
+        instruction.srcs[1] = symbol_table_create_int_lit(factor);
+        insert_at_block_end(tac, &cfg->blocks[preheader], instruction);
+    }
+
+    instruction.opcode = TAC_PHI;
+    instruction.dest = derived.current;
+    instruction.srcs[0] = NULL;
+    instruction.srcs[1] = NULL;
+    instruction.phi_arg_count = cfg->blocks[header].predecessor_count;
+    instruction.phi_args = aborting_malloc(
+        sizeof(*instruction.phi_args) * (instruction.phi_arg_count + 1)
+    );
+    for (i = 0; i < instruction.phi_arg_count; i++) {
+        instruction.phi_args[i] =
+            cfg->blocks[header].predecessors[i] == loop_entry(cfg, loop)
+                ? init
+                : derived.next;
+    }
+    tac_insert_after(tac, cfg->blocks[header].first, instruction);
+
+    instruction.opcode = iv.step_opcode;
+    instruction.dest = derived.next;
+    instruction.srcs[0] = derived.current;
+    instruction.srcs[1] = symbol_table_create_int_lit(iv.step * factor);
+    instruction.phi_arg_count = 0;
+    instruction.phi_args = NULL;
+    if (iv.step_node == cfg->blocks[iv.step_block].last) {
+        cfg->blocks[iv.step_block].last =
+            tac_insert_after(tac, iv.step_node, instruction);
+    } else {
+        tac_insert_after(tac, iv.step_node, instruction);
+    }
+
+    return derived;
+}
+
+/* before the jump ending the block, if any */
+static void insert_at_block_end(
+    struct tac *tac,
+    struct cfg_block *block,
+    struct tac_instruction instruction
+)
+{
+    if (
+        block->last->instruction.opcode == TAC_JUMP
+        || block->last->instruction.opcode == TAC_IFZ
+    ) {
+        tac_insert_before(tac, block->last, instruction);
+    } else {
+        block->last = tac_insert_after(tac, block->last, instruction);
+    }
+}
+
+/*
+ * Removes the instructions computing temporaries that are never read, while
+ * the TAC is in SSA form: everything an instruction with side effects reads
+ * is live, and so is everything a live value is computed from.
+ */
+static void dce_values(struct tac *tac)
+{
+    struct tac_node *node;
+
+    node = tac_find_function_start(tac->first);
+    while (node != NULL) {
+        node = dce_values_function(tac, node);
+        node = tac_find_function_start(node);
+    }
+}
+
+static struct tac_node *dce_values_function(
+    struct tac *tac,
+    struct tac_node *beginfun_node
+)
+{
+    size_t i, j, k, index, value_count, worklist_length;
+    size_t *worklist;
+    struct dce_value *values;
+    struct dce_value value;
+    struct tac_node *node;
+    struct tac_node *endfun_node;
+    struct cfg cfg;
+
+    cfg = cfg_build(beginfun_node);
+    values = vector_empty(&value_count);
+    worklist = vector_empty(&worklist_length);
+
+    for (i = 0; i < cfg.reverse_postorder_length; i++) {
+        node = cfg.blocks[cfg.reverse_postorder[i]].first;
+        for (;;) {
+            if (!dce_is_critical(node->instruction)) {
+                index = node->instruction.dest->data.variable.ssa_index;
+                if (
+                    index >= value_count
+                    || values[index].symbol != node->instruction.dest
+                ) {
+                    value.symbol = node->instruction.dest;
+                    value.is_live = 0;
+                    value.defs = vector_empty(&value.def_count);
+                    index = value_count;
+                    node->instruction.dest->data.variable.ssa_index = index;
+                    values = vector_push(
+                        values,
+                        sizeof(*values),
+                        &value_count,
+                        &value
+                    );
+                }
+                values[index].defs = vector_push(
+                    values[index].defs,
+                    sizeof(*values[index].defs),
+                    &values[index].def_count,
+                    &node
+                );
+            }
+            if (node == cfg.blocks[cfg.reverse_postorder[i]].last) {
+                break;
+            }
+            node = node->next;
+        }
+    }
+
+    for (i = 0; i < cfg.reverse_postorder_length; i++) {
+        node = cfg.blocks[cfg.reverse_postorder[i]].first;
+        for (;;) {
+            if (
+                dce_is_critical(node->instruction)
+                && node->instruction.opcode != TAC_LABEL
+            ) {
+                for (j = 0; j < 2; j++) {
+                    dce_mark_live(
+                        value_count,
+                        values,
+                        node->instruction.srcs[j],
+                        &worklist,
+                        &worklist_length
+                    );
+                }
+            }
+            if (node == cfg.blocks[cfg.reverse_postorder[i]].last) {
+                break;
+            }
+            node = node->next;
+        }
+    }
+
+    while (worklist_length > 0) {
+        worklist = vector_pop(
+            worklist,
+            sizeof(*worklist),
+            &worklist_length,
+            &index
+        );
+        for (j = 0; j < values[index].def_count; j++) {
+            node = values[index].defs[j];
+            if (node->instruction.opcode == TAC_PHI) {
+                for (k = 0; k < node->instruction.phi_arg_count; k++) {
+                    dce_mark_live(
+                        value_count,
+                        values,
+                        node->instruction.phi_args[k],
+                        &worklist,
+                        &worklist_length
+                    );
+                }
+            } else {
+                for (k = 0; k < 2; k++) {
+                    dce_mark_live(
+                        value_count,
+                        values,
+                        node->instruction.srcs[k],
+                        &worklist,
+                        &worklist_length
+                    );
+                }
+            }
+        }
+    }
+
+    endfun_node = cfg.endfun_node;
+    cfg_free(cfg);
+
+    for (i = 0; i < value_count; i++) {
+        if (!values[i].is_live) {
+            for (j = 0; j < values[i].def_count; j++) {
+                tac_remove(tac, values[i].defs[j]);
+            }
+        }
+        free(values[i].defs);
+    }
+    free(values);
+    free(worklist);
+
+    return endfun_node;
+}
+
+/*
+ * Calls and reads must happen even if their result is dropped, and scalar
+ * variables are visible outside of the function.
+ */
+static int dce_is_critical(struct tac_instruction instruction)
+{
+    switch (instruction.opcode) {
+        case TAC_CALL:
+        case TAC_READ:
+        case TAC_DEFP:
+            return 1;
+        default:
+            return !tac_defines_dest(instruction.opcode)
+                || instruction.dest->type != SYM_TMP_VAR;
+    }
+}
+
+static void dce_mark_live(
+    size_t value_count,
+    struct dce_value *values,
+    struct symbol *symbol,
+    size_t **worklist,
+    size_t *worklist_length
+)
+{
+    size_t index;
+
+    if (symbol == NULL || symbol->type != SYM_TMP_VAR) {
+        return;
+    }
+
+    index = symbol->data.variable.ssa_index;
+    if (
+        index < value_count
+        && values[index].symbol == symbol
+        && !values[index].is_live
+    ) {
+        values[index].is_live = 1;
+        *worklist = vector_push(
+            *worklist,
+            sizeof(**worklist),
+            worklist_length,
+            &index
+        );
+    }
+}
+
+/*
+ * Removes unreachable blocks, jumps to the instruction right after them and
+ * labels nothing jumps to, until none is left.
+ */
+static void dce_control(struct tac *tac)
+{
+    struct tac_node *node;
+
+    node = tac_find_function_start(tac->first);
+    while (node != NULL) {
+        node = dce_control_function(tac, node);
+        node = tac_find_function_start(node);
+    }
+}
+
+static struct tac_node *dce_control_function(
+    struct tac *tac,
+    struct tac_node *beginfun_node
+)
+{
+    int changed;
+    struct tac_node *node;
+
+    do {
+        changed = dce_unreachable_blocks(tac, beginfun_node);
+        changed = dce_jumps_to_next(tac, beginfun_node) || changed;
+        changed = dce_unused_labels(tac, beginfun_node) || changed;
+    } while (changed);
+
+    node = beginfun_node;
+    while (node->instruction.opcode != TAC_ENDFUN) {
+        node = node->next;
+    }
+    return node;
+}
+
+static int dce_unreachable_blocks(
+    struct tac *tac,
+    struct tac_node *beginfun_node
+)
+{
+    size_t i;
+    int changed;
+    struct tac_node *node;
+    struct tac_node *next;
+    struct tac_node *end;
+    struct cfg cfg;
+
+    changed = 0;
+    cfg = cfg_build(beginfun_node);
+
+    for (i = 0; i < cfg.block_count; i++) {
+        if (cfg.blocks[i].postorder_index != CFG_NO_BLOCK) {
+            continue;
+        }
+        changed = 1;
+        node = cfg.blocks[i].first;
+        end = cfg.blocks[i].last->next;
+        while (node != end) {
+            next = node->next;
+            tac_remove(tac, node);
+            node = next;
+        }
+    }
+
+    cfg_free(cfg);
+    return changed;
+}
+
+static int dce_jumps_to_next(
+    struct tac *tac,
+    struct tac_node *beginfun_node
+)
+{
+    int changed;
+    struct tac_node *node;
+    struct tac_node *next;
+    struct tac_node *following;
+
+    changed = 0;
+
+    for (
+        node = beginfun_node;
+        node->instruction.opcode != TAC_ENDFUN;
+        node = next
+    ) {
+        next = node->next;
+        if (
+            node->instruction.opcode != TAC_JUMP
+            && node->instruction.opcode != TAC_IFZ
+        ) {
+            continue;
+        }
+        following = node->next;
+        while (
+            following->instruction.opcode == TAC_LABEL
+            && following->instruction.srcs[0] != node->instruction.dest
+        ) {
+            following = following->next;
+        }
+        if (
+            following->instruction.opcode == TAC_LABEL
+            && following->instruction.srcs[0] == node->instruction.dest
+        ) {
+            tac_remove(tac, node);
+            changed = 1;
+        }
+    }
+
+    return changed;
+}
+
+static int dce_unused_labels(
+    struct tac *tac,
+    struct tac_node *beginfun_node
+)
+{
+    size_t i, target_count;
+    int changed, is_used;
+    struct symbol **targets;
+    struct tac_node *node;
+    struct tac_node *next;
+
+    changed = 0;
+    targets = vector_empty(&target_count);
+
+    for (
+        node = beginfun_node;
+        node->instruction.opcode != TAC_ENDFUN;
+        node = node->next
+    ) {
+        if (
+            node->instruction.opcode == TAC_JUMP
+            || node->instruction.opcode == TAC_IFZ
+        ) {
+            targets = vector_push(
+                targets,
+                sizeof(*targets),
+                &target_count,
+                &node->instruction.dest
+            );
+        }
+    }
+
+    for (
+        node = beginfun_node;
+        node->instruction.opcode != TAC_ENDFUN;
+        node = next
+    ) {
+        next = node->next;
+        if (node->instruction.opcode != TAC_LABEL) {
+            continue;
+        }
+        is_used = 0;
+        for (i = 0; !is_used && i < target_count; i++) {
+            is_used = targets[i] == node->instruction.srcs[0];
+        }
+        if (!is_used) {
+            tac_remove(tac, node);
+            changed = 1;
+        }
+    }
+
+    free(targets);
+    return changed;
+}
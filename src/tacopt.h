@@ -5,13 +5,40 @@
 
 #define TAC_OPT_POWER_OF_TWO (1U << 0)
 #define TAC_OPT_REUSE_TMPS (1U << 1)
+#define TAC_OPT_SSA (1U << 2)
+#define TAC_OPT_CONST_PROP (1U << 3)
+#define TAC_OPT_DCE (1U << 4)
+#define TAC_OPT_GVN (1U << 5)
+#define TAC_OPT_LICM (1U << 6)
+#define TAC_OPT_STRENGTH_REDUCE (1U << 7)
+#define TAC_OPT_INLINE (1U << 8)
+#define TAC_OPT_MERGE_PRINTS (1U << 9)
+#define TAC_OPT_UNROLL_LOOPS (1U << 10)
+#define TAC_OPT_VECTORIZE (1U << 11)
+#define TAC_OPT_LOOP_IDIOMS (1U << 12)
+#define TAC_OPT_MAGIC_DIV (1U << 13)
 
 #define TAC_OPT_OFF 0
 
 #define TAC_OPT_FULL (~0U)
 
+#define TAC_OPT_DEFAULT_INLINE_LIMIT 40
+
+#define TAC_OPT_DEFAULT_UNROLL_FACTOR 4
+
 typedef unsigned tac_opt_flags_type;
 
-void optimize_tac(struct tac *tac, tac_opt_flags_type flags);
+struct tac_opt_params {
+    /* largest function body, in instructions, that gets inlined */
+    size_t inline_limit;
+    /* bodies per test when unrolling loops of unknown trip count */
+    size_t unroll_factor;
+};
+
+void optimize_tac(
+    struct tac *tac,
+    tac_opt_flags_type flags,
+    struct tac_opt_params params
+);
 
 #endif
@@ -11,6 +11,8 @@ enum semantic_type datatype_to_semantic_type(enum datatype datatype)
             return SEMANTIC_CHAR;
         case DATATYPE_REAL:
             return SEMANTIC_FLOAT;
+        case DATATYPE_NATU:
+            return SEMANTIC_NAT;
     }
     panic("unimplemented datatype %i's conversion to semantic type", datatype);
 }
@@ -25,6 +27,8 @@ enum datatype semantic_type_to_datatype(enum semantic_type semantic_type)
             return DATATYPE_INTE;
         case SEMANTIC_FLOAT:
             return DATATYPE_REAL;
+        case SEMANTIC_NAT:
+            return DATATYPE_NATU;
     }
     panic(
         "unimplemented semantic_type %i's conversion to datatype",
@@ -49,6 +53,7 @@ char const *semantic_type_to_str(enum semantic_type semantic_type)
         case SEMANTIC_CHAR: return "cara";
         case SEMANTIC_FLOAT: return "real";
         case SEMANTIC_BOOL: return "<bool>";
+        case SEMANTIC_NAT: return "natu";
     }
     panic("unimplemented semantic_type %i's rendering", semantic_type);
 }
@@ -56,8 +61,17 @@ char const *semantic_type_to_str(enum semantic_type semantic_type)
 int semantic_type_equiv(enum semantic_type type_a, enum semantic_type type_b)
 {
     return type_a == type_b
-        || (type_a == SEMANTIC_INT && type_b == SEMANTIC_CHAR)
-        || (type_a == SEMANTIC_CHAR && type_b == SEMANTIC_INT);
+        || (
+            semantic_type_is_integer(type_a)
+            && semantic_type_is_integer(type_b)
+        );
+}
+
+int semantic_type_is_integer(enum semantic_type semantic_type)
+{
+    return semantic_type == SEMANTIC_INT
+        || semantic_type == SEMANTIC_CHAR
+        || semantic_type == SEMANTIC_NAT;
 }
 
 int semantic_type_unify(
@@ -71,6 +85,15 @@ int semantic_type_unify(
         return 1;
     }
 
+    /* natu wins over the other integers, which wrap into it */
+    if (
+        (type_a == SEMANTIC_NAT && semantic_type_is_integer(type_b))
+        || (type_b == SEMANTIC_NAT && semantic_type_is_integer(type_a))
+    ) {
+        *type_out = SEMANTIC_NAT;
+        return 1;
+    }
+
     if (
         (type_a == SEMANTIC_INT && type_b == SEMANTIC_CHAR)
         || (type_a == SEMANTIC_CHAR && type_b == SEMANTIC_INT)
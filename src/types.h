@@ -4,14 +4,19 @@
 enum datatype {
     DATATYPE_INTE,
     DATATYPE_CARA,
-    DATATYPE_REAL
+    DATATYPE_REAL,
+    DATATYPE_NATU
 };
 
+/** natu values are 32-bit unsigned, kept reduced modulo 2^32. */
+#define DATATYPE_NATU_MASK 0xffffffffUL
+
 enum semantic_type {
     SEMANTIC_INT,
     SEMANTIC_CHAR,
     SEMANTIC_FLOAT,
-    SEMANTIC_BOOL
+    SEMANTIC_BOOL,
+    SEMANTIC_NAT
 };
 
 enum inference_status {
@@ -42,6 +47,8 @@ char const *semantic_type_to_str(enum semantic_type semantic_type);
 
 int semantic_type_equiv(enum semantic_type type_a, enum semantic_type type_b);
 
+int semantic_type_is_integer(enum semantic_type semantic_type);
+
 int semantic_type_unify(
     enum semantic_type type_a,
     enum semantic_type type_b,
@@ -0,0 +1,568 @@
+#include <limits.h>
+#include <stdlib.h>
+#include "unroll.h"
+#include "symboltable.h"
+#include "vector.h"
+
+/* largest number of instructions the copies of a single loop body may take */
+#define UNROLL_SIZE_LIMIT 256
+
+/*
+ * The shape generated for a while statement, with the counter stepped right
+ * before the back edge:
+ *
+ *   head:  compare t, counter, bound
+ *          ifz exit, t
+ *          ...body...
+ *          step counter, counter, constant
+ *          jump head
+ *   exit:
+ */
+struct unroll_loop {
+    struct tac_node *head;
+    struct tac_node *compare;
+    struct tac_node *exit_branch;
+    struct tac_node *step;
+    struct tac_node *back_jump;
+    struct symbol *counter;
+    struct symbol *bound;
+    /* the comparison with the counter as its left operand */
+    enum tac_opcode comparison;
+    long step_value;
+    /* instructions of the body, step included */
+    size_t body_size;
+};
+
+struct unroll_rename {
+    struct symbol *from;
+    struct symbol *to;
+};
+
+static int match_loop(
+    struct tac_node *function_start,
+    struct tac_node *back_jump,
+    struct unroll_loop *loop
+);
+
+static int match_step(struct unroll_loop *loop);
+
+static int match_comparison(struct unroll_loop *loop);
+
+static int is_int_var(struct symbol *symbol);
+
+static size_t count_references(
+    struct tac_node *function_start,
+    struct symbol *symbol
+);
+
+static int full_trip_count(
+    struct tac_node *function_start,
+    struct unroll_loop const *loop,
+    size_t *trip_count
+);
+
+static int comparison_holds(enum tac_opcode opcode, long left, long right);
+
+static void unroll_fully(
+    struct tac *tac,
+    struct unroll_loop const *loop,
+    size_t trip_count
+);
+
+static void unroll_partially(
+    struct tac *tac,
+    struct unroll_loop const *loop,
+    size_t factor
+);
+
+static void copy_body(
+    struct tac *tac,
+    struct unroll_loop const *loop,
+    struct tac_node *before
+);
+
+static struct symbol *rename_label(
+    struct unroll_rename const *renames,
+    size_t rename_count,
+    struct symbol *symbol
+);
+
+void unroll_loops(struct tac *tac, size_t factor)
+{
+    size_t trip_count;
+    struct unroll_loop loop;
+    struct tac_node *node, *next, *function_start;
+
+    function_start = NULL;
+    for (node = tac->first; node != NULL; node = next) {
+        next = node->next;
+        if (node->instruction.opcode == TAC_BEGINFUN) {
+            function_start = node;
+        } else if (
+            node->instruction.opcode == TAC_JUMP
+            && function_start != NULL
+            && match_loop(function_start, node, &loop)
+        ) {
+            if (full_trip_count(function_start, &loop, &trip_count)) {
+                unroll_fully(tac, &loop, trip_count);
+            } else if (factor >= 2) {
+                unroll_partially(tac, &loop, factor);
+            }
+        }
+    }
+}
+
+static int match_loop(
+    struct tac_node *function_start,
+    struct tac_node *back_jump,
+    struct unroll_loop *loop
+)
+{
+    int has_call;
+    struct tac_node *node;
+
+    loop->back_jump = back_jump;
+    loop->head = back_jump->prev;
+    while (
+        loop->head != function_start
+        && (
+            loop->head->instruction.opcode != TAC_LABEL
+            || loop->head->instruction.srcs[0] != back_jump->instruction.dest
+        )
+    ) {
+        loop->head = loop->head->prev;
+    }
+    if (loop->head == function_start) {
+        return 0;
+    }
+
+    loop->compare = loop->head->next;
+    loop->exit_branch = loop->compare->next;
+    loop->step = back_jump->prev;
+    if (
+        loop->compare == back_jump
+        || loop->exit_branch == back_jump
+        || loop->step == loop->exit_branch
+        || loop->exit_branch->instruction.opcode != TAC_IFZ
+        || loop->compare->instruction.dest == NULL
+        || loop->compare->instruction.dest->type != SYM_TMP_VAR
+        || loop->exit_branch->instruction.srcs[0]
+            != loop->compare->instruction.dest
+        || back_jump->next == NULL
+        || back_jump->next->instruction.opcode != TAC_LABEL
+        || back_jump->next->instruction.srcs[0]
+            != loop->exit_branch->instruction.dest
+        || !match_step(loop)
+        || !match_comparison(loop)
+    ) {
+        return 0;
+    }
+
+    /* the loop must be entered from above and the test used only to exit */
+    if (
+        count_references(function_start, loop->head->instruction.srcs[0]) != 2
+        || count_references(function_start, loop->compare->instruction.dest)
+            != 2
+    ) {
+        return 0;
+    }
+
+    has_call = 0;
+    loop->body_size = 1;
+    for (
+        node = loop->exit_branch->next;
+        node != loop->step;
+        node = node->next
+    ) {
+        if (
+            tac_defines_dest(node->instruction.opcode)
+            && (
+                node->instruction.dest == loop->counter
+                || node->instruction.dest == loop->bound
+            )
+        ) {
+            return 0;
+        }
+        if (node->instruction.opcode == TAC_CALL) {
+            has_call = 1;
+        }
+        if (node->instruction.opcode != TAC_LABEL) {
+            loop->body_size++;
+        }
+    }
+
+    /* a call may change any global variable */
+    return !has_call || (
+        loop->counter->type == SYM_TMP_VAR
+        && loop->bound->type != SYM_SCALAR_VAR
+    );
+}
+
+static int match_step(struct unroll_loop *loop)
+{
+    struct tac_instruction step;
+
+    step = loop->step->instruction;
+    loop->counter = step.dest;
+    if (
+        (step.opcode != TAC_ADD && step.opcode != TAC_SUB)
+        || !is_int_var(loop->counter)
+    ) {
+        return 0;
+    }
+
+    if (
+        step.srcs[0] == loop->counter
+        && step.srcs[1]->type == SYM_LIT_INT
+    ) {
+        loop->step_value = step.srcs[1]->data.parsed_int;
+    } else if (
+        step.opcode == TAC_ADD
+        && step.srcs[1] == loop->counter
+        && step.srcs[0]->type == SYM_LIT_INT
+    ) {
+        loop->step_value = step.srcs[0]->data.parsed_int;
+    } else {
+        return 0;
+    }
+
+    if (step.opcode == TAC_SUB) {
+        if (loop->step_value == LONG_MIN) {
+            return 0;
+        }
+        loop->step_value = -loop->step_value;
+    }
+
+    return loop->step_value != 0;
+}
+
+static int match_comparison(struct unroll_loop *loop)
+{
+    struct tac_instruction compare;
+
+    compare = loop->compare->instruction;
+    if (
+        compare.srcs[0] == loop->counter
+        && compare.srcs[1] != loop->counter
+    ) {
+        loop->bound = compare.srcs[1];
+        loop->comparison = compare.opcode;
+    } else if (
+        compare.srcs[1] == loop->counter
+        && compare.srcs[0] != loop->counter
+    ) {
+        loop->bound = compare.srcs[0];
+        switch (compare.opcode) {
+            case TAC_LT:
+                loop->comparison = TAC_GT;
+                break;
+            case TAC_LE:
+                loop->comparison = TAC_GE;
+                break;
+            case TAC_GT:
+                loop->comparison = TAC_LT;
+                break;
+            case TAC_GE:
+                loop->comparison = TAC_LE;
+                break;
+            default:
+                loop->comparison = compare.opcode;
+                break;
+        }
+    } else {
+        return 0;
+    }
+
+    switch (loop->comparison) {
+        case TAC_LT:
+        case TAC_LE:
+        case TAC_GT:
+        case TAC_GE:
+        case TAC_NE:
+            break;
+        default:
+            return 0;
+    }
+
+    return loop->bound->type == SYM_LIT_INT || is_int_var(loop->bound);
+}
+
+static int is_int_var(struct symbol *symbol)
+{
+    return symbol != NULL
+        && (symbol->type == SYM_TMP_VAR || symbol->type == SYM_SCALAR_VAR)
+        && symbol->data.variable.type == DATATYPE_INTE;
+}
+
+static size_t count_references(
+    struct tac_node *function_start,
+    struct symbol *symbol
+)
+{
+    size_t count;
+    struct tac_node *node;
+
+    count = 0;
+    for (
+        node = function_start;
+        node->instruction.opcode != TAC_ENDFUN;
+        node = node->next
+    ) {
+        count += node->instruction.dest == symbol;
+        count += node->instruction.srcs[0] == symbol;
+        count += node->instruction.srcs[1] == symbol;
+    }
+    return count;
+}
+
+/*
+ * Runs the counter from its initial value, which must be a constant assigned
+ * in the block right before the loop, until the test fails, giving up once
+ * the copies would not fit in the size limit.
+ */
+static int full_trip_count(
+    struct tac_node *function_start,
+    struct unroll_loop const *loop,
+    size_t *trip_count
+)
+{
+    long value, bound;
+    struct tac_node *node;
+
+    if (loop->bound->type != SYM_LIT_INT) {
+        return 0;
+    }
+    bound = loop->bound->data.parsed_int;
+
+    node = loop->head->prev;
+    while (
+        node != function_start
+        && !(
+            tac_defines_dest(node->instruction.opcode)
+            && node->instruction.dest == loop->counter
+        )
+    ) {
+        if (tac_is_block_boundary(node->instruction.opcode)) {
+            return 0;
+        }
+        node = node->prev;
+    }
+    if (
+        node == function_start
+        || node->instruction.opcode != TAC_MOVE
+        || node->instruction.srcs[0]->type != SYM_LIT_INT
+    ) {
+        return 0;
+    }
+    value = node->instruction.srcs[0]->data.parsed_int;
+
+    *trip_count = 0;
+    while (comparison_holds(loop->comparison, value, bound)) {
+        if ((*trip_count + 1) * loop->body_size > UNROLL_SIZE_LIMIT) {
+            return 0;
+        }
+        (*trip_count)++;
+        value = (long) ((unsigned long) value + loop->step_value);
+    }
+    return 1;
+}
+
+static int comparison_holds(enum tac_opcode opcode, long left, long right)
+{
+    switch (opcode) {
+        case TAC_LT:
+            return left < right;
+        case TAC_LE:
+            return left <= right;
+        case TAC_GT:
+            return left > right;
+        case TAC_GE:
+            return left >= right;
+        default:
+            return left != right;
+    }
+}
+
+static void unroll_fully(
+    struct tac *tac,
+    struct unroll_loop const *loop,
+    size_t trip_count
+)
+{
+    size_t i;
+    struct tac_node *node, *next;
+
+    for (i = 0; i < trip_count; i++) {
+        copy_body(tac, loop, loop->head);
+    }
+
+    node = loop->head;
+    while (node != loop->back_jump) {
+        next = node->next;
+        tac_remove(tac, node);
+        node = next;
+    }
+    tac_remove(tac, loop->back_jump);
+}
+
+/*
+ * Runs factor bodies at once while the counter would still pass the test after
+ * factor - 1 steps, leaving the original loop for the remaining iterations. The
+ * counter only moves towards the bound, so every value in between passes the
+ * test as well.
+ */
+static void unroll_partially(
+    struct tac *tac,
+    struct unroll_loop const *loop,
+    size_t factor
+)
+{
+    size_t i;
+    struct tac_instruction instruction;
+    struct symbol *block_label, *last, *test;
+
+    switch (loop->comparison) {
+        case TAC_LT:
+        case TAC_LE:
+            if (loop->step_value < 0) {
+                return;
+            }
+            break;
+        case TAC_GT:
+        case TAC_GE:
+            if (loop->step_value > 0) {
+                return;
+            }
+            break;
+        default:
+            return;
+    }
+
+    while (factor * loop->body_size > UNROLL_SIZE_LIMIT) {
+        factor--;
+    }
+    if (
+        factor < 2
+        || loop->step_value > LONG_MAX / (long) (factor - 1)
+        || loop->step_value < -(LONG_MAX / (long) (factor - 1))
+    ) {
+        return;
+    }
+
+    block_label = symbol_table_create_tmp_label();
+    last = symbol_table_create_tmp_scalar_var(DATATYPE_INTE);
+    test = symbol_table_create_tmp_scalar_var(
+        loop->compare->instruction.dest->data.variable.type
+    );
+    instruction.phi_arg_count = 0;
+    instruction.phi_args = NULL;
+
+    instruction.opcode = TAC_LABEL;
+    instruction.dest = NULL;
+    instruction.srcs[0] = block_label;
+    instruction.srcs[1] = NULL;
+    tac_insert_before(tac, loop->head, instruction);
+
+    instruction.opcode = TAC_ADD;
+    instruction.dest = last;
+    instruction.srcs[0] = loop->counter;
+    instruction.srcs[1] = symbol_table_create_int_lit(
+        loop->step_value * (long) (factor - 1)
+    );
+    tac_insert_before(tac, loop->head, instruction);
+
+    instruction.opcode = loop->comparison;
+    instruction.dest = test;
+    instruction.srcs[0] = last;
+    instruction.srcs[1] = loop->bound;
+    tac_insert_before(tac, loop->head, instruction);
+
+    instruction.opcode = TAC_IFZ;
+    instruction.dest = loop->head->instruction.srcs[0];
+    instruction.srcs[0] = test;
+    instruction.srcs[1] = NULL;
+    tac_insert_before(tac, loop->head, instruction);
+
+    for (i = 0; i < factor; i++) {
+        copy_body(tac, loop, loop->head);
+    }
+
+    instruction.opcode = TAC_JUMP;
+    instruction.dest = block_label;
+    instruction.srcs[0] = NULL;
+    instruction.srcs[1] = NULL;
+    tac_insert_before(tac, loop->head, instruction);
+}
+
+/*
+ * Copies the body and the step. Labels defined in the body get fresh ones in
+ * each copy, temporaries are shared, as the iterations already share them.
+ */
+static void copy_body(
+    struct tac *tac,
+    struct unroll_loop const *loop,
+    struct tac_node *before
+)
+{
+    size_t rename_count;
+    struct unroll_rename *renames;
+    struct unroll_rename rename;
+    struct tac_instruction instruction;
+    struct tac_node *node;
+
+    renames = vector_empty(&rename_count);
+    for (
+        node = loop->exit_branch->next;
+        node != loop->step;
+        node = node->next
+    ) {
+        if (node->instruction.opcode == TAC_LABEL) {
+            rename.from = node->instruction.srcs[0];
+            rename.to = symbol_table_create_tmp_label();
+            renames = vector_push(
+                renames,
+                sizeof(*renames),
+                &rename_count,
+                &rename
+            );
+        }
+    }
+
+    instruction.phi_arg_count = 0;
+    instruction.phi_args = NULL;
+    node = loop->exit_branch;
+    do {
+        node = node->next;
+        instruction.opcode = node->instruction.opcode;
+        instruction.dest = rename_label(
+            renames,
+            rename_count,
+            node->instruction.dest
+        );
+        instruction.srcs[0] = rename_label(
+            renames,
+            rename_count,
+            node->instruction.srcs[0]
+        );
+        instruction.srcs[1] = node->instruction.srcs[1];
+        tac_insert_before(tac, before, instruction);
+    } while (node != loop->step);
+
+    free(renames);
+}
+
+static struct symbol *rename_label(
+    struct unroll_rename const *renames,
+    size_t rename_count,
+    struct symbol *symbol
+)
+{
+    size_t i;
+
+    for (i = 0; i < rename_count; i++) {
+        if (renames[i].from == symbol) {
+            return renames[i].to;
+        }
+    }
+    return symbol;
+}
@@ -0,0 +1,18 @@
+#ifndef UNROLL_H_
+#define UNROLL_H_ 1
+
+#include <stddef.h>
+#include "tac.h"
+
+/**
+ * Unrolls the counted loops produced by the while statement. A loop whose
+ * counter starts at a constant, is compared against a constant and is stepped
+ * by a constant once per iteration is replaced by a copy of its body for each
+ * iteration when that is small enough. Otherwise, a counter compared against
+ * a value the body does not change gets a copy of the loop running factor
+ * bodies per test, followed by the original loop for the remaining iterations.
+ * A factor smaller than two disables the latter.
+ */
+void unroll_loops(struct tac *tac, size_t factor);
+
+#endif
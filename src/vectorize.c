@@ -0,0 +1,948 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include "vectorize.h"
+#include "symboltable.h"
+#include "vector.h"
+
+/*
+ * The shape generated for a while statement, with the counter stepped by one
+ * right before the back edge:
+ *
+ *   head:  compare t, counter, bound
+ *          ifz exit, t
+ *          ...body...
+ *          add counter, counter, 1
+ *          jump head
+ *   exit:
+ */
+struct vectorize_loop {
+    struct tac_node *head;
+    struct tac_node *compare;
+    struct tac_node *exit_branch;
+    struct tac_node *step;
+    struct tac_node *back_jump;
+    struct symbol *counter;
+    struct symbol *bound;
+    /* the comparison with the counter as its left operand */
+    enum tac_opcode comparison;
+    /* shared by every vector the body indexes */
+    enum datatype element_type;
+    int has_element_type;
+};
+
+enum vectorize_value_kind {
+    /* computed for each element in the body */
+    VECTORIZE_LANE,
+    /* the same for every element, filled before the loop */
+    VECTORIZE_SPLAT,
+    /* partial sums of a reduction, added up after the loop */
+    VECTORIZE_SUM
+};
+
+struct vectorize_value {
+    enum vectorize_value_kind kind;
+    /* the invariant or the reduced variable, unused by lanes */
+    struct symbol *scalar;
+    /* the addition or subtraction reducing into the variable */
+    enum tac_opcode reduction;
+    /* index of the last operation reading a lane */
+    size_t last_use;
+    size_t slot;
+    struct symbol *packed;
+};
+
+/* temporary defined in the body, several may take the same value */
+struct vectorize_name {
+    struct symbol *scalar;
+    size_t value;
+};
+
+/* instruction of the packed body, with values as operands */
+struct vectorize_op {
+    enum tac_opcode opcode;
+    struct symbol *vector;
+    size_t dest;
+    size_t srcs[2];
+};
+
+struct vectorize_plan {
+    struct vectorize_value *values;
+    size_t value_count;
+    struct vectorize_name *names;
+    size_t name_count;
+    struct vectorize_op *ops;
+    size_t op_count;
+};
+
+static int match_loop(
+    struct tac_node *function_start,
+    struct tac_node *back_jump,
+    struct vectorize_loop *loop
+);
+
+static int match_comparison(struct vectorize_loop *loop);
+
+static int is_int_var(struct symbol *symbol);
+
+static size_t count_references(
+    struct tac_node *first,
+    struct tac_node *last,
+    struct symbol *symbol
+);
+
+static int is_defined_in_body(
+    struct vectorize_loop const *loop,
+    struct symbol *symbol
+);
+
+static int plan_body(
+    struct tac_node *function_start,
+    struct vectorize_loop *loop,
+    struct vectorize_plan *plan
+);
+
+static int plan_instruction(
+    struct vectorize_loop *loop,
+    struct vectorize_plan *plan,
+    struct tac_instruction instruction
+);
+
+static int plan_element_type(
+    struct vectorize_loop *loop,
+    struct symbol *vector
+);
+
+static int plan_operand(
+    struct vectorize_loop const *loop,
+    struct vectorize_plan *plan,
+    struct symbol *symbol,
+    size_t *value
+);
+
+static int plan_name(
+    struct vectorize_loop const *loop,
+    struct vectorize_plan *plan,
+    struct symbol *symbol,
+    size_t value
+);
+
+static size_t plan_value(
+    struct vectorize_plan *plan,
+    enum vectorize_value_kind kind,
+    struct symbol *scalar
+);
+
+static void plan_op(
+    struct vectorize_plan *plan,
+    enum tac_opcode opcode,
+    struct symbol *vector,
+    size_t dest,
+    size_t left,
+    size_t right
+);
+
+static int plan_slots(struct vectorize_plan *plan);
+
+static int packed_opcode(
+    enum datatype element_type,
+    enum tac_opcode opcode,
+    enum tac_opcode *packed
+);
+
+static int fits_lane(enum datatype element_type, enum datatype datatype);
+
+static size_t datatype_size(enum datatype datatype);
+
+static void plan_free(struct vectorize_plan *plan);
+
+static void vectorize_loop(
+    struct tac *tac,
+    struct vectorize_loop const *loop,
+    struct vectorize_plan *plan
+);
+
+static void insert_instruction(
+    struct tac *tac,
+    struct tac_node *before,
+    enum tac_opcode opcode,
+    struct symbol *dest,
+    struct symbol *left,
+    struct symbol *right
+);
+
+void vectorize_loops(struct tac *tac)
+{
+    struct vectorize_loop loop;
+    struct vectorize_plan plan;
+    struct tac_node *node, *next, *function_start;
+
+    function_start = NULL;
+    for (node = tac->first; node != NULL; node = next) {
+        next = node->next;
+        if (node->instruction.opcode == TAC_BEGINFUN) {
+            function_start = node;
+        } else if (
+            node->instruction.opcode == TAC_JUMP
+            && function_start != NULL
+            && match_loop(function_start, node, &loop)
+        ) {
+            if (plan_body(function_start, &loop, &plan)) {
+                vectorize_loop(tac, &loop, &plan);
+            }
+            plan_free(&plan);
+        }
+    }
+}
+
+static int match_loop(
+    struct tac_node *function_start,
+    struct tac_node *back_jump,
+    struct vectorize_loop *loop
+)
+{
+    struct tac_instruction step;
+
+    loop->back_jump = back_jump;
+    loop->head = back_jump->prev;
+    while (
+        loop->head != function_start
+        && (
+            loop->head->instruction.opcode != TAC_LABEL
+            || loop->head->instruction.srcs[0] != back_jump->instruction.dest
+        )
+    ) {
+        loop->head = loop->head->prev;
+    }
+    if (loop->head == function_start) {
+        return 0;
+    }
+
+    loop->compare = loop->head->next;
+    loop->exit_branch = loop->compare->next;
+    loop->step = back_jump->prev;
+    if (
+        loop->compare == back_jump
+        || loop->exit_branch == back_jump
+        || loop->step == loop->exit_branch
+        || loop->exit_branch->instruction.opcode != TAC_IFZ
+        || loop->compare->instruction.dest == NULL
+        || loop->compare->instruction.dest->type != SYM_TMP_VAR
+        || loop->exit_branch->instruction.srcs[0]
+            != loop->compare->instruction.dest
+        || back_jump->next == NULL
+        || back_jump->next->instruction.opcode != TAC_LABEL
+        || back_jump->next->instruction.srcs[0]
+            != loop->exit_branch->instruction.dest
+    ) {
+        return 0;
+    }
+
+    step = loop->step->instruction;
+    loop->counter = step.dest;
+    if (
+        step.opcode != TAC_ADD
+        || !is_int_var(loop->counter)
+        || step.srcs[0] != loop->counter
+        || step.srcs[1]->type != SYM_LIT_INT
+        || step.srcs[1]->data.parsed_int != 1
+        || !match_comparison(loop)
+    ) {
+        return 0;
+    }
+
+    /* the loop must be entered from above and the test used only to exit */
+    return count_references(
+            function_start,
+            NULL,
+            loop->head->instruction.srcs[0]
+        ) == 2
+        && count_references(
+            function_start,
+            NULL,
+            loop->compare->instruction.dest
+        ) == 2
+        && !is_defined_in_body(loop, loop->bound);
+}
+
+static int match_comparison(struct vectorize_loop *loop)
+{
+    struct tac_instruction compare;
+
+    compare = loop->compare->instruction;
+    if (
+        compare.srcs[0] == loop->counter
+        && compare.srcs[1] != loop->counter
+    ) {
+        loop->bound = compare.srcs[1];
+        loop->comparison = compare.opcode;
+    } else if (
+        compare.srcs[1] == loop->counter
+        && compare.srcs[0] != loop->counter
+    ) {
+        loop->bound = compare.srcs[0];
+        switch (compare.opcode) {
+            case TAC_GT:
+                loop->comparison = TAC_LT;
+                break;
+            case TAC_GE:
+                loop->comparison = TAC_LE;
+                break;
+            default:
+                return 0;
+        }
+    } else {
+        return 0;
+    }
+
+    return (loop->comparison == TAC_LT || loop->comparison == TAC_LE)
+        && (loop->bound->type == SYM_LIT_INT || is_int_var(loop->bound));
+}
+
+static int is_int_var(struct symbol *symbol)
+{
+    return symbol != NULL
+        && (symbol->type == SYM_TMP_VAR || symbol->type == SYM_SCALAR_VAR)
+        && symbol->data.variable.type == DATATYPE_INTE;
+}
+
+/* counts from first up to last, or up to the end of the function */
+static size_t count_references(
+    struct tac_node *first,
+    struct tac_node *last,
+    struct symbol *symbol
+)
+{
+    size_t count;
+    struct tac_node *node;
+
+    count = 0;
+    for (
+        node = first;
+        node != last && node->instruction.opcode != TAC_ENDFUN;
+        node = node->next
+    ) {
+        count += node->instruction.dest == symbol;
+        count += node->instruction.srcs[0] == symbol;
+        count += node->instruction.srcs[1] == symbol;
+    }
+    return count;
+}
+
+static int is_defined_in_body(
+    struct vectorize_loop const *loop,
+    struct symbol *symbol
+)
+{
+    struct tac_node *node;
+
+    for (
+        node = loop->exit_branch->next;
+        node != loop->back_jump;
+        node = node->next
+    ) {
+        if (
+            tac_defines_dest(node->instruction.opcode)
+            && node->instruction.dest == symbol
+        ) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Checks that every instruction of the body works element by element and
+ * translates it to packed operations. Temporaries of the body must not be
+ * seen outside of it, as they do not get the values of the last iteration.
+ */
+static int plan_body(
+    struct tac_node *function_start,
+    struct vectorize_loop *loop,
+    struct vectorize_plan *plan
+)
+{
+    size_t i;
+    struct tac_node *node;
+
+    plan->values = vector_empty(&plan->value_count);
+    plan->names = vector_empty(&plan->name_count);
+    plan->ops = vector_empty(&plan->op_count);
+    loop->has_element_type = 0;
+
+    for (
+        node = loop->exit_branch->next;
+        node != loop->step;
+        node = node->next
+    ) {
+        if (!plan_instruction(loop, plan, node->instruction)) {
+            return 0;
+        }
+    }
+
+    for (i = 0; i < plan->name_count; i++) {
+        if (
+            count_references(function_start, NULL, plan->names[i].scalar)
+            != count_references(
+                loop->exit_branch->next,
+                loop->step,
+                plan->names[i].scalar
+            )
+        ) {
+            return 0;
+        }
+    }
+
+    return plan->op_count > 0 && plan_slots(plan);
+}
+
+static int plan_instruction(
+    struct vectorize_loop *loop,
+    struct vectorize_plan *plan,
+    struct tac_instruction instruction
+)
+{
+    size_t value, left, right;
+    enum tac_opcode opcode;
+    struct symbol *reduced, *operand;
+
+    if (
+        tac_defines_dest(instruction.opcode)
+        && instruction.dest == loop->counter
+    ) {
+        return 0;
+    }
+
+    switch (instruction.opcode) {
+        case TAC_MOVI:
+            if (
+                instruction.srcs[1] != loop->counter
+                || !plan_element_type(loop, instruction.srcs[0])
+            ) {
+                return 0;
+            }
+            value = plan_value(plan, VECTORIZE_LANE, NULL);
+            plan_op(plan, TAC_PLOAD, instruction.srcs[0], value, 0, 0);
+            return plan_name(loop, plan, instruction.dest, value);
+
+        case TAC_MOVV:
+            if (
+                instruction.srcs[0] != loop->counter
+                || !plan_element_type(loop, instruction.dest)
+                || !plan_operand(loop, plan, instruction.srcs[1], &value)
+            ) {
+                return 0;
+            }
+            plan_op(plan, TAC_PSTORE, instruction.dest, 0, value, 0);
+            return 1;
+
+        case TAC_MOVE:
+            return plan_operand(loop, plan, instruction.srcs[0], &value)
+                && plan_name(loop, plan, instruction.dest, value);
+
+        case TAC_ADD:
+        case TAC_SUB:
+            /* s = s + x adds up the elements of x into an integer */
+            reduced = instruction.dest;
+            if (instruction.srcs[0] == reduced) {
+                operand = instruction.srcs[1];
+            } else if (
+                instruction.opcode == TAC_ADD
+                && instruction.srcs[1] == reduced
+            ) {
+                operand = instruction.srcs[0];
+            } else {
+                operand = NULL;
+            }
+            if (operand != NULL) {
+                if (
+                    !loop->has_element_type
+                    || loop->element_type != DATATYPE_INTE
+                    || !is_int_var(reduced)
+                    || reduced == loop->counter
+                    || reduced == loop->bound
+                    || count_references(
+                        loop->exit_branch->next,
+                        loop->step,
+                        reduced
+                    ) != 2
+                    || !plan_operand(loop, plan, operand, &right)
+                    || plan->values[right].kind != VECTORIZE_LANE
+                ) {
+                    return 0;
+                }
+                value = plan_value(plan, VECTORIZE_SUM, reduced);
+                plan->values[value].reduction = instruction.opcode;
+                plan_op(plan, TAC_PADD, NULL, value, value, right);
+                return 1;
+            }
+        case TAC_MUL:
+        case TAC_DIV:
+        case TAC_AND:
+        case TAC_OR:
+        case TAC_XOR:
+            if (
+                !loop->has_element_type
+                || !packed_opcode(
+                    loop->element_type,
+                    instruction.opcode,
+                    &opcode
+                )
+                || !plan_operand(loop, plan, instruction.srcs[0], &left)
+                || !plan_operand(loop, plan, instruction.srcs[1], &right)
+            ) {
+                return 0;
+            }
+            value = plan_value(plan, VECTORIZE_LANE, NULL);
+            plan_op(plan, opcode, NULL, value, left, right);
+            return plan_name(loop, plan, instruction.dest, value);
+
+        default:
+            return 0;
+    }
+}
+
+static int plan_element_type(
+    struct vectorize_loop *loop,
+    struct symbol *vector
+)
+{
+    if (
+        vector->type != SYM_VECTOR_VAR
+        && vector->type != SYM_TMP_VECTOR_VAR
+    ) {
+        return 0;
+    }
+    if (!loop->has_element_type) {
+        loop->element_type = vector->data.variable.type;
+        loop->has_element_type = 1;
+    }
+    return loop->element_type == vector->data.variable.type;
+}
+
+/*
+ * Finds the value of an operand, filling a packed variable before the loop
+ * when the operand does not change in the body.
+ */
+static int plan_operand(
+    struct vectorize_loop const *loop,
+    struct vectorize_plan *plan,
+    struct symbol *symbol,
+    size_t *value
+)
+{
+    size_t i;
+
+    for (i = 0; i < plan->name_count; i++) {
+        if (plan->names[i].scalar == symbol) {
+            *value = plan->names[i].value;
+            plan->values[*value].last_use = plan->op_count;
+            return 1;
+        }
+    }
+
+    for (i = 0; i < plan->value_count; i++) {
+        if (
+            plan->values[i].kind == VECTORIZE_SPLAT
+            && plan->values[i].scalar == symbol
+        ) {
+            *value = i;
+            return 1;
+        }
+    }
+
+    if (!loop->has_element_type) {
+        return 0;
+    }
+
+    switch (symbol->type) {
+        case SYM_LIT_INT:
+        case SYM_LIT_CHAR:
+            if (loop->element_type == DATATYPE_REAL) {
+                return 0;
+            }
+            break;
+        case SYM_LIT_FLOAT:
+            if (loop->element_type != DATATYPE_REAL) {
+                return 0;
+            }
+            break;
+        case SYM_TMP_VAR:
+        case SYM_SCALAR_VAR:
+            if (
+                symbol == loop->counter
+                || is_defined_in_body(loop, symbol)
+                || !fits_lane(loop->element_type, symbol->data.variable.type)
+            ) {
+                return 0;
+            }
+            break;
+        default:
+            return 0;
+    }
+
+    *value = plan_value(plan, VECTORIZE_SPLAT, symbol);
+    return 1;
+}
+
+static int plan_name(
+    struct vectorize_loop const *loop,
+    struct vectorize_plan *plan,
+    struct symbol *symbol,
+    size_t value
+)
+{
+    size_t i;
+    struct vectorize_name name;
+
+    if (
+        symbol->type != SYM_TMP_VAR
+        || !fits_lane(loop->element_type, symbol->data.variable.type)
+    ) {
+        return 0;
+    }
+
+    /* defined once, so that every use sees the same value */
+    for (i = 0; i < plan->name_count; i++) {
+        if (plan->names[i].scalar == symbol) {
+            return 0;
+        }
+    }
+
+    name.scalar = symbol;
+    name.value = value;
+    plan->names = vector_push(
+        plan->names,
+        sizeof(*plan->names),
+        &plan->name_count,
+        &name
+    );
+    return 1;
+}
+
+static size_t plan_value(
+    struct vectorize_plan *plan,
+    enum vectorize_value_kind kind,
+    struct symbol *scalar
+)
+{
+    struct vectorize_value value;
+
+    value.kind = kind;
+    value.scalar = scalar;
+    value.reduction = TAC_ADD;
+    value.last_use = plan->op_count;
+    value.slot = SIZE_MAX;
+    value.packed = NULL;
+    plan->values = vector_push(
+        plan->values,
+        sizeof(*plan->values),
+        &plan->value_count,
+        &value
+    );
+    return plan->value_count - 1;
+}
+
+static void plan_op(
+    struct vectorize_plan *plan,
+    enum tac_opcode opcode,
+    struct symbol *vector,
+    size_t dest,
+    size_t left,
+    size_t right
+)
+{
+    struct vectorize_op op;
+
+    op.opcode = opcode;
+    op.vector = vector;
+    op.dest = dest;
+    op.srcs[0] = left;
+    op.srcs[1] = right;
+    plan->ops = vector_push(plan->ops, sizeof(*plan->ops), &plan->op_count, &op);
+}
+
+/*
+ * Invariants and partial sums keep their packed variable during the whole
+ * loop, while the one of an element-wise value is free after its last use.
+ */
+static int plan_slots(struct vectorize_plan *plan)
+{
+    size_t i, j, slot;
+    size_t owners[TAC_PACKED_COUNT];
+
+    for (slot = 0; slot < TAC_PACKED_COUNT; slot++) {
+        owners[slot] = SIZE_MAX;
+    }
+
+    slot = 0;
+    for (i = 0; i < plan->value_count; i++) {
+        if (plan->values[i].kind != VECTORIZE_LANE) {
+            if (slot == TAC_PACKED_COUNT) {
+                return 0;
+            }
+            plan->values[i].slot = slot;
+            owners[slot] = i;
+            slot++;
+        }
+    }
+
+    for (i = 0; i < plan->op_count; i++) {
+        for (slot = 0; slot < TAC_PACKED_COUNT; slot++) {
+            if (
+                owners[slot] != SIZE_MAX
+                && plan->values[owners[slot]].kind == VECTORIZE_LANE
+                && plan->values[owners[slot]].last_use < i
+            ) {
+                owners[slot] = SIZE_MAX;
+            }
+        }
+
+        j = plan->ops[i].dest;
+        if (
+            plan->ops[i].opcode != TAC_PSTORE
+            && plan->values[j].kind == VECTORIZE_LANE
+        ) {
+            slot = 0;
+            while (slot < TAC_PACKED_COUNT && owners[slot] != SIZE_MAX) {
+                slot++;
+            }
+            if (slot == TAC_PACKED_COUNT) {
+                return 0;
+            }
+            plan->values[j].slot = slot;
+            owners[slot] = j;
+        }
+    }
+
+    return 1;
+}
+
+static int packed_opcode(
+    enum datatype element_type,
+    enum tac_opcode opcode,
+    enum tac_opcode *packed
+)
+{
+    switch (opcode) {
+        case TAC_ADD:
+            *packed = TAC_PADD;
+            return 1;
+        case TAC_SUB:
+            *packed = TAC_PSUB;
+            return 1;
+        case TAC_MUL:
+            *packed = TAC_PMUL;
+            return element_type == DATATYPE_REAL;
+        case TAC_DIV:
+            *packed = TAC_PDIV;
+            return element_type == DATATYPE_REAL;
+        case TAC_AND:
+            *packed = TAC_PAND;
+            return element_type != DATATYPE_REAL;
+        case TAC_OR:
+            *packed = TAC_POR;
+            return element_type != DATATYPE_REAL;
+        case TAC_XOR:
+            *packed = TAC_PXOR;
+            return element_type != DATATYPE_REAL;
+        default:
+            return 0;
+    }
+}
+
+/*
+ * The bits of an integer sum, difference or bitwise operation only depend on
+ * the bits of the operands at the same place or below, so computing in a
+ * narrower lane gives what is stored back into the narrower vector.
+ */
+static int fits_lane(enum datatype element_type, enum datatype datatype)
+{
+    if (element_type == DATATYPE_REAL || datatype == DATATYPE_REAL) {
+        return element_type == datatype;
+    }
+    return datatype_size(datatype) >= datatype_size(element_type);
+}
+
+static size_t datatype_size(enum datatype datatype)
+{
+    switch (datatype) {
+        case DATATYPE_CARA:
+            return 1;
+        case DATATYPE_NATU:
+            return 4;
+        default:
+            return 8;
+    }
+}
+
+static void plan_free(struct vectorize_plan *plan)
+{
+    free(plan->values);
+    free(plan->names);
+    free(plan->ops);
+}
+
+/*
+ * Runs the packed body while the counter would still pass the test after as
+ * many steps as there are elements in a packed variable, leaving the original
+ * loop for the remaining elements.
+ */
+static void vectorize_loop(
+    struct tac *tac,
+    struct vectorize_loop const *loop,
+    struct vectorize_plan *plan
+)
+{
+    size_t i;
+    long lane_count;
+    struct vectorize_value *value;
+    struct vectorize_op *op;
+    struct symbol *block_label, *done_label, *last, *test, *sum;
+
+    lane_count = TAC_PACKED_SIZE / datatype_size(loop->element_type);
+
+    for (i = 0; i < plan->value_count; i++) {
+        value = &plan->values[i];
+        value->packed = symbol_table_create_tmp_packed_var(
+            value->kind == VECTORIZE_SUM
+                ? DATATYPE_INTE
+                : loop->element_type,
+            value->slot
+        );
+        if (value->kind == VECTORIZE_SPLAT) {
+            insert_instruction(
+                tac,
+                loop->head,
+                TAC_PSPLAT,
+                value->packed,
+                value->scalar,
+                NULL
+            );
+        } else if (value->kind == VECTORIZE_SUM) {
+            insert_instruction(
+                tac,
+                loop->head,
+                TAC_PSPLAT,
+                value->packed,
+                symbol_table_create_int_lit(0),
+                NULL
+            );
+        }
+    }
+
+    block_label = symbol_table_create_tmp_label();
+    done_label = symbol_table_create_tmp_label();
+    last = symbol_table_create_tmp_scalar_var(DATATYPE_INTE);
+    test = symbol_table_create_tmp_scalar_var(
+        loop->compare->instruction.dest->data.variable.type
+    );
+
+    insert_instruction(tac, loop->head, TAC_LABEL, NULL, block_label, NULL);
+    insert_instruction(
+        tac,
+        loop->head,
+        TAC_ADD,
+        last,
+        loop->counter,
+        symbol_table_create_int_lit(lane_count - 1)
+    );
+    insert_instruction(
+        tac,
+        loop->head,
+        loop->comparison,
+        test,
+        last,
+        loop->bound
+    );
+    insert_instruction(tac, loop->head, TAC_IFZ, done_label, test, NULL);
+
+    for (i = 0; i < plan->op_count; i++) {
+        op = &plan->ops[i];
+        switch (op->opcode) {
+            case TAC_PLOAD:
+                insert_instruction(
+                    tac,
+                    loop->head,
+                    TAC_PLOAD,
+                    plan->values[op->dest].packed,
+                    op->vector,
+                    loop->counter
+                );
+                break;
+            case TAC_PSTORE:
+                insert_instruction(
+                    tac,
+                    loop->head,
+                    TAC_PSTORE,
+                    op->vector,
+                    loop->counter,
+                    plan->values[op->srcs[0]].packed
+                );
+                break;
+            default:
+                insert_instruction(
+                    tac,
+                    loop->head,
+                    op->opcode,
+                    plan->values[op->dest].packed,
+                    plan->values[op->srcs[0]].packed,
+                    plan->values[op->srcs[1]].packed
+                );
+                break;
+        }
+    }
+
+    insert_instruction(
+        tac,
+        loop->head,
+        TAC_ADD,
+        loop->counter,
+        loop->counter,
+        symbol_table_create_int_lit(lane_count)
+    );
+    insert_instruction(tac, loop->head, TAC_JUMP, block_label, NULL, NULL);
+    insert_instruction(tac, loop->head, TAC_LABEL, NULL, done_label, NULL);
+
+    for (i = 0; i < plan->value_count; i++) {
+        value = &plan->values[i];
+        if (value->kind == VECTORIZE_SUM) {
+            sum = symbol_table_create_tmp_scalar_var(DATATYPE_INTE);
+            insert_instruction(
+                tac,
+                loop->head,
+                TAC_PSUM,
+                sum,
+                value->packed,
+                NULL
+            );
+            insert_instruction(
+                tac,
+                loop->head,
+                value->reduction,
+                value->scalar,
+                value->scalar,
+                sum
+            );
+        }
+    }
+}
+
+static void insert_instruction(
+    struct tac *tac,
+    struct tac_node *before,
+    enum tac_opcode opcode,
+    struct symbol *dest,
+    struct symbol *left,
+    struct symbol *right
+)
+{
+    struct tac_instruction instruction;
+
+    instruction.opcode = opcode;
+    instruction.dest = dest;
+    instruction.srcs[0] = left;
+    instruction.srcs[1] = right;
+    instruction.phi_arg_count = 0;
+    instruction.phi_args = NULL;
+    tac_insert_before(tac, before, instruction);
+}
@@ -0,0 +1,15 @@
+#ifndef VECTORIZE_H_
+#define VECTORIZE_H_ 1
+
+#include "tac.h"
+
+/**
+ * Vectorizes the counted loops produced by the while statement whose body
+ * only loads, combines and stores vector elements at the counter, possibly
+ * adding them up into an integer. Such a loop gets a copy running on packed
+ * variables, as many elements per test as fit one of them, followed by the
+ * original loop for the remaining elements.
+ */
+void vectorize_loops(struct tac *tac);
+
+#endif
@@ -769,7 +769,11 @@ static void render_directive(
                     fputs(", ", params.output);
                 }
                 is_first = 0;
-                fputs(directive.operands[i]->content, params.output);
+                if (directive.operands[i]->type == SYM_LABEL) {
+                    render_symbol_operand(directive.operands[i], params);
+                } else {
+                    fputs(directive.operands[i]->content, params.output);
+                }
             }
             break;
         default:
@@ -970,11 +974,14 @@ char const *x86_64_opcode_mnemonic(enum x86_64_opcode opcode)
     switch (opcode) {
         case X86_64_MOV: return "mov";
         case X86_64_MOVABS: return "movabs";
+        case X86_64_MOVZB: return "movzb";
         case X86_64_CMOVNS: return "cmovns";
         case X86_64_LEA: return "lea";
         case X86_64_NOT: return "not";
         case X86_64_SHL: return "shl";
         case X86_64_SAR: return "sar";
+        case X86_64_SHR: return "shr";
+        case X86_64_ROL: return "rol";
         case X86_64_AND: return "and";
         case X86_64_OR: return "or";
         case X86_64_XOR: return "xor";
@@ -986,6 +993,7 @@ char const *x86_64_opcode_mnemonic(enum x86_64_opcode opcode)
         case X86_64_CQO: return "cqo";
         case X86_64_IMUL: return "imul";
         case X86_64_IDIV: return "idiv";
+        case X86_64_DIV: return "div";
         case X86_64_TEST: return "test";
         case X86_64_CMP: return "cmp";
         case X86_64_JMP: return "jmp";
@@ -1020,6 +1028,28 @@ char const *x86_64_opcode_mnemonic(enum x86_64_opcode opcode)
         case X86_64_MULSD: return "mulsd";
         case X86_64_DIVSD: return "divsd";
         case X86_64_UCOMISD: return "ucomisd";
+        case X86_64_XORPD: return "xorpd";
+        case X86_64_MOVDQU: return "movdqu";
+        case X86_64_MOVDQA: return "movdqa";
+        case X86_64_PUNPCKLQDQ: return "punpcklqdq";
+        case X86_64_PUNPCKHQDQ: return "punpckhqdq";
+        case X86_64_PADDB: return "paddb";
+        case X86_64_PADDD: return "paddd";
+        case X86_64_PADDQ: return "paddq";
+        case X86_64_PSUBB: return "psubb";
+        case X86_64_PSUBD: return "psubd";
+        case X86_64_PSUBQ: return "psubq";
+        case X86_64_PAND: return "pand";
+        case X86_64_POR: return "por";
+        case X86_64_PXOR: return "pxor";
+        case X86_64_ADDPD: return "addpd";
+        case X86_64_SUBPD: return "subpd";
+        case X86_64_MULPD: return "mulpd";
+        case X86_64_DIVPD: return "divpd";
+        case X86_64_REP_STOSB: return "rep stosb";
+        case X86_64_REP_STOSL: return "rep stosl";
+        case X86_64_REP_STOSQ: return "rep stosq";
+        case X86_64_REP_MOVSB: return "rep movsb";
     }
     panic("unhandled opcode %i in rendering", opcode);
 }
@@ -1034,6 +1064,8 @@ static char const *directive_name(
             switch (directive_name) {
                 case X86_64_DATA: return ".section .data";
                 case X86_64_RODATA: return ".section .rodata";
+                case X86_64_BSS: return ".section .bss";
+                case X86_64_FINI_ARRAY: return ".section .fini_array,\"aw\"";
                 case X86_64_TEXT: return ".section .text";
                 case X86_64_GLOBL: return ".globl";
                 case X86_64_TYPE: return ".type";
@@ -1041,6 +1073,7 @@ static char const *directive_name(
                 case X86_64_ASCII: return ".ascii";
                 case X86_64_DOUBLE: return ".double";
                 case X86_64_QUAD: return ".quad";
+                case X86_64_LONG: return ".long";
                 case X86_64_ZERO: return ".zero";
                 case X86_64_ALIGN: return ".align";
                 default:
@@ -1091,6 +1124,7 @@ static void render_symbol_operand(
                     fputs(symbol->content, params.output);
                     break;
                 case SYM_TMP_VAR:
+                case SYM_TMP_VECTOR_VAR:
                 case SYM_SCALAR_VAR:
                 case SYM_VECTOR_VAR:
                 case SYM_STR_ADDR:
@@ -1230,6 +1264,7 @@ static int opcode_needs_size_suffix(enum x86_64_opcode opcode)
     switch (opcode) {
         case X86_64_MOV:
         case X86_64_MOVABS:
+        case X86_64_MOVZB:
         case X86_64_XOR:
         case X86_64_NOT:
         case X86_64_AND:
@@ -1242,6 +1277,7 @@ static int opcode_needs_size_suffix(enum x86_64_opcode opcode)
         case X86_64_DEC:
         case X86_64_IMUL:
         case X86_64_IDIV:
+        case X86_64_DIV:
         case X86_64_TEST:
         case X86_64_CMP:
         case X86_64_PUSH:
@@ -1250,6 +1286,8 @@ static int opcode_needs_size_suffix(enum x86_64_opcode opcode)
         case X86_64_RET:
         case X86_64_SHL:
         case X86_64_SAR:
+        case X86_64_SHR:
+        case X86_64_ROL:
             return 1;
         case X86_64_CMOVNS:
         case X86_64_CQO:
@@ -1281,6 +1319,28 @@ static int opcode_needs_size_suffix(enum x86_64_opcode opcode)
         case X86_64_MULSD:
         case X86_64_DIVSD:
         case X86_64_UCOMISD:
+        case X86_64_XORPD:
+        case X86_64_MOVDQU:
+        case X86_64_MOVDQA:
+        case X86_64_PUNPCKLQDQ:
+        case X86_64_PUNPCKHQDQ:
+        case X86_64_PADDB:
+        case X86_64_PADDD:
+        case X86_64_PADDQ:
+        case X86_64_PSUBB:
+        case X86_64_PSUBD:
+        case X86_64_PSUBQ:
+        case X86_64_PAND:
+        case X86_64_POR:
+        case X86_64_PXOR:
+        case X86_64_ADDPD:
+        case X86_64_SUBPD:
+        case X86_64_MULPD:
+        case X86_64_DIVPD:
+        case X86_64_REP_STOSB:
+        case X86_64_REP_STOSL:
+        case X86_64_REP_STOSQ:
+        case X86_64_REP_MOVSB:
             return 0;
     }
     panic("implementation of opcode %li's need size suffix required");
@@ -1293,7 +1353,7 @@ static char const *size_suffix(enum x86_64_register_size size)
         case X86_64_WORD: return "w";
         case X86_64_DWORD: return "l";
         case X86_64_QWORD: return "q";
-        case X86_64_SSE: return "";
+        case X86_64_SSE: return "q";
     }
     panic("size %i suffix is not supported", size);
 }
@@ -1316,11 +1376,14 @@ enum x86_64_register_size x86_64_symbol_reg_size(struct symbol const *symbol)
         case SYM_SCALAR_VAR:
         case SYM_VECTOR_VAR:
         case SYM_TMP_VAR:
+        case SYM_TMP_VECTOR_VAR:
             switch (symbol->data.variable.type) {
                 case DATATYPE_CARA:
                     return X86_64_BYTE;
                 case DATATYPE_INTE:
                     return X86_64_QWORD;
+                case DATATYPE_NATU:
+                    return X86_64_DWORD;
                 case DATATYPE_REAL:
                     return X86_64_SSE;
                 default:
@@ -1351,9 +1414,12 @@ int x86_64_symbol_data_size(struct symbol const *symbol)
         case SYM_SCALAR_VAR:
         case SYM_VECTOR_VAR:
         case SYM_TMP_VAR:
+        case SYM_TMP_VECTOR_VAR:
             switch (symbol->data.variable.type) {
                 case DATATYPE_CARA:
                     return 1;
+                case DATATYPE_NATU:
+                    return 4;
                 case DATATYPE_INTE:
                 case DATATYPE_REAL:
                     return 8;
@@ -1373,9 +1439,12 @@ x86_64_operand_flags_type x86_64_operand_flags(enum x86_64_opcode opcode)
     switch (opcode) {
         case X86_64_MOV:
         case X86_64_MOVABS:
+        case X86_64_MOVZB:
         case X86_64_LEA:
         case X86_64_MOVQ:
         case X86_64_MOVSD:
+        case X86_64_MOVDQU:
+        case X86_64_MOVDQA:
             return X86_64_OPERAND_0_DEST | X86_64_OPERAND_1_SRC;
         case X86_64_CMOVNS:
             return X86_64_OPERAND_0_DEST
@@ -1388,6 +1457,8 @@ x86_64_operand_flags_type x86_64_operand_flags(enum x86_64_opcode opcode)
         case X86_64_SUB:
         case X86_64_SHL:
         case X86_64_SAR:
+        case X86_64_SHR:
+        case X86_64_ROL:
             return X86_64_OPERAND_0_DEST
                 | X86_64_OPERAND_0_SRC
                 | X86_64_OPERAND_1_SRC
@@ -1401,6 +1472,22 @@ x86_64_operand_flags_type x86_64_operand_flags(enum x86_64_opcode opcode)
         case X86_64_SUBSD:
         case X86_64_MULSD:
         case X86_64_DIVSD:
+        case X86_64_PUNPCKLQDQ:
+        case X86_64_PUNPCKHQDQ:
+        case X86_64_PADDB:
+        case X86_64_PADDD:
+        case X86_64_PADDQ:
+        case X86_64_PSUBB:
+        case X86_64_PSUBD:
+        case X86_64_PSUBQ:
+        case X86_64_PAND:
+        case X86_64_POR:
+        case X86_64_PXOR:
+        case X86_64_XORPD:
+        case X86_64_ADDPD:
+        case X86_64_SUBPD:
+        case X86_64_MULPD:
+        case X86_64_DIVPD:
             return X86_64_OPERAND_0_DEST
                 | X86_64_OPERAND_0_SRC
                 | X86_64_OPERAND_1_SRC;
@@ -1416,6 +1503,7 @@ x86_64_operand_flags_type x86_64_operand_flags(enum x86_64_opcode opcode)
                 | X86_64_OPERAND_RAX_DEST
                 | X86_64_OPERAND_RDX_DEST;
         case X86_64_IDIV:
+        case X86_64_DIV:
             return X86_64_OPERAND_0_SRC
                 | X86_64_OPERAND_RAX_SRC
                 | X86_64_OPERAND_RDX_SRC
@@ -1478,6 +1566,14 @@ x86_64_operand_flags_type x86_64_operand_flags(enum x86_64_opcode opcode)
                 | X86_64_OPERAND_RIP_DEST
                 | X86_64_OPERAND_RSP_SRC
                 | X86_64_OPERAND_RSP_DEST;
+        case X86_64_REP_STOSB:
+        case X86_64_REP_STOSL:
+        case X86_64_REP_STOSQ:
+            return X86_64_OPERAND_RAX_SRC
+                | X86_64_OPERAND_STRING_SRC
+                | X86_64_OPERAND_STRING_DEST;
+        case X86_64_REP_MOVSB:
+            return X86_64_OPERAND_STRING_SRC | X86_64_OPERAND_STRING_DEST;
     }
     panic("opcode %i's flags not implemented", opcode);
 }
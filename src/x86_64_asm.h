@@ -21,6 +21,9 @@
 #define X86_64_OPERAND_RIP_DEST (1U << 11)
 #define X86_64_OPERAND_EFLAGS_SRC (1U << 12)
 #define X86_64_OPERAND_EFLAGS_DEST (1U << 13)
+/* rcx, rsi and rdi, as counted and advanced by the string instructions */
+#define X86_64_OPERAND_STRING_SRC (1U << 14)
+#define X86_64_OPERAND_STRING_DEST (1U << 15)
 
 typedef unsigned x86_64_operand_flags_type;
 
@@ -46,6 +49,8 @@ enum x86_64_operand_tag {
 enum x86_64_directive_name {
     X86_64_DATA,
     X86_64_RODATA,
+    X86_64_BSS,
+    X86_64_FINI_ARRAY,
     X86_64_TEXT,
     X86_64_GLOBL,
     X86_64_EXTERN,
@@ -53,6 +58,7 @@ enum x86_64_directive_name {
     X86_64_ASCII,
     X86_64_DOUBLE,
     X86_64_QUAD,
+    X86_64_LONG,
     X86_64_ZERO,
     X86_64_ALIGN
 };
@@ -66,11 +72,14 @@ enum x86_64_asm_stmt_tag {
 enum x86_64_opcode {
     X86_64_MOV,
     X86_64_MOVABS,
+    X86_64_MOVZB,
     X86_64_CMOVNS,
     X86_64_LEA,
     X86_64_NOT,
     X86_64_SHL,
     X86_64_SAR,
+    X86_64_SHR,
+    X86_64_ROL,
     X86_64_AND,
     X86_64_OR,
     X86_64_XOR,
@@ -81,6 +90,7 @@ enum x86_64_opcode {
     X86_64_DEC,
     X86_64_IMUL,
     X86_64_IDIV,
+    X86_64_DIV,
     X86_64_CQO,
     X86_64_TEST,
     X86_64_CMP,
@@ -115,7 +125,29 @@ enum x86_64_opcode {
     X86_64_SUBSD,
     X86_64_MULSD,
     X86_64_DIVSD,
-    X86_64_UCOMISD
+    X86_64_UCOMISD,
+    X86_64_XORPD,
+    X86_64_MOVDQU,
+    X86_64_MOVDQA,
+    X86_64_PUNPCKLQDQ,
+    X86_64_PUNPCKHQDQ,
+    X86_64_PADDB,
+    X86_64_PADDD,
+    X86_64_PADDQ,
+    X86_64_PSUBB,
+    X86_64_PSUBD,
+    X86_64_PSUBQ,
+    X86_64_PAND,
+    X86_64_POR,
+    X86_64_PXOR,
+    X86_64_ADDPD,
+    X86_64_SUBPD,
+    X86_64_MULPD,
+    X86_64_DIVPD,
+    X86_64_REP_STOSB,
+    X86_64_REP_STOSL,
+    X86_64_REP_STOSQ,
+    X86_64_REP_MOVSB
 };
 
 enum x86_64_register {
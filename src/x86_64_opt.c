@@ -1,4 +1,5 @@
 #include "x86_64_opt.h"
+#include "x86_64_regalloc.h"
 #include "symboltable.h"
 #include "panic.h"
 
@@ -46,6 +47,11 @@ static void deduplifier_trans_started(
     size_t index
 );
 
+static int operand_reads_reg(
+    struct x86_64_operand operand,
+    enum x86_64_register reg
+);
+
 static void deduplifier_movs(struct x86_64_asm_unit *unit);
 
 static void use_inc_decs(struct x86_64_asm_unit *unit);
@@ -71,6 +77,17 @@ static struct deduplifier deduplifier_init(struct x86_64_asm_unit *unit)
     return dedup;
 }
 
+static int operand_reads_reg(
+    struct x86_64_operand operand,
+    enum x86_64_register reg
+)
+{
+    if (operand.tag == X86_64_OPERAND_DIRECT) {
+        return x86_64_reg_unsized_eq(operand.data.direct, reg);
+    }
+    return x86_64_operand_uses_reg(operand, reg);
+}
+
 static void deduplifier_movs(struct x86_64_asm_unit *unit)
 {
     struct deduplifier dedup = deduplifier_init(unit);
@@ -82,8 +99,8 @@ static int deduplifier_next_raw(
     size_t *curr_index
 )
 {
-    if (dedup->front_cursor > dedup->unit->length) {
-        if (dedup->back_cursor > dedup->unit->length) {
+    if (dedup->front_cursor >= dedup->unit->length) {
+        if (dedup->back_cursor + 1 >= dedup->unit->length) {
             return 0;
         }
         dedup->back_cursor++;
@@ -113,6 +130,10 @@ static int deduplifier_next(
         if (success) {
             retry = dedup->unit->statements[local_curr].tag !=
                 X86_64_INSTRUCTION;
+            /* a label may be reached with other values in the registers */
+            if (dedup->unit->statements[local_curr].tag == X86_64_LABEL) {
+                dedup->status = DEDUP_NOT_STARTED;
+            }
         }
         if (success && !retry) {
             operand_flags = x86_64_operand_flags(
@@ -163,6 +184,7 @@ static void deduplifier_trans_not_started(
         && instruction->opcode != X86_64_MOVQ
         && instruction->operand_count == 2
         && instruction->operands[0].tag == X86_64_OPERAND_DIRECT
+        && !x86_64_regalloc_is_allocatable(instruction->operands[0].data.direct)
     ) {
         if (instruction->opcode == X86_64_MOV) {
             dedup->status = DEDUP_MOV_FIRST;
@@ -179,6 +201,7 @@ static void deduplifier_trans_started(
 )
 {
     int first_rax, first_rdx, first_rsp, curr_rax, curr_rdx, curr_rsp;
+    int first_string, curr_string;
     int uses_reg;
     size_t i;
     struct x86_64_instruction *first_instr;
@@ -193,39 +216,74 @@ static void deduplifier_trans_started(
     curr_flags = x86_64_operand_flags(curr_instr->opcode);
 
     first_rax = first_flags & X86_64_OPERAND_RAX_DEST
-        || first_instr->operands[0].data.direct == X86_64_RAX;
+        || x86_64_reg_unsized_eq(
+            first_instr->operands[0].data.direct,
+            X86_64_RAX
+        );
 
     curr_rax = curr_flags & X86_64_OPERAND_RAX_SRC
         || (
             curr_flags & X86_64_OPERAND_1_SRC
             && curr_instr->operands[1].tag == X86_64_OPERAND_DIRECT
-            && curr_instr->operands[1].data.direct== X86_64_RAX
+            && x86_64_reg_unsized_eq(
+                curr_instr->operands[1].data.direct,
+                X86_64_RAX
+            )
         );
 
     first_rdx = first_flags & X86_64_OPERAND_RDX_DEST
-        || first_instr->operands[0].data.direct == X86_64_RDX;
+        || x86_64_reg_unsized_eq(
+            first_instr->operands[0].data.direct,
+            X86_64_RDX
+        );
 
     curr_rdx = curr_flags & X86_64_OPERAND_RDX_SRC
         || (
             curr_flags & X86_64_OPERAND_1_SRC
             && curr_instr->operands[1].tag == X86_64_OPERAND_DIRECT
-            && curr_instr->operands[1].data.direct== X86_64_RDX
+            && x86_64_reg_unsized_eq(
+                curr_instr->operands[1].data.direct,
+                X86_64_RDX
+            )
         );
 
     first_rsp = first_flags & X86_64_OPERAND_RSP_DEST
-        || first_instr->operands[0].data.direct == X86_64_RSP;
+        || x86_64_reg_unsized_eq(
+            first_instr->operands[0].data.direct,
+            X86_64_RSP
+        );
 
     curr_rsp = curr_flags & X86_64_OPERAND_RSP_SRC
         || (
             curr_flags & X86_64_OPERAND_1_SRC
             && curr_instr->operands[1].tag == X86_64_OPERAND_DIRECT
-            && curr_instr->operands[1].data.direct== X86_64_RSP
+            && x86_64_reg_unsized_eq(
+                curr_instr->operands[1].data.direct,
+                X86_64_RSP
+            )
+        );
+
+    first_string = first_flags & X86_64_OPERAND_STRING_DEST
+        || x86_64_reg_unsized_eq(
+            first_instr->operands[0].data.direct,
+            X86_64_RCX
+        )
+        || x86_64_reg_unsized_eq(
+            first_instr->operands[0].data.direct,
+            X86_64_RSI
+        )
+        || x86_64_reg_unsized_eq(
+            first_instr->operands[0].data.direct,
+            X86_64_RDI
         );
 
+    curr_string = curr_flags & X86_64_OPERAND_STRING_SRC;
+
     if (
         (first_rax && curr_rax)
         || (first_rdx && curr_rdx)
         || (first_rsp && curr_rsp)
+        || (first_string && curr_string)
     ) {
         dedup->status = DEDUP_NOT_STARTED;
     } else if (
@@ -266,6 +324,12 @@ static void deduplifier_trans_started(
             && !x86_64_is_operand_memory(curr_instr->operands[0].tag)
         ) {
             dedup->status = DEDUP_NOT_STARTED;
+        } else if (
+            first_instr->opcode == X86_64_MOVSD
+            && x86_64_register_size(curr_instr->operands[0].data.direct)
+                != X86_64_SSE
+        ) {
+            dedup->status = DEDUP_NOT_STARTED;
         } else if (
             first_instr->operands[1].tag == X86_64_OPERAND_IMMEDIATE
             && x86_64_operand_data_size(first_instr->operands[1])
@@ -273,6 +337,14 @@ static void deduplifier_trans_started(
                 x86_64_operand_data_size(curr_instr->operands[0])
         ) {
             dedup->status = DEDUP_NOT_STARTED;
+        } else if (
+            first_instr->operands[1].tag == X86_64_OPERAND_IMMEDIATE
+            && x86_64_is_operand_memory(curr_instr->operands[0].tag)
+            && x86_64_register_size(curr_instr->operands[1].data.direct)
+                != x86_64_operand_data_size(curr_instr->operands[0])
+        ) {
+            /* the store would take the size of the memory operand instead */
+            dedup->status = DEDUP_NOT_STARTED;
         }
         switch (dedup->status) {
             case DEDUP_MOV_FIRST:
@@ -301,6 +373,11 @@ static void deduplifier_trans_started(
         }
     }
 
+    /* a removal leaves both instruction pointers dangling */
+    if (dedup->status == DEDUP_NOT_STARTED) {
+        return;
+    }
+
     if (
         (
             curr_flags & X86_64_OPERAND_0_DEST
@@ -319,6 +396,26 @@ static void deduplifier_trans_started(
                 curr_instr->operands[1]
             ) == 0
         )
+        ||
+        (
+            curr_flags & X86_64_OPERAND_0_DEST
+            &&
+            x86_64_operand_cmp(
+                first_instr->operands[1],
+                curr_instr->operands[0]
+            ) == 0
+        )
+        /* the source may also be overwritten implicitly, as by imul */
+        ||
+        (
+            curr_flags & X86_64_OPERAND_RAX_DEST
+            && operand_reads_reg(first_instr->operands[1], X86_64_RAX)
+        )
+        ||
+        (
+            curr_flags & X86_64_OPERAND_RDX_DEST
+            && operand_reads_reg(first_instr->operands[1], X86_64_RDX)
+        )
     ) {
         dedup->status = DEDUP_NOT_STARTED;
     } else {
@@ -7,6 +7,12 @@
 
 #define X86_64_OPT_INC_DECS (1U << 1)
 
+#define X86_64_OPT_REGALLOC (1U << 2)
+
+#define X86_64_OPT_FRAME_PARAMS (1U << 3)
+
+#define X86_64_OPT_TAIL_CALLS (1U << 4)
+
 #define X86_64_OPT_OFF 0
 
 #define X86_64_OPT_FULL (~0U)
@@ -1,20 +1,38 @@
+#include <limits.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include "x86_64_pc_linux_gnu_gen.h"
+#include "x86_64_regalloc.h"
 #include "symboltable.h"
+#include "vector.h"
 #include "panic.h"
 
 #define MAX_REGISTER_PARAMS 6
 #define MAX_SSE_REGISTER_PARAMS 8
+#define INPUT_BUFFER_SIZE 65536
+#define OUTPUT_BUFFER_SIZE 65536
+#define OUTPUT_REAL_ROOM 512
+#define CACHE_LINE_SIZE 64
 
 struct sections {
     struct x86_64_asm_unit data;
+    struct x86_64_asm_unit bss;
     struct x86_64_asm_unit rodata;
     struct x86_64_asm_unit text;
 };
 
+struct data_layout {
+    /* globals written by some instruction */
+    struct symbol **stored_vars;
+    size_t stored_var_count;
+};
+
 struct stack_frame {
     size_t size;
+    size_t saved_register_count;
+    size_t saved_registers[X86_64_REGALLOC_REGISTERS];
+    size_t saved_registers_index;
 };
 
 struct call_state {
@@ -39,6 +57,30 @@ static void gen_enter_boilerplate(struct sections *sections);
 
 static void gen_read_function(struct sections *sections);
 
+static void gen_fill_input_function(struct sections *sections);
+
+static void gen_input_buffer(struct sections *sections);
+
+static void gen_output_buffer(struct sections *sections);
+
+static void gen_flush_function(struct sections *sections);
+
+static void gen_write_bytes_function(struct sections *sections);
+
+static void gen_write_int_function(struct sections *sections);
+
+static void gen_write_real_function(struct sections *sections);
+
+static void gen_runtime_var(struct sections *sections, struct symbol *var);
+
+static void gen_runtime_buffer(
+    struct sections *sections,
+    struct symbol *buffer,
+    long size
+);
+
+static struct symbol *runtime_var_sym(char const *name, enum datatype type);
+
 static void check_prepare_reg_slice(
     struct sections *sections,
     enum x86_64_register reg
@@ -48,23 +90,59 @@ static void gen_char_def(struct x86_64_asm_unit *unit, struct symbol *ch_sym);
 
 static void gen_int_def(struct x86_64_asm_unit *unit, struct symbol *int_sym);
 
+static void gen_natu_def(struct x86_64_asm_unit *unit, struct symbol *int_sym);
+
 static void gen_float_def(struct x86_64_asm_unit *unit, struct symbol *f_sym);
 
 static void gen_string_def(struct x86_64_asm_unit *unit, struct symbol *s_sym);
 
 static void gen_sym_def(struct x86_64_asm_unit *unit, struct symbol *symbol);
 
+static void gen_var_def(
+    struct x86_64_asm_unit *unit,
+    struct symbol *variable,
+    struct symbol *value
+);
+
 static void gen_zeroes_def(
     struct x86_64_asm_unit *unit,
     struct symbol *vector,
     long length
 );
 
+static void gen_data_label(
+    struct x86_64_asm_unit *unit,
+    struct symbol *variable,
+    long align
+);
+
+static struct data_layout data_layout_scan(struct tac tac);
+
+static struct x86_64_asm_unit *data_layout_unit(
+    struct sections *sections,
+    struct data_layout layout,
+    struct symbol *variable,
+    int is_zeroed
+);
+
+static int is_zeroed_vector(struct tac_node *beginvec_node);
+
+static int is_zero_lit(struct symbol *symbol);
+
 static struct x86_64_operand value_operand_from_sym(
     struct sections *sections,
     struct symbol *symbol
 );
 
+static struct x86_64_operand widened_operand_from_sym(
+    struct sections *sections,
+    struct symbol *symbol
+);
+
+static struct x86_64_operand frame_operand_from_sym(struct symbol *symbol);
+
+static int is_frame_param(struct symbol *symbol);
+
 static struct x86_64_operand address_operand_from_sym(
     struct sections *sections,
     struct symbol *symbol
@@ -79,11 +157,19 @@ static int sse_parameter_register(
 
 static void gen_data(struct sections *sections, struct tac tac);
 
-static void gen_code(struct sections *sections, struct tac tac);
+static void gen_code(
+    struct sections *sections,
+    struct tac tac,
+    x86_64_opt_flags_type flags
+);
 
 static void gen_code_headers(struct sections *sections, struct tac tac);
 
-static void gen_code_bodies(struct sections *sections, struct tac tac);
+static void gen_code_bodies(
+    struct sections *sections,
+    struct tac tac,
+    x86_64_opt_flags_type flags
+);
 
 static void gen_string_sym(struct sections *sections, struct symbol *str_sym);
 
@@ -91,11 +177,20 @@ static void gen_float_sym(struct sections *sections, struct symbol *float_sym);
 
 static struct stack_frame gen_beginfun_code(
     struct sections *sections,
-    struct tac_node *tac_node
+    struct tac_node *tac_node,
+    x86_64_opt_flags_type flags
+);
+
+static void gen_saved_registers_code(
+    struct sections *sections,
+    struct stack_frame stack_frame,
+    int restore
 );
 
 static void gen_leave_boilerplate(struct sections *sections);
 
+static void gen_unwind_boilerplate(struct sections *sections);
+
 static void gen_simple_int_bin_code(
     struct sections *sections,
     struct tac_node *tac_node
@@ -106,6 +201,61 @@ static void gen_float_bin_code(
     struct tac_node *tac_node
 );
 
+static void gen_pload_code(
+    struct sections *sections,
+    struct tac_node *tac_node
+);
+
+static void gen_pstore_code(
+    struct sections *sections,
+    struct tac_node *tac_node
+);
+
+static void gen_psplat_code(
+    struct sections *sections,
+    struct tac_node *tac_node
+);
+
+static void gen_packed_bin_code(
+    struct sections *sections,
+    struct tac_node *tac_node
+);
+
+static void gen_psum_code(
+    struct sections *sections,
+    struct tac_node *tac_node
+);
+
+static void gen_packed_instruction(
+    struct sections *sections,
+    enum x86_64_opcode opcode,
+    enum x86_64_register dest,
+    enum x86_64_register src
+);
+
+static enum x86_64_register packed_register(struct symbol *symbol);
+
+static void gen_rep_code(
+    struct sections *sections,
+    struct tac_node *tac_node
+);
+
+static void gen_fill_code(
+    struct sections *sections,
+    struct tac_node *tac_node
+);
+
+static void gen_copy_code(
+    struct sections *sections,
+    struct tac_node *tac_node
+);
+
+static void gen_element_address(
+    struct sections *sections,
+    struct symbol *vector,
+    enum x86_64_register reg
+);
+
 static void gen_shmul_code(
     struct sections *sections,
     struct tac_node *tac_node
@@ -116,6 +266,13 @@ static void gen_shdiv_code(
     struct tac_node *tac_node
 );
 
+static void gen_mhdiv_code(
+    struct sections *sections,
+    struct tac_node *tac_node
+);
+
+static void division_magic(long divisor, long *multiplier, int *shift);
+
 static void gen_int_mul_code(
     struct sections *sections,
     struct tac_node *tac_node
@@ -131,18 +288,47 @@ static void gen_not_code(
     struct tac_node *tac_node
 );
 
+static void gen_shift_code(
+    struct sections *sections,
+    struct tac_node *tac_node
+);
+
 static void gen_int_comparison_code(
     struct sections *sections,
     struct tac_node *tac_node
 );
 
+static void gen_int_comparison_branch_code(
+    struct sections *sections,
+    struct tac_node *tac_node
+);
+
+static void gen_int_compare_instructions(
+    struct sections *sections,
+    struct tac_node *tac_node
+);
+
 static void gen_float_comparison_code(
     struct sections *sections,
     struct tac_node *tac_node
 );
 
+static void gen_float_comparison_branch_code(
+    struct sections *sections,
+    struct tac_node *tac_node
+);
+
+static int is_branch_condition(struct tac_node *tac_node);
+
+static void gen_branch_instruction(
+    struct sections *sections,
+    enum x86_64_opcode opcode,
+    struct symbol *label
+);
+
 static void gen_return_code(
     struct sections *sections,
+    struct stack_frame stack_frame,
     struct tac_node *tac_node
 );
 
@@ -158,6 +344,18 @@ static void gen_call_code(
     struct tac_node *tac_node
 );
 
+static int is_tail_call(
+    struct call_state const *call_state,
+    struct tac_node *tac_node
+);
+
+static void gen_tail_call_code(
+    struct sections *sections,
+    struct stack_frame stack_frame,
+    struct call_state *call_state,
+    struct tac_node *tac_node
+);
+
 static void gen_label_code(
     struct sections *sections,
     struct tac_node *tac_node
@@ -168,6 +366,11 @@ static void gen_print_code(
     struct tac_node *tac_node
 );
 
+static void gen_print_char_code(
+    struct sections *sections,
+    struct symbol *symbol
+);
+
 static void gen_read_code(
     struct sections *sections,
     struct tac_node *tac_node
@@ -212,73 +415,126 @@ static void gen_write_instructions(
     enum x86_64_register reg 
 );
 
-struct x86_64_asm_unit x86_64_pc_linux_gnu_gen(struct tac tac)
+struct x86_64_asm_unit x86_64_pc_linux_gnu_gen(
+    struct tac tac,
+    x86_64_opt_flags_type flags
+)
 {
     struct sections sections = sections_empty();
     gen_data(&sections, tac);
-    gen_code(&sections, tac);
+    gen_code(&sections, tac, flags);
     return sections_finish(sections);
 }
 
 static void gen_data(struct sections *sections, struct tac tac)
 {
+    long length;
     struct tac_node *tac_node;
     struct x86_64_asm_stmt statement;
+    struct x86_64_asm_unit *unit;
+    struct data_layout layout;
 
     statement.tag = X86_64_DIRECTIVE;
     statement.data.directive.name = X86_64_DATA;
     statement.data.directive.operand_count = 0;
     x86_64_asm_unit_push(&sections->data, statement);
 
+    statement.tag = X86_64_DIRECTIVE;
+    statement.data.directive.name = X86_64_BSS;
+    statement.data.directive.operand_count = 0;
+    x86_64_asm_unit_push(&sections->bss, statement);
+
+    statement.tag = X86_64_DIRECTIVE;
+    statement.data.directive.name = X86_64_RODATA;
+    statement.data.directive.operand_count = 0;
+    x86_64_asm_unit_push(&sections->rodata, statement);
+
+    layout = data_layout_scan(tac);
+    unit = &sections->data;
+
     for (tac_node = tac.first; tac_node != NULL; tac_node = tac_node->next) {
         switch (tac_node->instruction.opcode) {
             case TAC_DEFS:
-                statement.tag = X86_64_DIRECTIVE;
-                statement.data.directive.name = X86_64_ALIGN;
-                statement.data.directive.operands[0] =
-                    symbol_table_create_int_lit(datatype_align(
+                unit = data_layout_unit(
+                    sections,
+                    layout,
+                    tac_node->instruction.dest,
+                    is_zero_lit(tac_node->instruction.srcs[0])
+                );
+                gen_data_label(
+                    unit,
+                    tac_node->instruction.dest,
+                    datatype_align(
                         tac_node->instruction.dest->data.variable.type
-                    ));
-                statement.data.directive.operand_count = 1;
-                x86_64_asm_unit_push(&sections->data, statement);
-                statement.tag = X86_64_LABEL;
-                statement.data.label = tac_node->instruction.dest;
-                x86_64_asm_unit_push(&sections->data, statement);
-                gen_sym_def(&sections->data, tac_node->instruction.srcs[0]);
+                    )
+                );
+                if (unit == &sections->bss) {
+                    gen_zeroes_def(unit, tac_node->instruction.dest, 1);
+                } else {
+                    gen_var_def(
+                        unit,
+                        tac_node->instruction.dest,
+                        tac_node->instruction.srcs[0]
+                    );
+                }
                 break;
             case TAC_DEFV:
-                gen_sym_def(&sections->data, tac_node->instruction.srcs[0]);
+                if (unit != &sections->bss) {
+                    gen_var_def(
+                        unit,
+                        tac_node->instruction.dest,
+                        tac_node->instruction.srcs[0]
+                    );
+                }
                 break;
             case TAC_BEGINVEC:
-                statement.tag = X86_64_DIRECTIVE;
-                statement.data.directive.name = X86_64_ALIGN;
-                statement.data.directive.operands[0] =
-                    symbol_table_create_int_lit(datatype_align(
-                        tac_node->instruction.dest->data.variable.type
-                    ));
-                statement.data.directive.operand_count = 1;
-                x86_64_asm_unit_push(&sections->data, statement);
-                statement.tag = X86_64_LABEL;
-                statement.data.label = tac_node->instruction.dest;
-                x86_64_asm_unit_push(&sections->data, statement);
-                break;
-            case TAC_ENDVEC:
-                gen_zeroes_def(
-                    &sections->data,
+                unit = data_layout_unit(
+                    sections,
+                    layout,
+                    tac_node->instruction.dest,
+                    is_zeroed_vector(tac_node)
+                );
+                length = tac_node->instruction.srcs[0]->data.parsed_int;
+                /* large vectors start a cache line of their own */
+                gen_data_label(
+                    unit,
                     tac_node->instruction.dest,
-                    tac_node->instruction.srcs[0]->data.parsed_int
+                    length * x86_64_symbol_data_size(tac_node->instruction.dest)
+                        >= CACHE_LINE_SIZE
+                        ? CACHE_LINE_SIZE
+                        : datatype_align(
+                            tac_node->instruction.dest->data.variable.type
+                        )
                 );
+                if (unit == &sections->bss) {
+                    gen_zeroes_def(unit, tac_node->instruction.dest, length);
+                }
+                break;
+            case TAC_ENDVEC:
+                if (unit != &sections->bss) {
+                    gen_zeroes_def(
+                        unit,
+                        tac_node->instruction.dest,
+                        tac_node->instruction.srcs[0]->data.parsed_int
+                    );
+                }
                 break;
             default:
                 break;
         }
     }
+
+    free(layout.stored_vars);
 }
 
-static void gen_code(struct sections *sections, struct tac tac)
+static void gen_code(
+    struct sections *sections,
+    struct tac tac,
+    x86_64_opt_flags_type flags
+)
 {
     gen_code_headers(sections, tac);
-    gen_code_bodies(sections, tac);
+    gen_code_bodies(sections, tac, flags);
 }
 
 static void gen_code_headers(struct sections *sections, struct tac tac)
@@ -291,11 +547,6 @@ static void gen_code_headers(struct sections *sections, struct tac tac)
     statement.data.directive.operand_count = 0;
     x86_64_asm_unit_push(&sections->text, statement);
 
-    statement.tag = X86_64_DIRECTIVE;
-    statement.data.directive.name = X86_64_RODATA;
-    statement.data.directive.operand_count = 0;
-    x86_64_asm_unit_push(&sections->rodata, statement);
-
     for (tac_node = tac.first; tac_node != NULL; tac_node = tac_node->next) {
         switch (tac_node->instruction.opcode) {
             case TAC_BEGINFUN:
@@ -321,10 +572,15 @@ static void gen_code_headers(struct sections *sections, struct tac tac)
     }
 }
 
-static void gen_code_bodies(struct sections *sections, struct tac tac)
+static void gen_code_bodies(
+    struct sections *sections,
+    struct tac tac,
+    x86_64_opt_flags_type flags
+)
 {
     struct tac_node *tac_node;
     struct call_state call_state;
+    struct stack_frame stack_frame;
     enum x86_64_register_size reg_size;
 
     call_state = call_state_new();
@@ -332,7 +588,7 @@ static void gen_code_bodies(struct sections *sections, struct tac tac)
     for (tac_node = tac.first; tac_node != NULL; tac_node = tac_node->next) {
         switch (tac_node->instruction.opcode) {
             case TAC_BEGINFUN:
-                gen_beginfun_code(sections, tac_node);
+                stack_frame = gen_beginfun_code(sections, tac_node, flags);
                 break;
             case TAC_MOVE:
                 gen_move_code(sections, tac_node);
@@ -344,6 +600,9 @@ static void gen_code_bodies(struct sections *sections, struct tac tac)
                 gen_movv_code(sections, tac_node);
                 break;
             case TAC_MUL:
+                reg_size = x86_64_symbol_reg_size(
+                    tac_node->instruction.srcs[0]
+                );
                 if (reg_size == X86_64_SSE) {
                     gen_float_bin_code(sections, tac_node);
                 } else {
@@ -351,6 +610,9 @@ static void gen_code_bodies(struct sections *sections, struct tac tac)
                 }
                 break;
             case TAC_DIV:
+                reg_size = x86_64_symbol_reg_size(
+                    tac_node->instruction.srcs[0]
+                );
                 if (reg_size == X86_64_SSE) {
                     gen_float_bin_code(sections, tac_node);
                 } else {
@@ -368,9 +630,16 @@ static void gen_code_bodies(struct sections *sections, struct tac tac)
                 }
             case TAC_AND:
             case TAC_OR:
+            case TAC_XOR:
                 gen_simple_int_bin_code(sections, tac_node);
                 break;
+            case TAC_SHL:
+            case TAC_SAR:
+            case TAC_ROL:
+                gen_shift_code(sections, tac_node);
+                break;
             case TAC_NOT:
+            case TAC_COMPL:
                 gen_not_code(sections, tac_node);
                 break;
             case TAC_EQ:
@@ -382,8 +651,18 @@ static void gen_code_bodies(struct sections *sections, struct tac tac)
                 reg_size = x86_64_symbol_reg_size(
                     tac_node->instruction.srcs[0]
                 );
-                if (reg_size == X86_64_SSE) {
+                if (
+                    reg_size == X86_64_SSE
+                    && is_branch_condition(tac_node)
+                ) {
+                    gen_float_comparison_branch_code(sections, tac_node);
+                    /* the branch is taken by the comparison itself */
+                    tac_node = tac_node->next;
+                } else if (reg_size == X86_64_SSE) {
                     gen_float_comparison_code(sections, tac_node);
+                } else if (is_branch_condition(tac_node)) {
+                    gen_int_comparison_branch_code(sections, tac_node);
+                    tac_node = tac_node->next;
                 } else {
                     gen_int_comparison_code(sections, tac_node);
                 }
@@ -394,14 +673,31 @@ static void gen_code_bodies(struct sections *sections, struct tac tac)
             case TAC_SHDIV:
                 gen_shdiv_code(sections, tac_node);
                 break;
+            case TAC_MHDIV:
+                gen_mhdiv_code(sections, tac_node);
+                break;
             case TAC_RET:
-                gen_return_code(sections, tac_node);
+                gen_return_code(sections, stack_frame, tac_node);
                 break;
             case TAC_ARG:
                 gen_arg_code(sections, &call_state, tac_node);
                 break;
             case TAC_CALL:
-                gen_call_code(sections, &call_state, tac_node);
+                if (
+                    (flags & X86_64_OPT_TAIL_CALLS)
+                    && is_tail_call(&call_state, tac_node)
+                ) {
+                    gen_tail_call_code(
+                        sections,
+                        stack_frame,
+                        &call_state,
+                        tac_node
+                    );
+                    /* the return is replaced by the jump */
+                    tac_node = tac_node->next;
+                } else {
+                    gen_call_code(sections, &call_state, tac_node);
+                }
                 break;
             case TAC_LABEL:
                 gen_label_code(sections, tac_node);
@@ -418,21 +714,61 @@ static void gen_code_bodies(struct sections *sections, struct tac tac)
             case TAC_READ:
                 gen_read_code(sections, tac_node);
                 break;
+            case TAC_PLOAD:
+                gen_pload_code(sections, tac_node);
+                break;
+            case TAC_PSTORE:
+                gen_pstore_code(sections, tac_node);
+                break;
+            case TAC_PSPLAT:
+                gen_psplat_code(sections, tac_node);
+                break;
+            case TAC_PADD:
+            case TAC_PSUB:
+            case TAC_PMUL:
+            case TAC_PDIV:
+            case TAC_PAND:
+            case TAC_POR:
+            case TAC_PXOR:
+                gen_packed_bin_code(sections, tac_node);
+                break;
+            case TAC_PSUM:
+                gen_psum_code(sections, tac_node);
+                break;
+            case TAC_REP:
+                gen_rep_code(sections, tac_node);
+                break;
+            case TAC_FILL:
+                gen_fill_code(sections, tac_node);
+                break;
+            case TAC_COPY:
+                gen_copy_code(sections, tac_node);
+                break;
             default:
                 break;
         }
     }
 
+    gen_input_buffer(sections);
     gen_read_function(sections);
+    gen_fill_input_function(sections);
+    gen_output_buffer(sections);
+    gen_flush_function(sections);
+    gen_write_bytes_function(sections);
+    gen_write_int_function(sections);
+    gen_write_real_function(sections);
 }
 
 static struct stack_frame gen_beginfun_code(
     struct sections *sections,
-    struct tac_node *tac_node
+    struct tac_node *tac_node,
+    x86_64_opt_flags_type flags
 )
 {
     int is_parameter_register;
-    size_t i, arg_i, sse_arg_i, stack_arg_i;
+    int is_register_saved[X86_64_REGALLOC_REGISTERS] = { 0 };
+    size_t i, arg_i, sse_arg_i, stack_arg_i, register_index;
+    size_t slot_count;
     size_t stack_frame_byte_size;
     enum x86_64_register reg;
     enum x86_64_register_size reg_size;
@@ -445,6 +781,24 @@ static struct stack_frame gen_beginfun_code(
     struct symbol *tac_operands[TAC_MAX_OPERANDS] = { NULL };
 
     stack_frame.size = 0;
+    stack_frame.saved_register_count = 0;
+
+    if (flags & X86_64_OPT_FRAME_PARAMS) {
+        lookahead_node = tac_node->next;
+        while (
+            lookahead_node != NULL
+            && lookahead_node->instruction.opcode == TAC_DEFP
+        ) {
+            lookahead_node->instruction.dest->data.variable.stack_frame_index =
+                stack_frame.size * 8;
+            stack_frame.size++;
+            lookahead_node = lookahead_node->next;
+        }
+    }
+
+    if (flags & X86_64_OPT_REGALLOC) {
+        x86_64_regalloc_function(tac_node);
+    }
 
     statement.tag = X86_64_LABEL;
     statement.data.label = tac_node->instruction.dest;
@@ -452,6 +806,90 @@ static struct stack_frame gen_beginfun_code(
 
     gen_enter_boilerplate(sections);
 
+    lookahead_node = tac_node;
+    while (
+        lookahead_node != NULL
+        && lookahead_node->instruction.opcode != TAC_ENDFUN
+    ) {
+        tac_operands[0] = lookahead_node->instruction.dest;
+        tac_operands[1] = lookahead_node->instruction.srcs[0];
+        tac_operands[2] = lookahead_node->instruction.srcs[1];
+        for (i = 0; i < TAC_MAX_OPERANDS; i++) {
+            if (
+                tac_operands[i] != NULL
+                && tac_operands[i]->type == SYM_TMP_VECTOR_VAR
+            ) {
+                if (
+                    tac_operands[i]->data.variable.stack_frame_index
+                    == SIZE_MAX
+                ) {
+                    slot_count = (
+                        tac_operands[i]->data.variable.length
+                        * x86_64_symbol_data_size(tac_operands[i])
+                        + 7
+                    ) / 8;
+                    if (slot_count == 0) {
+                        slot_count = 1;
+                    }
+                    /* the element 0 sits at the lowest address of the slots */
+                    tac_operands[i]->data.variable.stack_frame_index =
+                        (stack_frame.size + slot_count - 1) * 8;
+                    stack_frame.size += slot_count;
+                }
+                continue;
+            }
+            if (
+                tac_operands[i] == NULL
+                || (
+                    tac_operands[i]->type != SYM_TMP_VAR
+                    && !is_frame_param(tac_operands[i])
+                )
+            ) {
+                continue;
+            }
+            register_index = tac_operands[i]->data.variable.register_index;
+            if (register_index != SIZE_MAX) {
+                if (
+                    x86_64_regalloc_is_callee_saved(register_index)
+                    && !is_register_saved[register_index]
+                ) {
+                    is_register_saved[register_index] = 1;
+                    stack_frame.saved_registers[
+                        stack_frame.saved_register_count
+                    ] = register_index;
+                    stack_frame.saved_register_count++;
+                }
+            } else if (
+                tac_operands[i]->data.variable.stack_frame_index == SIZE_MAX
+            ) {
+                tac_operands[i]->data.variable.stack_frame_index =
+                    stack_frame.size * 8;
+                stack_frame.size++;
+            }
+        }
+        lookahead_node = lookahead_node->next;
+    }
+
+    stack_frame.saved_registers_index = stack_frame.size;
+    stack_frame.size += stack_frame.saved_register_count;
+    
+    stack_frame_byte_size = stack_frame.size * 8;
+    if (stack_frame_byte_size % 16 != 0) {
+        stack_frame_byte_size += 8;
+    }
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_SUB;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RSP;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_IMMEDIATE;
+    statement.data.instruction.operands[1].data.immediate =
+        symbol_table_create_int_lit(stack_frame_byte_size);
+    statement.data.instruction.operand_count = 2;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    gen_saved_registers_code(sections, stack_frame, 0);
+
     lookahead_node = tac_node->next;
     first_sse_stack_node = NULL;
     first_stack_node = NULL;
@@ -461,10 +899,20 @@ static struct stack_frame gen_beginfun_code(
     while (
         lookahead_node != NULL && lookahead_node->instruction.opcode == TAC_DEFP
     ) {
-        statement.tag = X86_64_LABEL;
-        statement.data.label = lookahead_node->instruction.dest;
-        x86_64_asm_unit_push(&sections->data, statement);
-        gen_sym_def(&sections->data, symbol_table_create_int_lit(0));
+        if (!is_frame_param(lookahead_node->instruction.dest)) {
+            gen_data_label(
+                &sections->bss,
+                lookahead_node->instruction.dest,
+                datatype_align(
+                    lookahead_node->instruction.dest->data.variable.type
+                )
+            );
+            gen_zeroes_def(
+                &sections->bss,
+                lookahead_node->instruction.dest,
+                1
+            );
+        }
 
         reg_size = x86_64_symbol_reg_size(lookahead_node->instruction.dest);
 
@@ -554,45 +1002,44 @@ static struct stack_frame gen_beginfun_code(
         lookahead_node = lookahead_node->prev;
     }
 
-    lookahead_node = tac_node;
-    while (
-        lookahead_node != NULL
-        && lookahead_node->instruction.opcode != TAC_ENDFUN
-    ) {
-        tac_operands[0] = lookahead_node->instruction.dest;
-        tac_operands[1] = lookahead_node->instruction.srcs[0];
-        tac_operands[2] = lookahead_node->instruction.srcs[1];
-        for (i = 0; i < TAC_MAX_OPERANDS; i++) {
-            if (
-                tac_operands[i] != NULL
-                && tac_operands[i]->type == SYM_TMP_VAR
-                && tac_operands[i]->data.variable
-                    .stack_frame_index == SIZE_MAX
-            ) {
-                tac_operands[i]->data.variable.stack_frame_index =
-                    stack_frame.size * 8;
-                stack_frame.size++;
-            }
-        }
-        lookahead_node = lookahead_node->next;
-    }
-    
-    stack_frame_byte_size = stack_frame.size * 8;
-    if (stack_frame_byte_size % 16 != 0) {
-        stack_frame_byte_size += 8;
-    }
+    return stack_frame;
+}
 
-    statement.tag = X86_64_INSTRUCTION;
-    statement.data.instruction.opcode = X86_64_SUB;
-    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
-    statement.data.instruction.operands[0].data.direct = X86_64_RSP;
-    statement.data.instruction.operands[1].tag = X86_64_OPERAND_IMMEDIATE;
-    statement.data.instruction.operands[1].data.immediate =
-        symbol_table_create_int_lit(stack_frame_byte_size);
-    statement.data.instruction.operand_count = 2;
-    x86_64_asm_unit_push(&sections->text, statement);
+static void gen_saved_registers_code(
+    struct sections *sections,
+    struct stack_frame stack_frame,
+    int restore
+)
+{
+    size_t i;
+    struct x86_64_operand register_operand;
+    struct x86_64_operand slot_operand;
+    struct x86_64_asm_stmt statement;
 
-    return stack_frame;
+    for (i = 0; i < stack_frame.saved_register_count; i++) {
+        register_operand.tag = X86_64_OPERAND_DIRECT;
+        register_operand.data.direct =
+            x86_64_regalloc_register(stack_frame.saved_registers[i]);
+
+        slot_operand.tag = X86_64_OPERAND_DISPLACED;
+        slot_operand.data.displaced.base = X86_64_RBP;
+        slot_operand.data.displaced.displacement =
+            symbol_table_create_int_lit(
+                - (long) (stack_frame.saved_registers_index + i) * 8 - 8
+            );
+
+        statement.tag = X86_64_INSTRUCTION;
+        statement.data.instruction.opcode = X86_64_MOV;
+        statement.data.instruction.operand_count = 2;
+        if (restore) {
+            statement.data.instruction.operands[0] = register_operand;
+            statement.data.instruction.operands[1] = slot_operand;
+        } else {
+            statement.data.instruction.operands[0] = slot_operand;
+            statement.data.instruction.operands[1] = register_operand;
+        }
+        x86_64_asm_unit_push(&sections->text, statement);
+    }
 }
 
 static void gen_char_def(struct x86_64_asm_unit *unit, struct symbol *ch_sym)
@@ -619,6 +1066,16 @@ static void gen_int_def(struct x86_64_asm_unit *unit, struct symbol *int_sym)
     x86_64_asm_unit_push(unit, statement);
 }
 
+static void gen_natu_def(struct x86_64_asm_unit *unit, struct symbol *int_sym)
+{
+    struct x86_64_asm_stmt statement;
+    statement.tag = X86_64_DIRECTIVE;
+    statement.data.directive.name = X86_64_LONG;
+    statement.data.directive.operands[0] = int_sym;
+    statement.data.directive.operand_count = 1;
+    x86_64_asm_unit_push(unit, statement);
+}
+
 static void gen_float_def(struct x86_64_asm_unit *unit, struct symbol *f_sym)
 {
     struct x86_64_asm_stmt statement;
@@ -662,6 +1119,20 @@ static void gen_sym_def(struct x86_64_asm_unit *unit, struct symbol *symbol)
     }
 }
 
+/* natu values take four bytes, while int literals are otherwise quads */
+static void gen_var_def(
+    struct x86_64_asm_unit *unit,
+    struct symbol *variable,
+    struct symbol *value
+)
+{
+    if (variable->data.variable.type == DATATYPE_NATU) {
+        gen_natu_def(unit, value);
+    } else {
+        gen_sym_def(unit, value);
+    }
+}
+
 static void gen_zeroes_def(
     struct x86_64_asm_unit *unit,
     struct symbol *vector,
@@ -676,6 +1147,9 @@ static void gen_zeroes_def(
         case DATATYPE_REAL:
             size *= 8;
             break;
+        case DATATYPE_NATU:
+            size *= 4;
+            break;
         case DATATYPE_CARA:
             break;
         default:
@@ -695,6 +1169,128 @@ static void gen_zeroes_def(
     }
 }
 
+static void gen_data_label(
+    struct x86_64_asm_unit *unit,
+    struct symbol *variable,
+    long align
+)
+{
+    struct x86_64_asm_stmt statement;
+
+    statement.tag = X86_64_DIRECTIVE;
+    statement.data.directive.name = X86_64_ALIGN;
+    statement.data.directive.operands[0] = symbol_table_create_int_lit(align);
+    statement.data.directive.operand_count = 1;
+    x86_64_asm_unit_push(unit, statement);
+
+    statement.tag = X86_64_LABEL;
+    statement.data.label = variable;
+    x86_64_asm_unit_push(unit, statement);
+}
+
+static struct data_layout data_layout_scan(struct tac tac)
+{
+    size_t i;
+    struct tac_node *tac_node;
+    struct symbol *dest;
+    struct data_layout layout;
+
+    layout.stored_vars = vector_empty(&layout.stored_var_count);
+
+    for (tac_node = tac.first; tac_node != NULL; tac_node = tac_node->next) {
+        dest = tac_node->instruction.dest;
+        switch (tac_node->instruction.opcode) {
+            case TAC_MOVV:
+            case TAC_PSTORE:
+            case TAC_FILL:
+            case TAC_COPY:
+                break;
+            default:
+                if (
+                    !tac_defines_dest(tac_node->instruction.opcode)
+                    || dest == NULL
+                    || dest->type != SYM_SCALAR_VAR
+                ) {
+                    continue;
+                }
+                break;
+        }
+
+        i = 0;
+        while (i < layout.stored_var_count && layout.stored_vars[i] != dest) {
+            i++;
+        }
+        if (i == layout.stored_var_count) {
+            layout.stored_vars = vector_push(
+                layout.stored_vars,
+                sizeof(*layout.stored_vars),
+                &layout.stored_var_count,
+                &dest
+            );
+        }
+    }
+
+    return layout;
+}
+
+/*
+ * Globals never stored to are only read, and the ones starting with zeroes
+ * need no room in the file.
+ */
+static struct x86_64_asm_unit *data_layout_unit(
+    struct sections *sections,
+    struct data_layout layout,
+    struct symbol *variable,
+    int is_zeroed
+)
+{
+    size_t i;
+
+    for (i = 0; i < layout.stored_var_count; i++) {
+        if (layout.stored_vars[i] == variable) {
+            return is_zeroed ? &sections->bss : &sections->data;
+        }
+    }
+    return &sections->rodata;
+}
+
+static int is_zeroed_vector(struct tac_node *beginvec_node)
+{
+    struct tac_node *tac_node;
+
+    for (
+        tac_node = beginvec_node->next;
+        tac_node->instruction.opcode == TAC_DEFV;
+        tac_node = tac_node->next
+    ) {
+        if (!is_zero_lit(tac_node->instruction.srcs[0])) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int is_zero_lit(struct symbol *symbol)
+{
+    double zero = 0.0;
+
+    switch (symbol->type) {
+        case SYM_LIT_INT:
+            return symbol->data.parsed_int == 0;
+        case SYM_LIT_CHAR:
+            return symbol->data.parsed_char == 0;
+        case SYM_LIT_FLOAT:
+            /* negative zero has its sign bit set */
+            return memcmp(
+                &symbol->data.float_.parsed,
+                &zero,
+                sizeof(zero)
+            ) == 0;
+        default:
+            return 0;
+    }
+}
+
 static struct x86_64_operand value_operand_from_sym(
     struct sections *sections,
     struct symbol *symbol
@@ -705,12 +1301,8 @@ static struct x86_64_operand value_operand_from_sym(
 
     switch (symbol->type) {
         case SYM_TMP_VAR:
-            operand.tag = X86_64_OPERAND_DISPLACED;
-            operand.data.displaced.base = X86_64_RBP;
-            operand.data.displaced.displacement =
-                symbol_table_create_int_lit(
-                    - (long)  symbol->data.variable.stack_frame_index - 8
-                );
+        case SYM_TMP_VECTOR_VAR:
+            operand = frame_operand_from_sym(symbol);
             break;
 
         case SYM_LIT_STR:
@@ -759,14 +1351,33 @@ static struct x86_64_operand value_operand_from_sym(
             operand.data.direct = X86_64_R11;
             break;
 
-        case SYM_VECTOR_VAR:
         case SYM_SCALAR_VAR:
+            if (is_frame_param(symbol)) {
+                operand = frame_operand_from_sym(symbol);
+                break;
+            }
+        case SYM_VECTOR_VAR:
             operand.tag = X86_64_OPERAND_DISPLACED;
             operand.data.displaced.base = X86_64_RIP;
             operand.data.displaced.displacement = symbol;
             break;
 
         case SYM_LIT_FLOAT:
+            if (is_zero_lit(symbol)) {
+                statement.tag = X86_64_INSTRUCTION;
+                statement.data.instruction.opcode = X86_64_XORPD;
+                statement.data.instruction.operand_count = 2;
+                statement.data.instruction.operands[0].tag =
+                    X86_64_OPERAND_DIRECT;
+                statement.data.instruction.operands[0].data.direct =
+                    X86_64_XMM12;
+                statement.data.instruction.operands[1] =
+                    statement.data.instruction.operands[0];
+                x86_64_asm_unit_push(&sections->text, statement);
+
+                operand = statement.data.instruction.operands[0];
+                break;
+            }
             gen_float_sym(sections, symbol);
             symbol = symbol->data.float_.identifier;
         case SYM_FLOAT_ADDR:
@@ -798,6 +1409,74 @@ static struct x86_64_operand value_operand_from_sym(
     return operand;
 }
 
+/*
+ * Integers narrower than a quadword are zero-extended into R11, as loads into
+ * register slices are, so they combine with wider values at their width.
+ */
+static struct x86_64_operand widened_operand_from_sym(
+    struct sections *sections,
+    struct symbol *symbol
+)
+{
+    struct x86_64_asm_stmt statement;
+    struct x86_64_operand operand;
+    enum x86_64_register_size reg_size;
+
+    operand = value_operand_from_sym(sections, symbol);
+    reg_size = x86_64_symbol_reg_size(symbol);
+    if (reg_size == X86_64_QWORD) {
+        return operand;
+    }
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_R11;
+    if (operand.tag != X86_64_OPERAND_IMMEDIATE) {
+        if (reg_size == X86_64_BYTE) {
+            statement.data.instruction.opcode = X86_64_MOVZB;
+        } else {
+            /* writing the low doubleword already clears the rest */
+            statement.data.instruction.operands[0].data.direct = X86_64_R11D;
+        }
+    }
+    statement.data.instruction.operands[1] = operand;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    operand.tag = X86_64_OPERAND_DIRECT;
+    operand.data.direct = X86_64_R11;
+    return operand;
+}
+
+static struct x86_64_operand frame_operand_from_sym(struct symbol *symbol)
+{
+    struct x86_64_operand operand;
+
+    if (symbol->data.variable.register_index != SIZE_MAX) {
+        operand.tag = X86_64_OPERAND_DIRECT;
+        operand.data.direct = x86_64_make_register_of_size(
+            x86_64_symbol_reg_size(symbol),
+            x86_64_regalloc_register(symbol->data.variable.register_index)
+        );
+    } else {
+        operand.tag = X86_64_OPERAND_DISPLACED;
+        operand.data.displaced.base = X86_64_RBP;
+        operand.data.displaced.displacement =
+            symbol_table_create_int_lit(
+                - (long)  symbol->data.variable.stack_frame_index - 8
+            );
+    }
+
+    return operand;
+}
+
+static int is_frame_param(struct symbol *symbol)
+{
+    return symbol->type == SYM_SCALAR_VAR
+        && symbol->data.variable.stack_frame_index != SIZE_MAX;
+}
+
 static struct x86_64_operand address_operand_from_sym(
     struct sections *sections,
     struct symbol *symbol
@@ -857,6 +1536,7 @@ static struct sections sections_empty(void)
 {
     struct sections sections;
     sections.data = x86_64_asm_unit_empty();
+    sections.bss = x86_64_asm_unit_empty();
     sections.rodata = x86_64_asm_unit_empty();
     sections.text = x86_64_asm_unit_empty();
     return sections;
@@ -865,8 +1545,9 @@ static struct sections sections_empty(void)
 static struct x86_64_asm_unit sections_finish(struct sections sections)
 {
     return x86_64_asm_unit_join(
-        3,
+        4,
         sections.data,
+        sections.bss,
         sections.rodata,
         sections.text
     );
@@ -877,6 +1558,7 @@ static void gen_simple_int_bin_code(
     struct tac_node *tac_node
 )
 {
+    struct x86_64_asm_stmt statement;
     enum x86_64_opcode opcode;
 
     gen_read_instructions(
@@ -899,16 +1581,27 @@ static void gen_simple_int_bin_code(
         case TAC_OR:
             opcode = X86_64_OR;
             break;
+        case TAC_XOR:
+            opcode = X86_64_XOR;
+            break;
         default:
-            panic("gen_simple_int_bin_code should only be called with ADD, SUB, AND and OR");
+            panic("gen_simple_int_bin_code should only be called with ADD, SUB, AND, OR and XOR");
     }
 
-    gen_read_instructions(
+    /*
+     * operands may be of different integer types, so both are combined as
+     * quadwords and the destination keeps the low part it fits
+     */
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = opcode;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RAX;
+    statement.data.instruction.operands[1] = widened_operand_from_sym(
         sections,
-        tac_node->instruction.srcs[1],
-        opcode,
-        X86_64_RAX
+        tac_node->instruction.srcs[1]
     );
+    x86_64_asm_unit_push(&sections->text, statement);
 
     gen_write_instructions(
         sections,
@@ -920,6 +1613,7 @@ static void gen_simple_int_bin_code(
 
 static void gen_return_code(
     struct sections *sections,
+    struct stack_frame stack_frame,
     struct tac_node *tac_node
 )
 {
@@ -944,6 +1638,7 @@ static void gen_return_code(
         reg
     );
 
+    gen_saved_registers_code(sections, stack_frame, 1);
     gen_leave_boilerplate(sections);
 }
 
@@ -1098,6 +1793,48 @@ static void gen_call_code(
     *call_state = call_state_new();
 }
 
+static int is_tail_call(
+    struct call_state const *call_state,
+    struct tac_node *tac_node
+)
+{
+    struct tac_node *next_node;
+
+    next_node = tac_node->next;
+
+    /*
+     * arguments passed on the stack would have to overwrite the incoming ones
+     * of the caller, so only register-only calls are turned into jumps
+     */
+    return next_node != NULL
+        && next_node->instruction.opcode == TAC_RET
+        && next_node->instruction.srcs[0] == tac_node->instruction.dest
+        && call_state->stack_arg_count == 0;
+}
+
+static void gen_tail_call_code(
+    struct sections *sections,
+    struct stack_frame stack_frame,
+    struct call_state *call_state,
+    struct tac_node *tac_node
+)
+{
+    struct x86_64_asm_stmt statement;
+
+    gen_saved_registers_code(sections, stack_frame, 1);
+    gen_unwind_boilerplate(sections);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_JMP;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
+    statement.data.instruction.operands[0].data.address =
+        tac_node->instruction.srcs[0];
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    *call_state = call_state_new();
+}
+
 static int parameter_register(size_t param_index, enum x86_64_register *reg)
 {
     switch (param_index) {
@@ -1172,13 +1909,12 @@ static void gen_print_code(
     struct tac_node *tac_node
 )
 {
-    int sse_count = 0;
     enum x86_64_register param_reg;
     struct x86_64_operand operand;
     enum x86_64_opcode opcode;
     struct x86_64_asm_stmt statement;
     enum datatype datatype;
-    struct symbol *format_spec;
+    struct symbol *routine;
     int is_string = 0;
 
     switch (tac_node->instruction.srcs[0]->type) {
@@ -1219,19 +1955,6 @@ static void gen_print_code(
         statement.data.instruction.operands[1] = operand;
         x86_64_asm_unit_push(&sections->text, statement);
 
-        operand = value_operand_from_sym(
-            sections,
-            symbol_table_create_int_lit(1)
-        );
-
-        statement.tag = X86_64_INSTRUCTION;
-        statement.data.instruction.opcode = X86_64_MOV;
-        statement.data.instruction.operand_count = 2;
-        statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
-        statement.data.instruction.operands[0].data.direct = X86_64_RSI;
-        statement.data.instruction.operands[1] = operand;
-        x86_64_asm_unit_push(&sections->text, statement);
-
         operand = value_operand_from_sym(
             sections,
             symbol_table_create_int_lit(
@@ -1243,103 +1966,161 @@ static void gen_print_code(
         statement.data.instruction.opcode = X86_64_MOV;
         statement.data.instruction.operand_count = 2;
         statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
-        statement.data.instruction.operands[0].data.direct = X86_64_RDX;
+        statement.data.instruction.operands[0].data.direct = X86_64_RSI;
         statement.data.instruction.operands[1] = operand;
         x86_64_asm_unit_push(&sections->text, statement);
 
-        statement.tag = X86_64_INSTRUCTION;
-        statement.data.instruction.opcode = X86_64_MOV;
-        statement.data.instruction.operand_count = 2;
-        statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
-        statement.data.instruction.operands[0].data.direct = X86_64_RCX;
-        statement.data.instruction.operands[1].tag =
-            X86_64_OPERAND_DISPLACED;
-        statement.data.instruction.operands[1].data.displaced.base =
-            X86_64_RIP;
-        statement.data.instruction.operands[1].data.displaced.displacement =
-            symbol_table_insert("stdout");
-        statement.data.instruction.operands[1].data.displaced.displacement
-            ->type = SYM_SCALAR_VAR;
-        statement.data.instruction.operands[1].data.displaced.displacement
-            ->data.variable.in_scope = 1;
-        statement.data.instruction.operands[1].data.displaced.displacement
-            ->data.variable.type = DATATYPE_INTE;
-        x86_64_asm_unit_push(&sections->text, statement);
-
-        statement.tag = X86_64_INSTRUCTION;
-        statement.data.instruction.opcode = X86_64_CALL;
-        statement.data.instruction.operand_count = 1;
-        statement.data.instruction.operands[0].tag = X86_64_OPERAND_PLT;
-        statement.data.instruction.operands[0].data.address =
-            symbol_table_insert("fwrite");
-        statement.data.instruction.operands[0].data.address->type =
-            SYM_EXTERNAL;
-        x86_64_asm_unit_push(&sections->text, statement);
+        routine = symbol_table_insert("@write_bytes");
     } else {
         switch (datatype) {
             case DATATYPE_CARA:
-                format_spec = symbol_table_create_str_lit("%c\\0");
-                opcode = X86_64_MOV;
-                param_reg = X86_64_RSI;
-                break;
+                gen_print_char_code(sections, tac_node->instruction.srcs[0]);
+                return;
             case DATATYPE_INTE:
-                format_spec = symbol_table_create_str_lit("%li\\0");
+            case DATATYPE_NATU:
+                routine = symbol_table_insert("@write_int");
                 opcode = X86_64_MOV;
-                param_reg = X86_64_RSI;
+                param_reg = X86_64_RDI;
                 break;
             case DATATYPE_REAL:
-                format_spec = symbol_table_create_str_lit("%lf\\0");
+                routine = symbol_table_insert("@write_real");
                 opcode = X86_64_MOVQ;
                 param_reg = X86_64_XMM0;
-                sse_count += 1;
                 break;
         }
 
-        gen_read_instructions(
-            sections,
-            format_spec,
-            X86_64_MOV,
-            X86_64_RDI
-        );
-
         gen_read_instructions(
             sections,
             tac_node->instruction.srcs[0],
             opcode,
             param_reg
         );
-
-        statement.tag = X86_64_INSTRUCTION;
-        statement.data.instruction.opcode = X86_64_MOV;
-        statement.data.instruction.operand_count = 2;
-        statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
-        statement.data.instruction.operands[0].data.direct = X86_64_RAX;
-        statement.data.instruction.operands[1].tag = X86_64_OPERAND_IMMEDIATE;
-        statement.data.instruction.operands[1].data.immediate =
-            symbol_table_create_int_lit(sse_count);
-        x86_64_asm_unit_push(&sections->text, statement);
-
-        statement.tag = X86_64_INSTRUCTION;
-        statement.data.instruction.opcode = X86_64_CALL;
-        statement.data.instruction.operand_count = 1;
-        statement.data.instruction.operands[0].tag = X86_64_OPERAND_PLT;
-        statement.data.instruction.operands[0].data.address =
-            symbol_table_insert("printf");
-        statement.data.instruction.operands[0].data.address->type =
-            SYM_EXTERNAL;
-        x86_64_asm_unit_push(&sections->text, statement);
     }
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_CALL;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
+    statement.data.instruction.operands[0].data.address = routine;
+    statement.data.instruction.operands[0].data.address->type = SYM_LABEL;
+    x86_64_asm_unit_push(&sections->text, statement);
 }
 
-static void gen_read_code(
+static void gen_print_char_code(
     struct sections *sections,
-    struct tac_node *tac_node
+    struct symbol *symbol
 )
 {
     struct x86_64_asm_stmt statement;
+    struct symbol *fast_path;
+
+    fast_path = symbol_table_create_tmp_label();
 
     statement.tag = X86_64_INSTRUCTION;
-    statement.data.instruction.opcode = X86_64_CALL;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RAX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DISPLACED;
+    statement.data.instruction.operands[1].data.displaced.base = X86_64_RIP;
+    statement.data.instruction.operands[1].data.displaced.displacement =
+        runtime_var_sym("@outpos", DATATYPE_INTE);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_CMP;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RAX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_IMMEDIATE;
+    statement.data.instruction.operands[1].data.immediate =
+        symbol_table_create_int_lit(OUTPUT_BUFFER_SIZE);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_JL;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
+    statement.data.instruction.operands[0].data.address = fast_path;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_CALL;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
+    statement.data.instruction.operands[0].data.address =
+        symbol_table_insert("@flush");
+    statement.data.instruction.operands[0].data.address->type =
+        SYM_LABEL;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_XOR;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RAX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_RAX;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_LABEL;
+    statement.data.label = fast_path;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    gen_read_instructions(sections, symbol, X86_64_MOV, X86_64_R9);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_LEA;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RCX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DISPLACED;
+    statement.data.instruction.operands[1].data.displaced.base = X86_64_RIP;
+    statement.data.instruction.operands[1].data.displaced.displacement =
+        runtime_var_sym("@outbuf", DATATYPE_CARA);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_INDEXED;
+    statement.data.instruction.operands[0].data.indexed.base = X86_64_RCX;
+    statement.data.instruction.operands[0].data.indexed.index = X86_64_RAX;
+    statement.data.instruction.operands[0].data.indexed.scale = 1;
+    statement.data.instruction.operands[0].data.indexed.displacement =
+       symbol_table_create_int_lit(0);
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_R9B;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_INC;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RAX;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DISPLACED;
+    statement.data.instruction.operands[0].data.displaced.base = X86_64_RIP;
+    statement.data.instruction.operands[0].data.displaced.displacement =
+        runtime_var_sym("@outpos", DATATYPE_INTE);
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_RAX;
+    x86_64_asm_unit_push(&sections->text, statement);
+}
+
+static void gen_read_code(
+    struct sections *sections,
+    struct tac_node *tac_node
+)
+{
+    struct x86_64_asm_stmt statement;
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_CALL;
     statement.data.instruction.operand_count = 1;
     statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
     statement.data.instruction.operands[0].data.address =
@@ -1529,6 +2310,7 @@ static void gen_float_comparison_code(
         case TAC_LE:
             check_prepare_reg_slice(sections, X86_64_R11B);
             check_prepare_reg_slice(sections, X86_64_R10B);
+            check_prepare_reg_slice(sections, X86_64_R9B);
             statement.tag = X86_64_INSTRUCTION;
             statement.data.instruction.opcode = X86_64_SETC;
             statement.data.instruction.operand_count = 1;
@@ -1541,6 +2323,13 @@ static void gen_float_comparison_code(
             statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
             statement.data.instruction.operands[0].data.direct = X86_64_R10B;
             x86_64_asm_unit_push(&sections->text, statement);
+            /* the parity must be read before the or below overwrites it */
+            statement.tag = X86_64_INSTRUCTION;
+            statement.data.instruction.opcode = X86_64_SETNP;
+            statement.data.instruction.operand_count = 1;
+            statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+            statement.data.instruction.operands[0].data.direct = X86_64_R9B;
+            x86_64_asm_unit_push(&sections->text, statement);
             statement.tag = X86_64_INSTRUCTION;
             statement.data.instruction.opcode = X86_64_OR;
             statement.data.instruction.operand_count = 2;
@@ -1550,18 +2339,12 @@ static void gen_float_comparison_code(
             statement.data.instruction.operands[1].data.direct = X86_64_R10;
             x86_64_asm_unit_push(&sections->text, statement);
             statement.tag = X86_64_INSTRUCTION;
-            statement.data.instruction.opcode = X86_64_SETNP;
-            statement.data.instruction.operand_count = 1;
-            statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
-            statement.data.instruction.operands[0].data.direct = X86_64_R10B;
-            x86_64_asm_unit_push(&sections->text, statement);
-            statement.tag = X86_64_INSTRUCTION;
             statement.data.instruction.opcode = X86_64_AND;
             statement.data.instruction.operand_count = 2;
             statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
             statement.data.instruction.operands[0].data.direct = X86_64_R11;
             statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
-            statement.data.instruction.operands[1].data.direct = X86_64_R10;
+            statement.data.instruction.operands[1].data.direct = X86_64_R9;
             x86_64_asm_unit_push(&sections->text, statement);
             break;
 
@@ -1612,35 +2395,154 @@ static void gen_float_comparison_code(
     );
 }
 
-static void gen_int_comparison_code(
+static void gen_float_comparison_branch_code(
     struct sections *sections,
     struct tac_node *tac_node
 )
 {
     struct x86_64_asm_stmt statement;
+    struct x86_64_operand operand;
+    struct symbol *left, *right, *label;
+    enum tac_opcode opcode;
+
+    left = tac_node->instruction.srcs[0];
+    right = tac_node->instruction.srcs[1];
+    opcode = tac_node->instruction.opcode;
+    label = tac_node->next->instruction.dest;
+
+    /* less than is greater than with swapped operands, keeping NaN false */
+    if (opcode == TAC_LT || opcode == TAC_LE) {
+        left = tac_node->instruction.srcs[1];
+        right = tac_node->instruction.srcs[0];
+        opcode = opcode == TAC_LT ? TAC_GT : TAC_GE;
+    }
 
-    gen_read_instructions(
-        sections,
-        tac_node->instruction.srcs[0],
-        X86_64_MOV,
-        X86_64_RAX
-    );
-
-    gen_read_instructions(
-        sections,
-        tac_node->instruction.srcs[1],
-        X86_64_MOV,
-        X86_64_R10
-    );
+    operand = value_operand_from_sym(sections, left);
+    if (
+        operand.tag != X86_64_OPERAND_DIRECT
+        || operand.data.direct == X86_64_XMM12
+    ) {
+        statement.tag = X86_64_INSTRUCTION;
+        statement.data.instruction.opcode = X86_64_MOVSD;
+        statement.data.instruction.operand_count = 2;
+        statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+        statement.data.instruction.operands[0].data.direct = X86_64_XMM13;
+        statement.data.instruction.operands[1] = operand;
+        x86_64_asm_unit_push(&sections->text, statement);
+        operand = statement.data.instruction.operands[0];
+    }
 
     statement.tag = X86_64_INSTRUCTION;
-    statement.data.instruction.opcode = X86_64_CMP;
+    statement.data.instruction.opcode = X86_64_UCOMISD;
     statement.data.instruction.operand_count = 2;
-    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
-    statement.data.instruction.operands[0].data.direct = X86_64_RAX;
-    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
-    statement.data.instruction.operands[1].data.direct = X86_64_R10;
+    statement.data.instruction.operands[0] = operand;
+    statement.data.instruction.operands[1] =
+        value_operand_from_sym(sections, right);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    /* jumps whenever the comparison is false, unordered included */
+    switch (opcode) {
+        case TAC_EQ:
+            gen_branch_instruction(sections, X86_64_JNZ, label);
+            gen_branch_instruction(sections, X86_64_JP, label);
+            break;
+
+        case TAC_NE:
+            gen_branch_instruction(sections, X86_64_JZ, label);
+            break;
+
+        case TAC_GT:
+            gen_branch_instruction(sections, X86_64_JC, label);
+            gen_branch_instruction(sections, X86_64_JZ, label);
+            break;
+
+        case TAC_GE:
+            gen_branch_instruction(sections, X86_64_JC, label);
+            break;
+
+        default:
+            panic("gen_float_comparison_branch_code should only be called with comparison operators");
+    }
+}
+
+/*
+ * A comparison whose result is only tested by the branch right after it does
+ * not need to be stored. Temporaries are reused, so a read only counts when it
+ * is not preceded by another definition in the same straight-line code.
+ */
+static int is_branch_condition(struct tac_node *tac_node)
+{
+    struct tac_node *node, *branch;
+    struct symbol *condition;
+    int redefined;
+
+    branch = tac_node->next;
+    condition = tac_node->instruction.dest;
+    if (
+        branch == NULL
+        || branch->instruction.opcode != TAC_IFZ
+        || branch->instruction.srcs[0] != condition
+        || condition->type != SYM_TMP_VAR
+    ) {
+        return 0;
+    }
+
+    node = tac_node;
+    while (node->instruction.opcode != TAC_BEGINFUN) {
+        node = node->prev;
+    }
+
+    redefined = 0;
+    while (node->instruction.opcode != TAC_ENDFUN) {
+        if (node->instruction.opcode == TAC_LABEL) {
+            redefined = 0;
+        }
+        if (
+            node != branch
+            && !redefined
+            && (
+                node->instruction.srcs[0] == condition
+                || node->instruction.srcs[1] == condition
+            )
+        ) {
+            return 0;
+        }
+        if (
+            node != tac_node
+            && node->instruction.dest == condition
+            && tac_defines_dest(node->instruction.opcode)
+        ) {
+            redefined = 1;
+        }
+        node = node->next;
+    }
+    return 1;
+}
+
+static void gen_branch_instruction(
+    struct sections *sections,
+    enum x86_64_opcode opcode,
+    struct symbol *label
+)
+{
+    struct x86_64_asm_stmt statement;
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = opcode;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
+    statement.data.instruction.operands[0].data.address = label;
     x86_64_asm_unit_push(&sections->text, statement);
+}
+
+static void gen_int_comparison_code(
+    struct sections *sections,
+    struct tac_node *tac_node
+)
+{
+    struct x86_64_asm_stmt statement;
+
+    gen_int_compare_instructions(sections, tac_node);
 
     check_prepare_reg_slice(sections, X86_64_R10B);
     statement.tag = X86_64_INSTRUCTION;
@@ -1686,6 +2588,79 @@ static void gen_int_comparison_code(
     );
 }
 
+static void gen_int_comparison_branch_code(
+    struct sections *sections,
+    struct tac_node *tac_node
+)
+{
+    enum x86_64_opcode opcode;
+
+    gen_int_compare_instructions(sections, tac_node);
+
+    /* jumps whenever the comparison is false */
+    switch (tac_node->instruction.opcode) {
+        case TAC_EQ:
+            opcode = X86_64_JNZ;
+            break;
+
+        case TAC_NE:
+            opcode = X86_64_JZ;
+            break;
+
+        case TAC_LT:
+            opcode = X86_64_JGE;
+            break;
+
+        case TAC_LE:
+            opcode = X86_64_JG;
+            break;
+
+        case TAC_GT:
+            opcode = X86_64_JLE;
+            break;
+
+        case TAC_GE:
+            opcode = X86_64_JL;
+            break;
+
+        default:
+            panic("gen_int_comparison_branch_code should only be called with comparison operators");
+    }
+
+    gen_branch_instruction(sections, opcode, tac_node->next->instruction.dest);
+}
+
+static void gen_int_compare_instructions(
+    struct sections *sections,
+    struct tac_node *tac_node
+)
+{
+    struct x86_64_asm_stmt statement;
+
+    gen_read_instructions(
+        sections,
+        tac_node->instruction.srcs[0],
+        X86_64_MOV,
+        X86_64_RAX
+    );
+
+    gen_read_instructions(
+        sections,
+        tac_node->instruction.srcs[1],
+        X86_64_MOV,
+        X86_64_R10
+    );
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_CMP;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RAX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_R10;
+    x86_64_asm_unit_push(&sections->text, statement);
+}
+
 static void gen_move_code(
     struct sections *sections,
     struct tac_node *tac_node
@@ -1876,24 +2851,96 @@ static void gen_not_code(
     statement.data.instruction.operands[0].data.direct = X86_64_RAX;
     x86_64_asm_unit_push(&sections->text, statement);
 
-    statement.tag = X86_64_INSTRUCTION;
-    statement.data.instruction.opcode = X86_64_AND;
-    statement.data.instruction.operand_count = 2;
-    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
-    statement.data.instruction.operands[0].data.direct = X86_64_RAX;
-    statement.data.instruction.operands[1].tag = X86_64_OPERAND_IMMEDIATE;
-    statement.data.instruction.operands[1].data.immediate = 
-        symbol_table_create_int_lit(1);
-    x86_64_asm_unit_push(&sections->text, statement);
-
-    gen_write_instructions(
-        sections,
-        tac_node->instruction.dest,
-        X86_64_MOV,
-        X86_64_RAX
+    if (tac_node->instruction.opcode == TAC_NOT) {
+        statement.tag = X86_64_INSTRUCTION;
+        statement.data.instruction.opcode = X86_64_AND;
+        statement.data.instruction.operand_count = 2;
+        statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+        statement.data.instruction.operands[0].data.direct = X86_64_RAX;
+        statement.data.instruction.operands[1].tag = X86_64_OPERAND_IMMEDIATE;
+        statement.data.instruction.operands[1].data.immediate = 
+            symbol_table_create_int_lit(1);
+        x86_64_asm_unit_push(&sections->text, statement);
+    }
+
+    gen_write_instructions(
+        sections,
+        tac_node->instruction.dest,
+        X86_64_MOV,
+        X86_64_RAX
     );
 }
 
+static void gen_shift_code(
+    struct sections *sections,
+    struct tac_node *tac_node
+)
+{
+    struct x86_64_asm_stmt statement;
+    struct symbol *count;
+    enum x86_64_register_size reg_size;
+    int is_natu;
+
+    /* natu shifts are 32-bit even when the shifted value became a literal */
+    is_natu = tac_node->instruction.dest->data.variable.type == DATATYPE_NATU;
+    reg_size = is_natu
+        ? X86_64_DWORD
+        : x86_64_symbol_reg_size(tac_node->instruction.srcs[0]);
+    count = tac_node->instruction.srcs[1];
+
+    gen_read_instructions(
+        sections,
+        tac_node->instruction.srcs[0],
+        X86_64_MOV,
+        X86_64_RAX
+    );
+
+    statement.tag = X86_64_INSTRUCTION;
+    switch (tac_node->instruction.opcode) {
+        case TAC_SHL:
+            statement.data.instruction.opcode = X86_64_SHL;
+            break;
+        case TAC_SAR:
+            statement.data.instruction.opcode = is_natu
+                ? X86_64_SHR
+                : X86_64_SAR;
+            break;
+        case TAC_ROL:
+            statement.data.instruction.opcode = X86_64_ROL;
+            break;
+        default:
+            panic("gen_shift_code should only be called with SHL, SAR and ROL");
+    }
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct =
+        x86_64_make_register_of_size(reg_size, X86_64_RAX);
+
+    /* the count is masked the same way the processor masks it */
+    if (count->type == SYM_LIT_INT || count->type == SYM_LIT_CHAR) {
+        statement.data.instruction.operands[1].tag = X86_64_OPERAND_IMMEDIATE;
+        statement.data.instruction.operands[1].data.immediate =
+            symbol_table_create_int_lit(
+                (
+                    count->type == SYM_LIT_INT
+                    ? count->data.parsed_int
+                    : count->data.parsed_char
+                ) & (reg_size == X86_64_QWORD ? 63 : 31)
+            );
+    } else {
+        gen_read_instructions(sections, count, X86_64_MOV, X86_64_RCX);
+        statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+        statement.data.instruction.operands[1].data.direct = X86_64_CL;
+    }
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    gen_write_instructions(
+        sections,
+        tac_node->instruction.dest,
+        X86_64_MOV,
+        X86_64_RAX
+    );
+}
 
 static void gen_shmul_code(
     struct sections *sections,
@@ -1999,7 +3046,7 @@ static void gen_shdiv_code(
     statement.data.instruction.operands[1].data.displaced.base = X86_64_RAX;
     statement.data.instruction.operands[1].data.displaced.displacement =
         symbol_table_create_int_lit(
-            (1 << tac_node->instruction.srcs[1]->data.parsed_int) - 1
+            (1L << labs(tac_node->instruction.srcs[1]->data.parsed_int)) - 1
         );
     x86_64_asm_unit_push(&sections->text, statement);
 
@@ -2050,6 +3097,148 @@ static void gen_shdiv_code(
     );
 }
 
+/*
+ * The quotient is the high half of the dividend times the magic multiplier,
+ * shifted and rounded towards zero by adding the sign bit of the dividend.
+ */
+static void gen_mhdiv_code(
+    struct sections *sections,
+    struct tac_node *tac_node
+)
+{
+    struct x86_64_asm_stmt statement;
+    long divisor, multiplier;
+    int shift;
+
+    divisor = tac_node->instruction.srcs[1]->data.parsed_int;
+    division_magic(divisor, &multiplier, &shift);
+
+    gen_read_instructions(
+        sections,
+        tac_node->instruction.srcs[0],
+        X86_64_MOV,
+        X86_64_RAX
+    );
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_R9;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_RAX;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_IMUL;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0] = value_operand_from_sym(
+        sections,
+        symbol_table_create_int_lit(multiplier)
+    );
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    /* the multiplier was taken as negative when its top bit is set */
+    if (multiplier < 0) {
+        statement.tag = X86_64_INSTRUCTION;
+        statement.data.instruction.opcode = X86_64_ADD;
+        statement.data.instruction.operand_count = 2;
+        statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+        statement.data.instruction.operands[0].data.direct = X86_64_RDX;
+        statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+        statement.data.instruction.operands[1].data.direct = X86_64_R9;
+        x86_64_asm_unit_push(&sections->text, statement);
+    }
+
+    if (shift > 0) {
+        statement.tag = X86_64_INSTRUCTION;
+        statement.data.instruction.opcode = X86_64_SAR;
+        statement.data.instruction.operand_count = 2;
+        statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+        statement.data.instruction.operands[0].data.direct = X86_64_RDX;
+        statement.data.instruction.operands[1].tag = X86_64_OPERAND_IMMEDIATE;
+        statement.data.instruction.operands[1].data.immediate =
+            symbol_table_create_int_lit(shift);
+        x86_64_asm_unit_push(&sections->text, statement);
+    }
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_SHR;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_R9;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_IMMEDIATE;
+    statement.data.instruction.operands[1].data.immediate =
+        symbol_table_create_int_lit(63);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_ADD;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RDX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_R9;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    if (divisor < 0) {
+        statement.tag = X86_64_INSTRUCTION;
+        statement.data.instruction.opcode = X86_64_NEG;
+        statement.data.instruction.operand_count = 1;
+        statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+        statement.data.instruction.operands[0].data.direct = X86_64_RDX;
+        x86_64_asm_unit_push(&sections->text, statement);
+    }
+
+    gen_write_instructions(
+        sections,
+        tac_node->instruction.dest,
+        X86_64_MOV,
+        X86_64_RDX
+    );
+}
+
+/*
+ * Finds the smallest multiplier and shift dividing any 64-bit dividend by the
+ * magnitude of the divisor, as given in Hacker's Delight, section 10-4.
+ */
+static void division_magic(long divisor, long *multiplier, int *shift)
+{
+    unsigned long magnitude, two_63, anc, q1, r1, q2, r2, delta;
+    int p;
+
+    magnitude = divisor < 0
+        ? - (unsigned long) divisor
+        : (unsigned long) divisor;
+    two_63 = 1UL << 63;
+    anc = two_63 - 1 - two_63 % magnitude;
+    p = 63;
+    q1 = two_63 / anc;
+    r1 = two_63 - q1 * anc;
+    q2 = two_63 / magnitude;
+    r2 = two_63 - q2 * magnitude;
+
+    do {
+        p++;
+        q1 *= 2;
+        r1 *= 2;
+        if (r1 >= anc) {
+            q1++;
+            r1 -= anc;
+        }
+        q2 *= 2;
+        r2 *= 2;
+        if (r2 >= magnitude) {
+            q2++;
+            r2 -= magnitude;
+        }
+        delta = magnitude - r2;
+    } while (q1 < delta || (q1 == delta && r1 == 0));
+
+    *multiplier = (long) (q2 + 1);
+    *shift = p - 64;
+}
+
 static void gen_int_mul_code(
     struct sections *sections,
     struct tac_node *tac_node
@@ -2064,7 +3253,7 @@ static void gen_int_mul_code(
         X86_64_RAX
     );
 
-    operand = value_operand_from_sym(
+    operand = widened_operand_from_sym(
         sections,
         tac_node->instruction.srcs[1]
     );
@@ -2090,6 +3279,9 @@ static void gen_int_div_code(
 {
     struct x86_64_asm_stmt statement;
     struct x86_64_operand operand;
+    int is_natu;
+
+    is_natu = tac_node->instruction.dest->data.variable.type == DATATYPE_NATU;
 
     gen_read_instructions(
         sections,
@@ -2098,15 +3290,46 @@ static void gen_int_div_code(
         X86_64_RAX
     );
 
+    /* natu dividends are zero-extended instead of sign-extended */
     statement.tag = X86_64_INSTRUCTION;
-    statement.data.instruction.opcode = X86_64_CQO;
-    statement.data.instruction.operand_count = 0;
+    if (is_natu) {
+        statement.data.instruction.opcode = X86_64_MOV;
+        statement.data.instruction.operand_count = 2;
+        statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+        statement.data.instruction.operands[0].data.direct = X86_64_EDX;
+        statement.data.instruction.operands[1].tag = X86_64_OPERAND_IMMEDIATE;
+        statement.data.instruction.operands[1].data.immediate =
+            symbol_table_create_int_lit(0);
+    } else {
+        statement.data.instruction.opcode = X86_64_CQO;
+        statement.data.instruction.operand_count = 0;
+    }
     x86_64_asm_unit_push(&sections->text, statement);
 
-    operand = value_operand_from_sym(sections, tac_node->instruction.srcs[1]);
+    operand = widened_operand_from_sym(
+        sections,
+        tac_node->instruction.srcs[1]
+    );
+
+    /*
+     * natu divisors live in four bytes, so they are zero-extended into a
+     * register rather than read as a quadword from memory
+     */
+    if (is_natu && operand.tag != X86_64_OPERAND_DIRECT) {
+        statement.tag = X86_64_INSTRUCTION;
+        statement.data.instruction.opcode = X86_64_MOV;
+        statement.data.instruction.operand_count = 2;
+        statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+        statement.data.instruction.operands[0].data.direct = X86_64_R11D;
+        statement.data.instruction.operands[1] = operand;
+        x86_64_asm_unit_push(&sections->text, statement);
+
+        operand.tag = X86_64_OPERAND_DIRECT;
+        operand.data.direct = X86_64_R11;
+    }
 
     statement.tag = X86_64_INSTRUCTION;
-    statement.data.instruction.opcode = X86_64_IDIV;
+    statement.data.instruction.opcode = is_natu ? X86_64_DIV : X86_64_IDIV;
     statement.data.instruction.operand_count = 1;
     statement.data.instruction.operands[0] = operand;
     x86_64_asm_unit_push(&sections->text, statement);
@@ -2125,12 +3348,25 @@ static void gen_float_bin_code(
 )
 {
     enum x86_64_opcode opcode;
+    enum x86_64_register accumulator;
+    struct symbol *dest;
+
+    /* a register-allocated destination is computed in place */
+    dest = tac_node->instruction.dest;
+    accumulator = X86_64_XMM15;
+    if (
+        (dest->type == SYM_TMP_VAR || is_frame_param(dest))
+        && dest->data.variable.register_index != SIZE_MAX
+        && dest != tac_node->instruction.srcs[1]
+    ) {
+        accumulator = frame_operand_from_sym(dest).data.direct;
+    }
 
     gen_read_instructions(
         sections,
         tac_node->instruction.srcs[0],
         X86_64_MOVQ,
-        X86_64_XMM15
+        accumulator
     );
 
     switch (tac_node->instruction.opcode) {
@@ -2154,239 +3390,2367 @@ static void gen_float_bin_code(
         sections,
         tac_node->instruction.srcs[1],
         opcode,
-        X86_64_XMM15
-    );
-
-    gen_write_instructions(
-        sections,
-        tac_node->instruction.dest,
-        X86_64_MOVQ,
-        X86_64_XMM15
+        accumulator
     );
-}
 
-static struct call_state call_state_new(void)
-{
-    struct call_state call_state;
-    call_state.arg_count = 0;
-    call_state.sse_arg_count = 0;
-    call_state.arg_index = 0;
-    call_state.sse_arg_index = 0;
-    call_state.stack_arg_count = 0;
-    call_state.call_stack_offset = 0;
-    call_state.call_stack_size = symbol_table_create_int_lit(0);
-    return call_state;
+    if (accumulator == X86_64_XMM15) {
+        gen_write_instructions(sections, dest, X86_64_MOVQ, X86_64_XMM15);
+    }
 }
 
-static void gen_leave_boilerplate(struct sections *sections)
+static void gen_pload_code(
+    struct sections *sections,
+    struct tac_node *tac_node
+)
 {
     struct x86_64_asm_stmt statement;
+    int data_size;
 
-    statement.tag = X86_64_INSTRUCTION;
-    statement.data.instruction.opcode = X86_64_MOV;
-    statement.data.instruction.operands[0].tag =
-        X86_64_OPERAND_DIRECT;
-    statement.data.instruction.operands[0].data.direct = X86_64_RSP;
-    statement.data.instruction.operands[1].tag =
-        X86_64_OPERAND_DIRECT;
-    statement.data.instruction.operands[1].data.direct = X86_64_RBP;
-    statement.data.instruction.operand_count = 2;
-    x86_64_asm_unit_push(&sections->text, statement);
+    data_size = x86_64_symbol_data_size(tac_node->instruction.srcs[0]);
 
-    statement.tag = X86_64_INSTRUCTION;
-    statement.data.instruction.opcode = X86_64_POP;
-    statement.data.instruction.operands[0].tag =
-        X86_64_OPERAND_DIRECT;
-    statement.data.instruction.operands[0].data.direct = X86_64_RBP;
-    statement.data.instruction.operand_count = 1;
-    x86_64_asm_unit_push(&sections->text, statement);
+    gen_read_instructions(
+        sections,
+        tac_node->instruction.srcs[0],
+        X86_64_LEA,
+        X86_64_RAX
+    );
+
+    gen_read_instructions(
+        sections,
+        tac_node->instruction.srcs[1],
+        X86_64_MOV,
+        X86_64_R9
+    );
 
+    /* vectors are only aligned to their elements */
     statement.tag = X86_64_INSTRUCTION;
-    statement.data.instruction.opcode = X86_64_RET;
-    statement.data.instruction.operand_count = 0;
+    statement.data.instruction.opcode = X86_64_MOVDQU;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct =
+        packed_register(tac_node->instruction.dest);
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_INDEXED;
+    statement.data.instruction.operands[1].data.indexed.base = X86_64_RAX;
+    statement.data.instruction.operands[1].data.indexed.index = X86_64_R9;
+    statement.data.instruction.operands[1].data.indexed.scale = data_size;
+    statement.data.instruction.operands[1].data.indexed.displacement =
+       symbol_table_create_int_lit(0);
     x86_64_asm_unit_push(&sections->text, statement);
 }
 
-int datatype_align(enum datatype datatype)
-{
-    switch (datatype) {
-        case DATATYPE_INTE:
-        case DATATYPE_REAL:
-            return 8;
-        case DATATYPE_CARA:
-            return 1;
-        default:
-            panic("datatype %i has no implemented align");
-    }
-}
-
-static void check_prepare_reg_slice(
+static void gen_pstore_code(
     struct sections *sections,
-    enum x86_64_register reg
+    struct tac_node *tac_node
 )
 {
     struct x86_64_asm_stmt statement;
+    int data_size;
 
-    switch (x86_64_register_size(reg)) {
-        case X86_64_BYTE:
-        case X86_64_WORD:
-            statement.tag = X86_64_INSTRUCTION;
-            statement.data.instruction.opcode = X86_64_MOV;
-            statement.data.instruction.operand_count = 2;
-            statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
-            statement.data.instruction.operands[0].data.direct =
-                x86_64_make_register_of_size(X86_64_QWORD, reg);
+    data_size = x86_64_symbol_data_size(tac_node->instruction.dest);
+
+    gen_read_instructions(
+        sections,
+        tac_node->instruction.srcs[0],
+        X86_64_MOV,
+        X86_64_R9
+    );
+
+    gen_read_instructions(
+        sections,
+        tac_node->instruction.dest,
+        X86_64_LEA,
+        X86_64_R8
+    );
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOVDQU;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_INDEXED;
+    statement.data.instruction.operands[0].data.indexed.base = X86_64_R8;
+    statement.data.instruction.operands[0].data.indexed.index = X86_64_R9;
+    statement.data.instruction.operands[0].data.indexed.scale = data_size;
+    statement.data.instruction.operands[0].data.indexed.displacement =
+       symbol_table_create_int_lit(0);
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct =
+        packed_register(tac_node->instruction.srcs[1]);
+    x86_64_asm_unit_push(&sections->text, statement);
+}
+
+/*
+ * Integer elements are repeated through a 64-bit register first, which is
+ * then copied to both halves of the packed register.
+ */
+static void gen_psplat_code(
+    struct sections *sections,
+    struct tac_node *tac_node
+)
+{
+    struct x86_64_asm_stmt statement;
+    enum x86_64_register reg;
+
+    reg = packed_register(tac_node->instruction.dest);
+
+    if (tac_node->instruction.dest->data.variable.type == DATATYPE_REAL) {
+        gen_read_instructions(
+            sections,
+            tac_node->instruction.srcs[0],
+            X86_64_MOVQ,
+            reg
+        );
+        gen_packed_instruction(sections, X86_64_PUNPCKLQDQ, reg, reg);
+        return;
+    }
+
+    gen_read_instructions(
+        sections,
+        tac_node->instruction.srcs[0],
+        X86_64_MOV,
+        X86_64_RAX
+    );
+
+    switch (tac_node->instruction.dest->data.variable.type) {
+        case DATATYPE_CARA:
+            statement.tag = X86_64_INSTRUCTION;
+            statement.data.instruction.opcode = X86_64_AND;
+            statement.data.instruction.operand_count = 2;
+            statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+            statement.data.instruction.operands[0].data.direct = X86_64_RAX;
             statement.data.instruction.operands[1].tag =
                 X86_64_OPERAND_IMMEDIATE;
             statement.data.instruction.operands[1].data.immediate =
-                symbol_table_create_int_lit(0);
+                symbol_table_create_int_lit(0xff);
+            x86_64_asm_unit_push(&sections->text, statement);
+
+            statement.tag = X86_64_INSTRUCTION;
+            statement.data.instruction.opcode = X86_64_MOVABS;
+            statement.data.instruction.operand_count = 2;
+            statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+            statement.data.instruction.operands[0].data.direct = X86_64_R10;
+            statement.data.instruction.operands[1].tag =
+                X86_64_OPERAND_IMMEDIATE;
+            statement.data.instruction.operands[1].data.immediate =
+                symbol_table_create_int_lit(0x0101010101010101L);
+            x86_64_asm_unit_push(&sections->text, statement);
+
+            statement.tag = X86_64_INSTRUCTION;
+            statement.data.instruction.opcode = X86_64_IMUL;
+            statement.data.instruction.operand_count = 1;
+            statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+            statement.data.instruction.operands[0].data.direct = X86_64_R10;
+            x86_64_asm_unit_push(&sections->text, statement);
+            break;
+
+        case DATATYPE_NATU:
+            /* writing the lower half clears the upper one */
+            statement.tag = X86_64_INSTRUCTION;
+            statement.data.instruction.opcode = X86_64_MOV;
+            statement.data.instruction.operand_count = 2;
+            statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+            statement.data.instruction.operands[0].data.direct = X86_64_EAX;
+            statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+            statement.data.instruction.operands[1].data.direct = X86_64_EAX;
+            x86_64_asm_unit_push(&sections->text, statement);
+
+            statement.tag = X86_64_INSTRUCTION;
+            statement.data.instruction.opcode = X86_64_MOV;
+            statement.data.instruction.operand_count = 2;
+            statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+            statement.data.instruction.operands[0].data.direct = X86_64_R10;
+            statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+            statement.data.instruction.operands[1].data.direct = X86_64_RAX;
+            x86_64_asm_unit_push(&sections->text, statement);
+
+            statement.tag = X86_64_INSTRUCTION;
+            statement.data.instruction.opcode = X86_64_SHL;
+            statement.data.instruction.operand_count = 2;
+            statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+            statement.data.instruction.operands[0].data.direct = X86_64_R10;
+            statement.data.instruction.operands[1].tag =
+                X86_64_OPERAND_IMMEDIATE;
+            statement.data.instruction.operands[1].data.immediate =
+                symbol_table_create_int_lit(32);
+            x86_64_asm_unit_push(&sections->text, statement);
+
+            statement.tag = X86_64_INSTRUCTION;
+            statement.data.instruction.opcode = X86_64_OR;
+            statement.data.instruction.operand_count = 2;
+            statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+            statement.data.instruction.operands[0].data.direct = X86_64_RAX;
+            statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+            statement.data.instruction.operands[1].data.direct = X86_64_R10;
             x86_64_asm_unit_push(&sections->text, statement);
             break;
+
         default:
             break;
     }
+
+    gen_packed_instruction(sections, X86_64_MOVQ, reg, X86_64_RAX);
+    gen_packed_instruction(sections, X86_64_PUNPCKLQDQ, reg, reg);
 }
 
-static void gen_enter_boilerplate(struct sections *sections)
+static void gen_packed_bin_code(
+    struct sections *sections,
+    struct tac_node *tac_node
+)
+{
+    enum x86_64_opcode opcode;
+    enum datatype datatype;
+    enum x86_64_register dest, left, right;
+
+    datatype = tac_node->instruction.dest->data.variable.type;
+
+    switch (tac_node->instruction.opcode) {
+        case TAC_PADD:
+            switch (datatype) {
+                case DATATYPE_REAL:
+                    opcode = X86_64_ADDPD;
+                    break;
+                case DATATYPE_CARA:
+                    opcode = X86_64_PADDB;
+                    break;
+                case DATATYPE_NATU:
+                    opcode = X86_64_PADDD;
+                    break;
+                default:
+                    opcode = X86_64_PADDQ;
+                    break;
+            }
+            break;
+        case TAC_PSUB:
+            switch (datatype) {
+                case DATATYPE_REAL:
+                    opcode = X86_64_SUBPD;
+                    break;
+                case DATATYPE_CARA:
+                    opcode = X86_64_PSUBB;
+                    break;
+                case DATATYPE_NATU:
+                    opcode = X86_64_PSUBD;
+                    break;
+                default:
+                    opcode = X86_64_PSUBQ;
+                    break;
+            }
+            break;
+        case TAC_PMUL:
+            opcode = X86_64_MULPD;
+            break;
+        case TAC_PDIV:
+            opcode = X86_64_DIVPD;
+            break;
+        case TAC_PAND:
+            opcode = X86_64_PAND;
+            break;
+        case TAC_POR:
+            opcode = X86_64_POR;
+            break;
+        case TAC_PXOR:
+            opcode = X86_64_PXOR;
+            break;
+        default:
+            panic("gen_packed_bin_code should only be called with packed arithmetic operators");
+    }
+
+    dest = packed_register(tac_node->instruction.dest);
+    left = packed_register(tac_node->instruction.srcs[0]);
+    right = packed_register(tac_node->instruction.srcs[1]);
+
+    if (dest == right && dest != left) {
+        gen_packed_instruction(sections, X86_64_MOVDQA, X86_64_XMM15, left);
+        gen_packed_instruction(sections, opcode, X86_64_XMM15, right);
+        gen_packed_instruction(sections, X86_64_MOVDQA, dest, X86_64_XMM15);
+    } else {
+        if (dest != left) {
+            gen_packed_instruction(sections, X86_64_MOVDQA, dest, left);
+        }
+        gen_packed_instruction(sections, opcode, dest, right);
+    }
+}
+
+static void gen_psum_code(
+    struct sections *sections,
+    struct tac_node *tac_node
+)
+{
+    enum x86_64_register src;
+
+    src = packed_register(tac_node->instruction.srcs[0]);
+
+    gen_packed_instruction(sections, X86_64_MOVDQA, X86_64_XMM15, src);
+    gen_packed_instruction(
+        sections,
+        X86_64_PUNPCKHQDQ,
+        X86_64_XMM15,
+        X86_64_XMM15
+    );
+    gen_packed_instruction(sections, X86_64_PADDQ, X86_64_XMM15, src);
+    gen_packed_instruction(sections, X86_64_MOVQ, X86_64_RAX, X86_64_XMM15);
+
+    gen_write_instructions(
+        sections,
+        tac_node->instruction.dest,
+        X86_64_MOV,
+        X86_64_RAX
+    );
+}
+
+static void gen_packed_instruction(
+    struct sections *sections,
+    enum x86_64_opcode opcode,
+    enum x86_64_register dest,
+    enum x86_64_register src
+)
 {
     struct x86_64_asm_stmt statement;
 
     statement.tag = X86_64_INSTRUCTION;
-    statement.data.instruction.opcode = X86_64_PUSH;
-    statement.data.instruction.operands[0].tag =
-        X86_64_OPERAND_DIRECT;
-    statement.data.instruction.operands[0].data.direct = X86_64_RBP;
-    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.opcode = opcode;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = dest;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = src;
+    x86_64_asm_unit_push(&sections->text, statement);
+}
+
+/* packed variables take xmm2 to xmm7, never live across calls */
+static enum x86_64_register packed_register(struct symbol *symbol)
+{
+    if (symbol->data.variable.register_index >= TAC_PACKED_COUNT) {
+        panic(
+            "packed variable %s has no register",
+            symbol->content
+        );
+    }
+    return X86_64_XMM2 + symbol->data.variable.register_index;
+}
+
+/* the fill or copy that follows finds the element count in rcx */
+static void gen_rep_code(
+    struct sections *sections,
+    struct tac_node *tac_node
+)
+{
+    gen_read_instructions(
+        sections,
+        tac_node->instruction.srcs[0],
+        X86_64_MOV,
+        X86_64_RCX
+    );
+}
+
+static void gen_fill_code(
+    struct sections *sections,
+    struct tac_node *tac_node
+)
+{
+    struct x86_64_asm_stmt statement;
+
+    gen_read_instructions(
+        sections,
+        tac_node->instruction.srcs[0],
+        X86_64_MOV,
+        X86_64_R9
+    );
+
+    gen_element_address(sections, tac_node->instruction.dest, X86_64_RDI);
+
+    if (tac_node->instruction.dest->data.variable.type == DATATYPE_REAL) {
+        gen_read_instructions(
+            sections,
+            tac_node->instruction.srcs[1],
+            X86_64_MOVSD,
+            X86_64_XMM15
+        );
+        gen_packed_instruction(
+            sections,
+            X86_64_MOVQ,
+            X86_64_RAX,
+            X86_64_XMM15
+        );
+    } else {
+        gen_read_instructions(
+            sections,
+            tac_node->instruction.srcs[1],
+            X86_64_MOV,
+            X86_64_RAX
+        );
+    }
+
+    statement.tag = X86_64_INSTRUCTION;
+    switch (x86_64_symbol_data_size(tac_node->instruction.dest)) {
+        case 1:
+            statement.data.instruction.opcode = X86_64_REP_STOSB;
+            break;
+        case 4:
+            statement.data.instruction.opcode = X86_64_REP_STOSL;
+            break;
+        default:
+            statement.data.instruction.opcode = X86_64_REP_STOSQ;
+            break;
+    }
+    statement.data.instruction.operand_count = 0;
+    x86_64_asm_unit_push(&sections->text, statement);
+}
+
+/* fast string copies make moving bytes as quick as moving wider elements */
+static void gen_copy_code(
+    struct sections *sections,
+    struct tac_node *tac_node
+)
+{
+    int data_size;
+    struct x86_64_asm_stmt statement;
+
+    data_size = x86_64_symbol_data_size(tac_node->instruction.dest);
+
+    gen_read_instructions(
+        sections,
+        tac_node->instruction.srcs[1],
+        X86_64_MOV,
+        X86_64_R9
+    );
+
+    gen_element_address(sections, tac_node->instruction.srcs[0], X86_64_RSI);
+    gen_element_address(sections, tac_node->instruction.dest, X86_64_RDI);
+
+    if (data_size > 1) {
+        statement.tag = X86_64_INSTRUCTION;
+        statement.data.instruction.opcode = X86_64_SHL;
+        statement.data.instruction.operand_count = 2;
+        statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+        statement.data.instruction.operands[0].data.direct = X86_64_RCX;
+        statement.data.instruction.operands[1].tag = X86_64_OPERAND_IMMEDIATE;
+        statement.data.instruction.operands[1].data.immediate =
+            symbol_table_create_int_lit(data_size == 4 ? 2 : 3);
+        x86_64_asm_unit_push(&sections->text, statement);
+    }
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_REP_MOVSB;
+    statement.data.instruction.operand_count = 0;
+    x86_64_asm_unit_push(&sections->text, statement);
+}
+
+/* expects the index of the element in r9 */
+static void gen_element_address(
+    struct sections *sections,
+    struct symbol *vector,
+    enum x86_64_register reg
+)
+{
+    struct x86_64_asm_stmt statement;
+
+    gen_read_instructions(sections, vector, X86_64_LEA, reg);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_LEA;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = reg;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_INDEXED;
+    statement.data.instruction.operands[1].data.indexed.base = reg;
+    statement.data.instruction.operands[1].data.indexed.index = X86_64_R9;
+    statement.data.instruction.operands[1].data.indexed.scale =
+        x86_64_symbol_data_size(vector);
+    statement.data.instruction.operands[1].data.indexed.displacement =
+       symbol_table_create_int_lit(0);
+    x86_64_asm_unit_push(&sections->text, statement);
+}
+
+static struct call_state call_state_new(void)
+{
+    struct call_state call_state;
+    call_state.arg_count = 0;
+    call_state.sse_arg_count = 0;
+    call_state.arg_index = 0;
+    call_state.sse_arg_index = 0;
+    call_state.stack_arg_count = 0;
+    call_state.call_stack_offset = 0;
+    call_state.call_stack_size = symbol_table_create_int_lit(0);
+    return call_state;
+}
+
+static void gen_leave_boilerplate(struct sections *sections)
+{
+    struct x86_64_asm_stmt statement;
+
+    gen_unwind_boilerplate(sections);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_RET;
+    statement.data.instruction.operand_count = 0;
+    x86_64_asm_unit_push(&sections->text, statement);
+}
+
+static void gen_unwind_boilerplate(struct sections *sections)
+{
+    struct x86_64_asm_stmt statement;
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operands[0].tag =
+        X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RSP;
+    statement.data.instruction.operands[1].tag =
+        X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_RBP;
+    statement.data.instruction.operand_count = 2;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_POP;
+    statement.data.instruction.operands[0].tag =
+        X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RBP;
+    statement.data.instruction.operand_count = 1;
+    x86_64_asm_unit_push(&sections->text, statement);
+}
+
+int datatype_align(enum datatype datatype)
+{
+    switch (datatype) {
+        case DATATYPE_INTE:
+        case DATATYPE_REAL:
+            return 8;
+        case DATATYPE_NATU:
+            return 4;
+        case DATATYPE_CARA:
+            return 1;
+        default:
+            panic("datatype %i has no implemented align");
+    }
+}
+
+static void check_prepare_reg_slice(
+    struct sections *sections,
+    enum x86_64_register reg
+)
+{
+    struct x86_64_asm_stmt statement;
+
+    switch (x86_64_register_size(reg)) {
+        case X86_64_BYTE:
+        case X86_64_WORD:
+            statement.tag = X86_64_INSTRUCTION;
+            statement.data.instruction.opcode = X86_64_MOV;
+            statement.data.instruction.operand_count = 2;
+            statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+            statement.data.instruction.operands[0].data.direct =
+                x86_64_make_register_of_size(X86_64_QWORD, reg);
+            statement.data.instruction.operands[1].tag =
+                X86_64_OPERAND_IMMEDIATE;
+            statement.data.instruction.operands[1].data.immediate =
+                symbol_table_create_int_lit(0);
+            x86_64_asm_unit_push(&sections->text, statement);
+            break;
+        default:
+            break;
+    }
+}
+
+static void gen_enter_boilerplate(struct sections *sections)
+{
+    struct x86_64_asm_stmt statement;
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_PUSH;
+    statement.data.instruction.operands[0].tag =
+        X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RBP;
+    statement.data.instruction.operand_count = 1;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operands[0].tag =
+        X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RBP;
+    statement.data.instruction.operands[1].tag =
+        X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_RSP;
+    statement.data.instruction.operand_count = 2;
+    x86_64_asm_unit_push(&sections->text, statement);
+}
+
+static void gen_read_function(struct sections *sections)
+{
+    struct x86_64_asm_stmt statement;
+    struct symbol *name;
+    struct symbol *skip;
+    struct symbol *skip_have;
+    struct symbol *negative;
+    struct symbol *sign;
+    struct symbol *sign_have;
+    struct symbol *lone_sign;
+    struct symbol *digits;
+    struct symbol *digits_have;
+    struct symbol *unget;
+    struct symbol *done;
+    struct symbol *saturate;
+    struct symbol *in_range;
+
+    skip = symbol_table_create_tmp_label();
+    skip_have = symbol_table_create_tmp_label();
+    negative = symbol_table_create_tmp_label();
+    sign = symbol_table_create_tmp_label();
+    sign_have = symbol_table_create_tmp_label();
+    lone_sign = symbol_table_create_tmp_label();
+    digits = symbol_table_create_tmp_label();
+    digits_have = symbol_table_create_tmp_label();
+    unget = symbol_table_create_tmp_label();
+    done = symbol_table_create_tmp_label();
+    saturate = symbol_table_create_tmp_label();
+    in_range = symbol_table_create_tmp_label();
+
+    name = symbol_table_insert("@entrada");
+    name->type = SYM_LABEL;
+
+    statement.tag = X86_64_LABEL;
+    statement.data.label = name;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    gen_enter_boilerplate(sections);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_SUB;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RSP;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_IMMEDIATE;
+    statement.data.instruction.operands[1].data.immediate =
+        symbol_table_create_int_lit(32);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DISPLACED;
+    statement.data.instruction.operands[0].data.displaced.base = X86_64_RBP;
+    statement.data.instruction.operands[0].data.displaced.displacement =
+        symbol_table_create_int_lit(-8);
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_RBX;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DISPLACED;
+    statement.data.instruction.operands[0].data.displaced.base = X86_64_RBP;
+    statement.data.instruction.operands[0].data.displaced.displacement =
+        symbol_table_create_int_lit(-16);
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_R12;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DISPLACED;
+    statement.data.instruction.operands[0].data.displaced.base = X86_64_RBP;
+    statement.data.instruction.operands[0].data.displaced.displacement =
+        symbol_table_create_int_lit(-24);
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_R13;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DISPLACED;
+    statement.data.instruction.operands[0].data.displaced.base = X86_64_RBP;
+    statement.data.instruction.operands[0].data.displaced.displacement =
+        symbol_table_create_int_lit(-32);
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_R14;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    /* prompts written so far must show up before the program blocks */
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_CALL;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
+    statement.data.instruction.operands[0].data.address =
+        symbol_table_insert("@flush");
+    statement.data.instruction.operands[0].data.address->type =
+        SYM_LABEL;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RBX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DISPLACED;
+    statement.data.instruction.operands[1].data.displaced.base = X86_64_RIP;
+    statement.data.instruction.operands[1].data.displaced.displacement =
+        runtime_var_sym("@inpos", DATATYPE_INTE);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_R12;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DISPLACED;
+    statement.data.instruction.operands[1].data.displaced.base = X86_64_RIP;
+    statement.data.instruction.operands[1].data.displaced.displacement =
+        runtime_var_sym("@inend", DATATYPE_INTE);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_XOR;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_R13;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_R13;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_XOR;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_R14;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_R14;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_LABEL;
+    statement.data.label = skip;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    /* anything before a sign or a digit is skipped */
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_CMP;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RBX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_R12;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_JL;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
+    statement.data.instruction.operands[0].data.address = skip_have;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_CALL;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
+    statement.data.instruction.operands[0].data.address =
+        symbol_table_insert("@fill_input");
+    statement.data.instruction.operands[0].data.address->type =
+        SYM_LABEL;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_XOR;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RBX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_RBX;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_R12;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_RAX;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_TEST;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_R12;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_R12;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_JZ;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
+    statement.data.instruction.operands[0].data.address = done;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_LABEL;
+    statement.data.label = skip_have;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_LEA;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RCX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DISPLACED;
+    statement.data.instruction.operands[1].data.displaced.base = X86_64_RIP;
+    statement.data.instruction.operands[1].data.displaced.displacement =
+        runtime_var_sym("@inbuf", DATATYPE_CARA);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_XOR;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RAX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_RAX;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_AL;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_INDEXED;
+    statement.data.instruction.operands[1].data.indexed.base = X86_64_RCX;
+    statement.data.instruction.operands[1].data.indexed.index = X86_64_RBX;
+    statement.data.instruction.operands[1].data.indexed.scale = 1;
+    statement.data.instruction.operands[1].data.indexed.displacement =
+       symbol_table_create_int_lit(0);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_INC;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RBX;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_CMP;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RAX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_IMMEDIATE;
+    statement.data.instruction.operands[1].data.immediate =
+        symbol_table_create_int_lit('+');
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_JZ;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
+    statement.data.instruction.operands[0].data.address = sign;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_CMP;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RAX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_IMMEDIATE;
+    statement.data.instruction.operands[1].data.immediate =
+        symbol_table_create_int_lit('-');
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_JZ;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
+    statement.data.instruction.operands[0].data.address = negative;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_CMP;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RAX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_IMMEDIATE;
+    statement.data.instruction.operands[1].data.immediate =
+        symbol_table_create_int_lit('0');
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_JL;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
+    statement.data.instruction.operands[0].data.address = skip;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_CMP;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RAX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_IMMEDIATE;
+    statement.data.instruction.operands[1].data.immediate =
+        symbol_table_create_int_lit('9');
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_JG;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
+    statement.data.instruction.operands[0].data.address = skip;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_DEC;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RBX;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_JMP;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
+    statement.data.instruction.operands[0].data.address = digits;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_LABEL;
+    statement.data.label = negative;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_R14;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_IMMEDIATE;
+    statement.data.instruction.operands[1].data.immediate =
+        symbol_table_create_int_lit(1);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_LABEL;
+    statement.data.label = sign;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    /* a sign not followed by a digit is dropped */
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_CMP;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RBX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_R12;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_JL;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
+    statement.data.instruction.operands[0].data.address = sign_have;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_CALL;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
+    statement.data.instruction.operands[0].data.address =
+        symbol_table_insert("@fill_input");
+    statement.data.instruction.operands[0].data.address->type =
+        SYM_LABEL;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_XOR;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RBX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_RBX;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_R12;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_RAX;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_TEST;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_R12;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_R12;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_JZ;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
+    statement.data.instruction.operands[0].data.address = done;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_LABEL;
+    statement.data.label = sign_have;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_LEA;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RCX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DISPLACED;
+    statement.data.instruction.operands[1].data.displaced.base = X86_64_RIP;
+    statement.data.instruction.operands[1].data.displaced.displacement =
+        runtime_var_sym("@inbuf", DATATYPE_CARA);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_XOR;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RAX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_RAX;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_AL;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_INDEXED;
+    statement.data.instruction.operands[1].data.indexed.base = X86_64_RCX;
+    statement.data.instruction.operands[1].data.indexed.index = X86_64_RBX;
+    statement.data.instruction.operands[1].data.indexed.scale = 1;
+    statement.data.instruction.operands[1].data.indexed.displacement =
+       symbol_table_create_int_lit(0);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_INC;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RBX;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_DEC;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RBX;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_CMP;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RAX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_IMMEDIATE;
+    statement.data.instruction.operands[1].data.immediate =
+        symbol_table_create_int_lit('0');
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_JL;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
+    statement.data.instruction.operands[0].data.address = lone_sign;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_CMP;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RAX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_IMMEDIATE;
+    statement.data.instruction.operands[1].data.immediate =
+        symbol_table_create_int_lit('9');
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_JLE;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
+    statement.data.instruction.operands[0].data.address = digits;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_LABEL;
+    statement.data.label = lone_sign;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_XOR;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_R14;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_R14;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_JMP;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
+    statement.data.instruction.operands[0].data.address = skip;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_LABEL;
+    statement.data.label = digits;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_CMP;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RBX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_R12;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_JL;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
+    statement.data.instruction.operands[0].data.address = digits_have;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_CALL;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
+    statement.data.instruction.operands[0].data.address =
+        symbol_table_insert("@fill_input");
+    statement.data.instruction.operands[0].data.address->type =
+        SYM_LABEL;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_XOR;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RBX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_RBX;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_R12;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_RAX;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_TEST;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_R12;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_R12;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_JZ;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
+    statement.data.instruction.operands[0].data.address = done;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_LABEL;
+    statement.data.label = digits_have;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_LEA;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RCX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DISPLACED;
+    statement.data.instruction.operands[1].data.displaced.base = X86_64_RIP;
+    statement.data.instruction.operands[1].data.displaced.displacement =
+        runtime_var_sym("@inbuf", DATATYPE_CARA);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_XOR;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RAX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_RAX;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_AL;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_INDEXED;
+    statement.data.instruction.operands[1].data.indexed.base = X86_64_RCX;
+    statement.data.instruction.operands[1].data.indexed.index = X86_64_RBX;
+    statement.data.instruction.operands[1].data.indexed.scale = 1;
+    statement.data.instruction.operands[1].data.indexed.displacement =
+       symbol_table_create_int_lit(0);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_INC;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RBX;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_SUB;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RAX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_IMMEDIATE;
+    statement.data.instruction.operands[1].data.immediate =
+        symbol_table_create_int_lit('0');
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_CMP;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RAX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_IMMEDIATE;
+    statement.data.instruction.operands[1].data.immediate =
+        symbol_table_create_int_lit(10);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_JNC;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
+    statement.data.instruction.operands[0].data.address = unget;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    /*
+     * The magnitude is accumulated negated, so LONG_MIN is reachable, and
+     * saturates there on overflow, as scanf did.
+     */
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOVABS;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RDX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_IMMEDIATE;
+    statement.data.instruction.operands[1].data.immediate =
+        symbol_table_create_int_lit(LONG_MIN / 10);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_CMP;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_R13;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_RDX;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_JL;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
+    statement.data.instruction.operands[0].data.address = saturate;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_LEA;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_R13;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_INDEXED;
+    statement.data.instruction.operands[1].data.indexed.base = X86_64_R13;
+    statement.data.instruction.operands[1].data.indexed.index = X86_64_R13;
+    statement.data.instruction.operands[1].data.indexed.scale = 4;
+    statement.data.instruction.operands[1].data.indexed.displacement =
+       symbol_table_create_int_lit(0);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_ADD;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_R13;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_R13;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_SUB;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_R13;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_RAX;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    /* only the last digit can wrap it around to a positive value */
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_TEST;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_R13;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_R13;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_JLE;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
+    statement.data.instruction.operands[0].data.address = digits;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_LABEL;
+    statement.data.label = saturate;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOVABS;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_R13;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_IMMEDIATE;
+    statement.data.instruction.operands[1].data.immediate =
+        symbol_table_create_int_lit(LONG_MIN);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_JMP;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
+    statement.data.instruction.operands[0].data.address = digits;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_LABEL;
+    statement.data.label = unget;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_DEC;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RBX;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_LABEL;
+    statement.data.label = done;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DISPLACED;
+    statement.data.instruction.operands[0].data.displaced.base = X86_64_RIP;
+    statement.data.instruction.operands[0].data.displaced.displacement =
+        runtime_var_sym("@inpos", DATATYPE_INTE);
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_RBX;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DISPLACED;
+    statement.data.instruction.operands[0].data.displaced.base = X86_64_RIP;
+    statement.data.instruction.operands[0].data.displaced.displacement =
+        runtime_var_sym("@inend", DATATYPE_INTE);
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_R12;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RAX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_R13;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_TEST;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_R14;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_R14;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_JNZ;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
+    statement.data.instruction.operands[0].data.address = in_range;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_NEG;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RAX;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    /* LONG_MIN has no positive counterpart, LONG_MAX is the closest */
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_TEST;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RAX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_RAX;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_JGE;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
+    statement.data.instruction.operands[0].data.address = in_range;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_DEC;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RAX;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_LABEL;
+    statement.data.label = in_range;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RBX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DISPLACED;
+    statement.data.instruction.operands[1].data.displaced.base = X86_64_RBP;
+    statement.data.instruction.operands[1].data.displaced.displacement =
+        symbol_table_create_int_lit(-8);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_R12;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DISPLACED;
+    statement.data.instruction.operands[1].data.displaced.base = X86_64_RBP;
+    statement.data.instruction.operands[1].data.displaced.displacement =
+        symbol_table_create_int_lit(-16);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_R13;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DISPLACED;
+    statement.data.instruction.operands[1].data.displaced.base = X86_64_RBP;
+    statement.data.instruction.operands[1].data.displaced.displacement =
+        symbol_table_create_int_lit(-24);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_R14;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DISPLACED;
+    statement.data.instruction.operands[1].data.displaced.base = X86_64_RBP;
+    statement.data.instruction.operands[1].data.displaced.displacement =
+        symbol_table_create_int_lit(-32);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    gen_leave_boilerplate(sections);
+}
+
+static void gen_fill_input_function(struct sections *sections)
+{
+    struct x86_64_asm_stmt statement;
+    struct symbol *name;
+    struct symbol *done;
+
+    done = symbol_table_create_tmp_label();
+
+    name = symbol_table_insert("@fill_input");
+    name->type = SYM_LABEL;
+
+    statement.tag = X86_64_LABEL;
+    statement.data.label = name;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    gen_enter_boilerplate(sections);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_XOR;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RDI;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_RDI;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_LEA;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RSI;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DISPLACED;
+    statement.data.instruction.operands[1].data.displaced.base = X86_64_RIP;
+    statement.data.instruction.operands[1].data.displaced.displacement =
+        runtime_var_sym("@inbuf", DATATYPE_CARA);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RDX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_IMMEDIATE;
+    statement.data.instruction.operands[1].data.immediate =
+        symbol_table_create_int_lit(INPUT_BUFFER_SIZE);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_CALL;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_PLT;
+    statement.data.instruction.operands[0].data.address =
+        symbol_table_insert("read");
+    statement.data.instruction.operands[0].data.address->type =
+        SYM_EXTERNAL;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    /* errors end the input just like the end of the file */
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_CMP;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RAX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_IMMEDIATE;
+    statement.data.instruction.operands[1].data.immediate =
+        symbol_table_create_int_lit(0);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_JGE;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
+    statement.data.instruction.operands[0].data.address = done;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_XOR;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RAX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_RAX;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_LABEL;
+    statement.data.label = done;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    gen_leave_boilerplate(sections);
+}
+
+static void gen_input_buffer(struct sections *sections)
+{
+    gen_runtime_var(sections, runtime_var_sym("@inpos", DATATYPE_INTE));
+    gen_runtime_var(sections, runtime_var_sym("@inend", DATATYPE_INTE));
+    gen_runtime_buffer(
+        sections,
+        runtime_var_sym("@inbuf", DATATYPE_CARA),
+        INPUT_BUFFER_SIZE
+    );
+}
+
+static void gen_output_buffer(struct sections *sections)
+{
+    struct x86_64_asm_stmt statement;
+
+    gen_runtime_var(sections, runtime_var_sym("@outpos", DATATYPE_INTE));
+    gen_runtime_buffer(
+        sections,
+        runtime_var_sym("@outbuf", DATATYPE_CARA),
+        OUTPUT_BUFFER_SIZE
+    );
+
+    /* whatever is still buffered is flushed when the program exits */
+    statement.tag = X86_64_DIRECTIVE;
+    statement.data.directive.name = X86_64_FINI_ARRAY;
+    statement.data.directive.operand_count = 0;
+    x86_64_asm_unit_push(&sections->data, statement);
+
+    statement.tag = X86_64_DIRECTIVE;
+    statement.data.directive.name = X86_64_ALIGN;
+    statement.data.directive.operands[0] = symbol_table_create_int_lit(8);
+    statement.data.directive.operand_count = 1;
+    x86_64_asm_unit_push(&sections->data, statement);
+
+    statement.tag = X86_64_DIRECTIVE;
+    statement.data.directive.name = X86_64_QUAD;
+    statement.data.directive.operands[0] = symbol_table_insert("@flush");
+    statement.data.directive.operands[0]->type = SYM_LABEL;
+    statement.data.directive.operand_count = 1;
+    x86_64_asm_unit_push(&sections->data, statement);
+}
+
+static void gen_flush_function(struct sections *sections)
+{
+    struct x86_64_asm_stmt statement;
+    struct symbol *name;
+    struct symbol *loop;
+    struct symbol *done;
+
+    loop = symbol_table_create_tmp_label();
+    done = symbol_table_create_tmp_label();
+
+    name = symbol_table_insert("@flush");
+    name->type = SYM_LABEL;
+
+    statement.tag = X86_64_LABEL;
+    statement.data.label = name;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    gen_enter_boilerplate(sections);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_SUB;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RSP;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_IMMEDIATE;
+    statement.data.instruction.operands[1].data.immediate =
+        symbol_table_create_int_lit(16);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DISPLACED;
+    statement.data.instruction.operands[0].data.displaced.base = X86_64_RBP;
+    statement.data.instruction.operands[0].data.displaced.displacement =
+        symbol_table_create_int_lit(-8);
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_RBX;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DISPLACED;
+    statement.data.instruction.operands[0].data.displaced.base = X86_64_RBP;
+    statement.data.instruction.operands[0].data.displaced.displacement =
+        symbol_table_create_int_lit(-16);
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_R12;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_LEA;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RBX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DISPLACED;
+    statement.data.instruction.operands[1].data.displaced.base = X86_64_RIP;
+    statement.data.instruction.operands[1].data.displaced.displacement =
+        runtime_var_sym("@outbuf", DATATYPE_CARA);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_R12;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DISPLACED;
+    statement.data.instruction.operands[1].data.displaced.base = X86_64_RIP;
+    statement.data.instruction.operands[1].data.displaced.displacement =
+        runtime_var_sym("@outpos", DATATYPE_INTE);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_LABEL;
+    statement.data.label = loop;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_TEST;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_R12;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_R12;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_JZ;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
+    statement.data.instruction.operands[0].data.address = done;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RDI;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_IMMEDIATE;
+    statement.data.instruction.operands[1].data.immediate =
+        symbol_table_create_int_lit(1);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RSI;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_RBX;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RDX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_R12;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_CALL;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_PLT;
+    statement.data.instruction.operands[0].data.address =
+        symbol_table_insert("write");
+    statement.data.instruction.operands[0].data.address->type =
+        SYM_EXTERNAL;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    /* on errors, whatever was left is dropped */
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_TEST;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RAX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_RAX;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_JLE;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
+    statement.data.instruction.operands[0].data.address = done;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_ADD;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RBX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_RAX;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_SUB;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_R12;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_RAX;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_JMP;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
+    statement.data.instruction.operands[0].data.address = loop;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_LABEL;
+    statement.data.label = done;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DISPLACED;
+    statement.data.instruction.operands[0].data.displaced.base = X86_64_RIP;
+    statement.data.instruction.operands[0].data.displaced.displacement =
+        runtime_var_sym("@outpos", DATATYPE_INTE);
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_IMMEDIATE;
+    statement.data.instruction.operands[1].data.immediate =
+        symbol_table_create_int_lit(0);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RBX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DISPLACED;
+    statement.data.instruction.operands[1].data.displaced.base = X86_64_RBP;
+    statement.data.instruction.operands[1].data.displaced.displacement =
+        symbol_table_create_int_lit(-8);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_R12;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DISPLACED;
+    statement.data.instruction.operands[1].data.displaced.base = X86_64_RBP;
+    statement.data.instruction.operands[1].data.displaced.displacement =
+        symbol_table_create_int_lit(-16);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    gen_leave_boilerplate(sections);
+}
+
+static void gen_write_bytes_function(struct sections *sections)
+{
+    struct x86_64_asm_stmt statement;
+    struct symbol *name;
+    struct symbol *loop;
+    struct symbol *chunk;
+    struct symbol *copy;
+    struct symbol *copied;
+    struct symbol *done;
+
+    loop = symbol_table_create_tmp_label();
+    chunk = symbol_table_create_tmp_label();
+    copy = symbol_table_create_tmp_label();
+    copied = symbol_table_create_tmp_label();
+    done = symbol_table_create_tmp_label();
+
+    name = symbol_table_insert("@write_bytes");
+    name->type = SYM_LABEL;
+
+    statement.tag = X86_64_LABEL;
+    statement.data.label = name;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    gen_enter_boilerplate(sections);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_SUB;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RSP;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_IMMEDIATE;
+    statement.data.instruction.operands[1].data.immediate =
+        symbol_table_create_int_lit(16);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DISPLACED;
+    statement.data.instruction.operands[0].data.displaced.base = X86_64_RBP;
+    statement.data.instruction.operands[0].data.displaced.displacement =
+        symbol_table_create_int_lit(-8);
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_RBX;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DISPLACED;
+    statement.data.instruction.operands[0].data.displaced.base = X86_64_RBP;
+    statement.data.instruction.operands[0].data.displaced.displacement =
+        symbol_table_create_int_lit(-16);
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_R12;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RBX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_RDI;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_R12;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_RSI;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_LABEL;
+    statement.data.label = loop;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    /* copies as much as fits, flushing until everything was copied */
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RAX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DISPLACED;
+    statement.data.instruction.operands[1].data.displaced.base = X86_64_RIP;
+    statement.data.instruction.operands[1].data.displaced.displacement =
+        runtime_var_sym("@outpos", DATATYPE_INTE);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RCX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_IMMEDIATE;
+    statement.data.instruction.operands[1].data.immediate =
+        symbol_table_create_int_lit(OUTPUT_BUFFER_SIZE);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_SUB;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RCX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_RAX;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_CMP;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_R12;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_RCX;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_JG;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
+    statement.data.instruction.operands[0].data.address = chunk;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RCX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_R12;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_LABEL;
+    statement.data.label = chunk;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_LEA;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RDI;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DISPLACED;
+    statement.data.instruction.operands[1].data.displaced.base = X86_64_RIP;
+    statement.data.instruction.operands[1].data.displaced.displacement =
+        runtime_var_sym("@outbuf", DATATYPE_CARA);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_ADD;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RDI;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_RAX;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_ADD;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RAX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_RCX;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DISPLACED;
+    statement.data.instruction.operands[0].data.displaced.base = X86_64_RIP;
+    statement.data.instruction.operands[0].data.displaced.displacement =
+        runtime_var_sym("@outpos", DATATYPE_INTE);
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_RAX;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_SUB;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_R12;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_RCX;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_TEST;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RCX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_RCX;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_JZ;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
+    statement.data.instruction.operands[0].data.address = copied;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_LABEL;
+    statement.data.label = copy;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_DL;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DISPLACED;
+    statement.data.instruction.operands[1].data.displaced.base = X86_64_RBX;
+    statement.data.instruction.operands[1].data.displaced.displacement =
+        symbol_table_create_int_lit(0);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DISPLACED;
+    statement.data.instruction.operands[0].data.displaced.base = X86_64_RDI;
+    statement.data.instruction.operands[0].data.displaced.displacement =
+        symbol_table_create_int_lit(0);
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_DL;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_INC;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RBX;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_INC;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RDI;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_DEC;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RCX;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_JNZ;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
+    statement.data.instruction.operands[0].data.address = copy;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_LABEL;
+    statement.data.label = copied;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_TEST;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_R12;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_R12;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_JZ;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
+    statement.data.instruction.operands[0].data.address = done;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_CALL;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
+    statement.data.instruction.operands[0].data.address =
+        symbol_table_insert("@flush");
+    statement.data.instruction.operands[0].data.address->type =
+        SYM_LABEL;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_JMP;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
+    statement.data.instruction.operands[0].data.address = loop;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_LABEL;
+    statement.data.label = done;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RBX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DISPLACED;
+    statement.data.instruction.operands[1].data.displaced.base = X86_64_RBP;
+    statement.data.instruction.operands[1].data.displaced.displacement =
+        symbol_table_create_int_lit(-8);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_R12;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DISPLACED;
+    statement.data.instruction.operands[1].data.displaced.base = X86_64_RBP;
+    statement.data.instruction.operands[1].data.displaced.displacement =
+        symbol_table_create_int_lit(-16);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    gen_leave_boilerplate(sections);
+}
+
+static void gen_write_int_function(struct sections *sections)
+{
+    struct x86_64_asm_stmt statement;
+    struct symbol *name;
+    struct symbol *digits;
+    struct symbol *loop;
+    struct symbol *done;
+
+    digits = symbol_table_create_tmp_label();
+    loop = symbol_table_create_tmp_label();
+    done = symbol_table_create_tmp_label();
+
+    name = symbol_table_insert("@write_int");
+    name->type = SYM_LABEL;
+
+    statement.tag = X86_64_LABEL;
+    statement.data.label = name;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    gen_enter_boilerplate(sections);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_SUB;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RSP;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_IMMEDIATE;
+    statement.data.instruction.operands[1].data.immediate =
+        symbol_table_create_int_lit(32);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    /* digits are written backwards from the frame base */
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RAX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_RDI;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RSI;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_RBP;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_R8;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_RDI;
     x86_64_asm_unit_push(&sections->text, statement);
 
     statement.tag = X86_64_INSTRUCTION;
-    statement.data.instruction.opcode = X86_64_MOV;
-    statement.data.instruction.operands[0].tag =
-        X86_64_OPERAND_DIRECT;
-    statement.data.instruction.operands[0].data.direct = X86_64_RBP;
-    statement.data.instruction.operands[1].tag =
-        X86_64_OPERAND_DIRECT;
-    statement.data.instruction.operands[1].data.direct = X86_64_RSP;
+    statement.data.instruction.opcode = X86_64_CMP;
     statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RAX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_IMMEDIATE;
+    statement.data.instruction.operands[1].data.immediate =
+        symbol_table_create_int_lit(0);
     x86_64_asm_unit_push(&sections->text, statement);
-}
 
-static void gen_read_function(struct sections *sections)
-{
-    struct x86_64_asm_stmt statement;
-    struct symbol *name;
-    struct symbol *format_spec;
-    struct symbol *retry;
-    struct symbol *retry_done;
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_JGE;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
+    statement.data.instruction.operands[0].data.address = digits;
+    x86_64_asm_unit_push(&sections->text, statement);
 
-    name = symbol_table_insert("@entrada");
-    name->type = SYM_LABEL;
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_NEG;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RAX;
+    x86_64_asm_unit_push(&sections->text, statement);
 
     statement.tag = X86_64_LABEL;
-    statement.data.label = name;
+    statement.data.label = digits;
     x86_64_asm_unit_push(&sections->text, statement);
 
-    gen_enter_boilerplate(sections);
-
     statement.tag = X86_64_INSTRUCTION;
-    statement.data.instruction.opcode = X86_64_SUB;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
     statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
-    statement.data.instruction.operands[0].data.direct = X86_64_RSP;
+    statement.data.instruction.operands[0].data.direct = X86_64_R9;
     statement.data.instruction.operands[1].tag = X86_64_OPERAND_IMMEDIATE;
     statement.data.instruction.operands[1].data.immediate =
-        symbol_table_create_int_lit(16);
-    statement.data.instruction.operand_count = 2;
+        symbol_table_create_int_lit(10);
     x86_64_asm_unit_push(&sections->text, statement);
 
-    format_spec = symbol_table_create_str_lit("%li\\0");
-
-    retry = symbol_table_create_tmp_label();
-    retry_done = symbol_table_create_tmp_label();
-
     statement.tag = X86_64_LABEL;
-    statement.data.label = retry;
+    statement.data.label = loop;
     x86_64_asm_unit_push(&sections->text, statement);
 
     statement.tag = X86_64_INSTRUCTION;
-    statement.data.instruction.opcode = X86_64_CALL;
+    statement.data.instruction.opcode = X86_64_XOR;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RDX;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_RDX;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_DIV;
     statement.data.instruction.operand_count = 1;
-    statement.data.instruction.operands[0].tag = X86_64_OPERAND_PLT;
-    statement.data.instruction.operands[0].data.address =
-        symbol_table_insert("getchar");
-    statement.data.instruction.operands[0].data.address->type =
-        SYM_EXTERNAL;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_R9;
     x86_64_asm_unit_push(&sections->text, statement);
 
     statement.tag = X86_64_INSTRUCTION;
-    statement.data.instruction.opcode = X86_64_CMP;
+    statement.data.instruction.opcode = X86_64_ADD;
     statement.data.instruction.operand_count = 2;
     statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
-    statement.data.instruction.operands[0].data.direct = X86_64_RAX;
+    statement.data.instruction.operands[0].data.direct = X86_64_RDX;
     statement.data.instruction.operands[1].tag = X86_64_OPERAND_IMMEDIATE;
     statement.data.instruction.operands[1].data.immediate =
-        symbol_table_create_int_lit('+');
+        symbol_table_create_int_lit('0');
     x86_64_asm_unit_push(&sections->text, statement);
 
     statement.tag = X86_64_INSTRUCTION;
-    statement.data.instruction.opcode = X86_64_JZ;
+    statement.data.instruction.opcode = X86_64_DEC;
     statement.data.instruction.operand_count = 1;
-    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
-    statement.data.instruction.operands[0].data.address = retry_done;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RSI;
     x86_64_asm_unit_push(&sections->text, statement);
 
     statement.tag = X86_64_INSTRUCTION;
-    statement.data.instruction.opcode = X86_64_CMP;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DISPLACED;
+    statement.data.instruction.operands[0].data.displaced.base = X86_64_RSI;
+    statement.data.instruction.operands[0].data.displaced.displacement =
+        symbol_table_create_int_lit(0);
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_DL;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_TEST;
     statement.data.instruction.operand_count = 2;
     statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
     statement.data.instruction.operands[0].data.direct = X86_64_RAX;
-    statement.data.instruction.operands[1].tag = X86_64_OPERAND_IMMEDIATE;
-    statement.data.instruction.operands[1].data.immediate =
-        symbol_table_create_int_lit('-');
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_RAX;
     x86_64_asm_unit_push(&sections->text, statement);
 
     statement.tag = X86_64_INSTRUCTION;
-    statement.data.instruction.opcode = X86_64_JZ;
+    statement.data.instruction.opcode = X86_64_JNZ;
     statement.data.instruction.operand_count = 1;
     statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
-    statement.data.instruction.operands[0].data.address = retry_done;
+    statement.data.instruction.operands[0].data.address = loop;
     x86_64_asm_unit_push(&sections->text, statement);
 
     statement.tag = X86_64_INSTRUCTION;
     statement.data.instruction.opcode = X86_64_CMP;
     statement.data.instruction.operand_count = 2;
     statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
-    statement.data.instruction.operands[0].data.direct = X86_64_RAX;
+    statement.data.instruction.operands[0].data.direct = X86_64_R8;
     statement.data.instruction.operands[1].tag = X86_64_OPERAND_IMMEDIATE;
     statement.data.instruction.operands[1].data.immediate =
-        symbol_table_create_int_lit('0');
+        symbol_table_create_int_lit(0);
     x86_64_asm_unit_push(&sections->text, statement);
 
     statement.tag = X86_64_INSTRUCTION;
-    statement.data.instruction.opcode = X86_64_JL;
+    statement.data.instruction.opcode = X86_64_JGE;
     statement.data.instruction.operand_count = 1;
     statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
-    statement.data.instruction.operands[0].data.address = retry;
+    statement.data.instruction.operands[0].data.address = done;
     x86_64_asm_unit_push(&sections->text, statement);
 
     statement.tag = X86_64_INSTRUCTION;
-    statement.data.instruction.opcode = X86_64_CMP;
+    statement.data.instruction.opcode = X86_64_DEC;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RSI;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
     statement.data.instruction.operand_count = 2;
     statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
-    statement.data.instruction.operands[0].data.direct = X86_64_RAX;
+    statement.data.instruction.operands[0].data.direct = X86_64_DL;
     statement.data.instruction.operands[1].tag = X86_64_OPERAND_IMMEDIATE;
     statement.data.instruction.operands[1].data.immediate =
-        symbol_table_create_int_lit('9');
+        symbol_table_create_int_lit('-');
     x86_64_asm_unit_push(&sections->text, statement);
 
     statement.tag = X86_64_INSTRUCTION;
-    statement.data.instruction.opcode = X86_64_JG;
-    statement.data.instruction.operand_count = 1;
-    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
-    statement.data.instruction.operands[0].data.address = retry;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DISPLACED;
+    statement.data.instruction.operands[0].data.displaced.base = X86_64_RSI;
+    statement.data.instruction.operands[0].data.displaced.displacement =
+        symbol_table_create_int_lit(0);
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_DL;
     x86_64_asm_unit_push(&sections->text, statement);
 
     statement.tag = X86_64_LABEL;
-    statement.data.label = retry_done;
+    statement.data.label = done;
     x86_64_asm_unit_push(&sections->text, statement);
 
     statement.tag = X86_64_INSTRUCTION;
@@ -2395,7 +5759,7 @@ static void gen_read_function(struct sections *sections)
     statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
     statement.data.instruction.operands[0].data.direct = X86_64_RDI;
     statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
-    statement.data.instruction.operands[1].data.direct = X86_64_RAX;
+    statement.data.instruction.operands[1].data.direct = X86_64_RSI;
     x86_64_asm_unit_push(&sections->text, statement);
 
     statement.tag = X86_64_INSTRUCTION;
@@ -2403,67 +5767,167 @@ static void gen_read_function(struct sections *sections)
     statement.data.instruction.operand_count = 2;
     statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
     statement.data.instruction.operands[0].data.direct = X86_64_RSI;
-    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DISPLACED;
-    statement.data.instruction.operands[1].data.displaced.base = X86_64_RIP;
-    statement.data.instruction.operands[1].data.displaced.displacement =
-        symbol_table_insert("stdin");
-    statement.data.instruction.operands[1].data.displaced.displacement
-        ->type = SYM_SCALAR_VAR;
-    statement.data.instruction.operands[1].data.displaced.displacement
-        ->data.variable.in_scope = 1;
-    statement.data.instruction.operands[1].data.displaced.displacement
-        ->data.variable.type = DATATYPE_INTE;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_RBP;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_SUB;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RSI;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_RDI;
     x86_64_asm_unit_push(&sections->text, statement);
 
     statement.tag = X86_64_INSTRUCTION;
     statement.data.instruction.opcode = X86_64_CALL;
     statement.data.instruction.operand_count = 1;
-    statement.data.instruction.operands[0].tag = X86_64_OPERAND_PLT;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
     statement.data.instruction.operands[0].data.address =
-        symbol_table_insert("ungetc");
+        symbol_table_insert("@write_bytes");
     statement.data.instruction.operands[0].data.address->type =
-        SYM_EXTERNAL;
+        SYM_LABEL;
     x86_64_asm_unit_push(&sections->text, statement);
 
-    gen_read_instructions(
-        sections,
-        format_spec,
-        X86_64_MOV,
-        X86_64_RDI
-    );
+    gen_leave_boilerplate(sections);
+}
+
+static void gen_write_real_function(struct sections *sections)
+{
+    struct x86_64_asm_stmt statement;
+    struct symbol *name;
+    struct symbol *format_spec;
+    struct symbol *room;
+
+    room = symbol_table_create_tmp_label();
+    format_spec = symbol_table_create_str_lit("%lf\\0");
+
+    name = symbol_table_insert("@write_real");
+    name->type = SYM_LABEL;
+
+    statement.tag = X86_64_LABEL;
+    statement.data.label = name;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    gen_enter_boilerplate(sections);
 
     statement.tag = X86_64_INSTRUCTION;
-    statement.data.instruction.opcode = X86_64_LEA;
+    statement.data.instruction.opcode = X86_64_SUB;
     statement.data.instruction.operand_count = 2;
     statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
-    statement.data.instruction.operands[0].data.direct = X86_64_RSI;
+    statement.data.instruction.operands[0].data.direct = X86_64_RSP;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_IMMEDIATE;
+    statement.data.instruction.operands[1].data.immediate =
+        symbol_table_create_int_lit(16);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    /* snprintf is given room for any double printed with %lf */
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RAX;
     statement.data.instruction.operands[1].tag = X86_64_OPERAND_DISPLACED;
-    statement.data.instruction.operands[1].data.displaced.base = X86_64_RBP;
+    statement.data.instruction.operands[1].data.displaced.base = X86_64_RIP;
     statement.data.instruction.operands[1].data.displaced.displacement =
-        symbol_table_create_int_lit(-8);
+        runtime_var_sym("@outpos", DATATYPE_INTE);
     x86_64_asm_unit_push(&sections->text, statement);
 
     statement.tag = X86_64_INSTRUCTION;
-    statement.data.instruction.opcode = X86_64_XOR;
+    statement.data.instruction.opcode = X86_64_CMP;
     statement.data.instruction.operand_count = 2;
     statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
     statement.data.instruction.operands[0].data.direct = X86_64_RAX;
-    statement.data.instruction.operands[1] =
-        statement.data.instruction.operands[0];
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_IMMEDIATE;
+    statement.data.instruction.operands[1].data.immediate =
+        symbol_table_create_int_lit(OUTPUT_BUFFER_SIZE - OUTPUT_REAL_ROOM);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_JLE;
+    statement.data.instruction.operand_count = 1;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
+    statement.data.instruction.operands[0].data.address = room;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOVQ;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DISPLACED;
+    statement.data.instruction.operands[0].data.displaced.base = X86_64_RBP;
+    statement.data.instruction.operands[0].data.displaced.displacement =
+        symbol_table_create_int_lit(-8);
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_XMM0;
     x86_64_asm_unit_push(&sections->text, statement);
 
     statement.tag = X86_64_INSTRUCTION;
     statement.data.instruction.opcode = X86_64_CALL;
     statement.data.instruction.operand_count = 1;
-    statement.data.instruction.operands[0].tag = X86_64_OPERAND_PLT;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
     statement.data.instruction.operands[0].data.address =
-        symbol_table_insert("scanf");
+        symbol_table_insert("@flush");
     statement.data.instruction.operands[0].data.address->type =
-        SYM_EXTERNAL;
+        SYM_LABEL;
     x86_64_asm_unit_push(&sections->text, statement);
 
     statement.tag = X86_64_INSTRUCTION;
-    statement.data.instruction.opcode = X86_64_CMP;
+    statement.data.instruction.opcode = X86_64_MOVQ;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_XMM0;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DISPLACED;
+    statement.data.instruction.operands[1].data.displaced.base = X86_64_RBP;
+    statement.data.instruction.operands[1].data.displaced.displacement =
+        symbol_table_create_int_lit(-8);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_LABEL;
+    statement.data.label = room;
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_LEA;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RDI;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DISPLACED;
+    statement.data.instruction.operands[1].data.displaced.base = X86_64_RIP;
+    statement.data.instruction.operands[1].data.displaced.displacement =
+        runtime_var_sym("@outbuf", DATATYPE_CARA);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_ADD;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RDI;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DISPLACED;
+    statement.data.instruction.operands[1].data.displaced.base = X86_64_RIP;
+    statement.data.instruction.operands[1].data.displaced.displacement =
+        runtime_var_sym("@outpos", DATATYPE_INTE);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.operand_count = 2;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[0].data.direct = X86_64_RSI;
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_IMMEDIATE;
+    statement.data.instruction.operands[1].data.immediate =
+        symbol_table_create_int_lit(OUTPUT_REAL_ROOM);
+    x86_64_asm_unit_push(&sections->text, statement);
+
+    gen_read_instructions(
+        sections,
+        format_spec,
+        X86_64_MOV,
+        X86_64_RDX
+    );
+
+    statement.tag = X86_64_INSTRUCTION;
+    statement.data.instruction.opcode = X86_64_MOV;
     statement.data.instruction.operand_count = 2;
     statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
     statement.data.instruction.operands[0].data.direct = X86_64_RAX;
@@ -2473,22 +5937,51 @@ static void gen_read_function(struct sections *sections)
     x86_64_asm_unit_push(&sections->text, statement);
 
     statement.tag = X86_64_INSTRUCTION;
-    statement.data.instruction.opcode = X86_64_JNZ;
+    statement.data.instruction.opcode = X86_64_CALL;
     statement.data.instruction.operand_count = 1;
-    statement.data.instruction.operands[0].tag = X86_64_OPERAND_ADDRESS;
-    statement.data.instruction.operands[0].data.address = retry;
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_PLT;
+    statement.data.instruction.operands[0].data.address =
+        symbol_table_insert("snprintf");
+    statement.data.instruction.operands[0].data.address->type =
+        SYM_EXTERNAL;
     x86_64_asm_unit_push(&sections->text, statement);
 
     statement.tag = X86_64_INSTRUCTION;
-    statement.data.instruction.opcode = X86_64_MOV;
+    statement.data.instruction.opcode = X86_64_ADD;
     statement.data.instruction.operand_count = 2;
-    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DIRECT;
-    statement.data.instruction.operands[0].data.direct = X86_64_RAX;
-    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DISPLACED;
-    statement.data.instruction.operands[1].data.displaced.base = X86_64_RBP;
-    statement.data.instruction.operands[1].data.displaced.displacement =
-        symbol_table_create_int_lit(-8);
+    statement.data.instruction.operands[0].tag = X86_64_OPERAND_DISPLACED;
+    statement.data.instruction.operands[0].data.displaced.base = X86_64_RIP;
+    statement.data.instruction.operands[0].data.displaced.displacement =
+        runtime_var_sym("@outpos", DATATYPE_INTE);
+    statement.data.instruction.operands[1].tag = X86_64_OPERAND_DIRECT;
+    statement.data.instruction.operands[1].data.direct = X86_64_RAX;
     x86_64_asm_unit_push(&sections->text, statement);
 
     gen_leave_boilerplate(sections);
 }
+
+static void gen_runtime_var(struct sections *sections, struct symbol *var)
+{
+    gen_data_label(&sections->bss, var, 8);
+    gen_zeroes_def(&sections->bss, var, 1);
+}
+
+static void gen_runtime_buffer(
+    struct sections *sections,
+    struct symbol *buffer,
+    long size
+)
+{
+    gen_data_label(&sections->bss, buffer, CACHE_LINE_SIZE);
+    gen_zeroes_def(&sections->bss, buffer, size);
+}
+
+/* runtime data is named with an @ so that it never clashes with programs */
+static struct symbol *runtime_var_sym(char const *name, enum datatype type)
+{
+    struct symbol *symbol = symbol_table_insert(name);
+    symbol->type = SYM_SCALAR_VAR;
+    symbol->data.variable.in_scope = 1;
+    symbol->data.variable.type = type;
+    return symbol;
+}
@@ -3,7 +3,11 @@
 
 #include "tac.h"
 #include "x86_64_asm.h"
+#include "x86_64_opt.h"
 
-struct x86_64_asm_unit x86_64_pc_linux_gnu_gen(struct tac tac);
+struct x86_64_asm_unit x86_64_pc_linux_gnu_gen(
+    struct tac tac,
+    x86_64_opt_flags_type flags
+);
 
 #endif
@@ -0,0 +1,487 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include "x86_64_regalloc.h"
+#include "symboltable.h"
+#include "vector.h"
+#include "panic.h"
+
+#define FIRST_GPR_INDEX 0
+#define GPR_COUNT 5
+#define FIRST_SSE_INDEX 5
+#define SSE_COUNT 4
+
+enum register_class {
+    REGISTER_CLASS_NONE,
+    REGISTER_CLASS_GPR,
+    REGISTER_CLASS_SSE
+};
+
+struct interval {
+    struct symbol *symbol;
+    size_t start;
+    size_t end;
+    int crosses_call;
+    enum register_class register_class;
+};
+
+struct interval_set {
+    size_t length;
+    struct interval *intervals;
+};
+
+struct label_position {
+    struct symbol *label;
+    size_t position;
+};
+
+struct back_edge {
+    size_t target;
+    size_t source;
+};
+
+struct function_scan {
+    struct interval_set interval_set;
+    size_t label_count;
+    struct label_position *labels;
+    size_t back_edge_count;
+    struct back_edge *back_edges;
+    size_t call_count;
+    size_t *calls;
+};
+
+static enum x86_64_register const allocatable_registers[] = {
+    X86_64_RBX,
+    X86_64_R12,
+    X86_64_R13,
+    X86_64_R14,
+    X86_64_R15,
+    X86_64_XMM8,
+    X86_64_XMM9,
+    X86_64_XMM10,
+    X86_64_XMM11
+};
+
+static struct function_scan function_scan_init(void);
+
+static void function_scan_free(struct function_scan scan);
+
+static void scan_function(
+    struct function_scan *scan,
+    struct tac_node *beginfun_node
+);
+
+static void scan_operand(
+    struct function_scan *scan,
+    struct symbol *symbol,
+    size_t position,
+    int is_def
+);
+
+static void scan_jump(
+    struct function_scan *scan,
+    struct symbol *label,
+    size_t position
+);
+
+static void extend_over_loops(struct function_scan *scan);
+
+static void mark_call_crossings(struct function_scan *scan);
+
+static enum register_class symbol_register_class(struct symbol *symbol);
+
+static int interval_cmp_start(void const *left, void const *right);
+
+static void linear_scan(struct interval_set interval_set);
+
+static void expire_intervals(
+    struct interval **active,
+    size_t *active_length,
+    size_t position,
+    int *free_registers
+);
+
+static int take_free_register(
+    enum register_class register_class,
+    int *free_registers,
+    size_t *register_index
+);
+
+void x86_64_regalloc_function(struct tac_node *beginfun_node)
+{
+    struct function_scan scan = function_scan_init();
+
+    scan_function(&scan, beginfun_node);
+    extend_over_loops(&scan);
+    mark_call_crossings(&scan);
+
+    qsort(
+        scan.interval_set.intervals,
+        scan.interval_set.length,
+        sizeof(*scan.interval_set.intervals),
+        interval_cmp_start
+    );
+    linear_scan(scan.interval_set);
+
+    function_scan_free(scan);
+}
+
+enum x86_64_register x86_64_regalloc_register(size_t register_index)
+{
+    if (register_index >= X86_64_REGALLOC_REGISTERS) {
+        panic("register index %zu is not allocatable", register_index);
+    }
+    return allocatable_registers[register_index];
+}
+
+int x86_64_regalloc_is_callee_saved(size_t register_index)
+{
+    return register_index >= FIRST_GPR_INDEX
+        && register_index < FIRST_GPR_INDEX + GPR_COUNT;
+}
+
+int x86_64_regalloc_is_allocatable(enum x86_64_register reg)
+{
+    size_t i;
+
+    for (i = 0; i < X86_64_REGALLOC_REGISTERS; i++) {
+        if (x86_64_reg_unsized_eq(reg, allocatable_registers[i])) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static struct function_scan function_scan_init(void)
+{
+    struct function_scan scan;
+    scan.interval_set.intervals = vector_empty(&scan.interval_set.length);
+    scan.labels = vector_empty(&scan.label_count);
+    scan.back_edges = vector_empty(&scan.back_edge_count);
+    scan.calls = vector_empty(&scan.call_count);
+    return scan;
+}
+
+static void function_scan_free(struct function_scan scan)
+{
+    free(scan.interval_set.intervals);
+    free(scan.labels);
+    free(scan.back_edges);
+    free(scan.calls);
+}
+
+static void scan_function(
+    struct function_scan *scan,
+    struct tac_node *beginfun_node
+)
+{
+    size_t position;
+    struct tac_node *node;
+    struct label_position label_position;
+
+    position = 0;
+    node = beginfun_node->next;
+
+    while (node != NULL && node->instruction.opcode != TAC_ENDFUN) {
+        position++;
+
+        switch (node->instruction.opcode) {
+            case TAC_LABEL:
+                label_position.label = node->instruction.srcs[0];
+                label_position.position = position;
+                scan->labels = vector_push(
+                    scan->labels,
+                    sizeof(*scan->labels),
+                    &scan->label_count,
+                    &label_position
+                );
+                break;
+            case TAC_JUMP:
+                scan_jump(scan, node->instruction.dest, position);
+                break;
+            case TAC_IFZ:
+                scan_operand(scan, node->instruction.srcs[0], position, 0);
+                scan_jump(scan, node->instruction.dest, position);
+                break;
+            case TAC_DEFP:
+                /* parameters are all written before the body runs */
+                scan_operand(scan, node->instruction.dest, position, 0);
+                break;
+            case TAC_CALL:
+            case TAC_PRINT:
+            case TAC_READ:
+                scan->calls = vector_push(
+                    scan->calls,
+                    sizeof(*scan->calls),
+                    &scan->call_count,
+                    &position
+                );
+            default:
+                scan_operand(scan, node->instruction.srcs[0], position, 0);
+                scan_operand(scan, node->instruction.srcs[1], position, 0);
+                scan_operand(scan, node->instruction.dest, position, 1);
+                break;
+        }
+
+        node = node->next;
+    }
+}
+
+static void scan_operand(
+    struct function_scan *scan,
+    struct symbol *symbol,
+    size_t position,
+    int is_def
+)
+{
+    size_t i;
+    struct interval interval;
+
+    if (symbol == NULL) {
+        return;
+    }
+    if (
+        symbol->type != SYM_TMP_VAR
+        && (
+            symbol->type != SYM_SCALAR_VAR
+            || symbol->data.variable.stack_frame_index == SIZE_MAX
+        )
+    ) {
+        return;
+    }
+
+    symbol->data.variable.register_index = SIZE_MAX;
+
+    for (i = 0; i < scan->interval_set.length; i++) {
+        if (scan->interval_set.intervals[i].symbol == symbol) {
+            scan->interval_set.intervals[i].end = position;
+            return;
+        }
+    }
+
+    interval.symbol = symbol;
+    /* a temporary read before any write is live on entry */
+    interval.start = is_def ? position : 0;
+    interval.end = position;
+    interval.crosses_call = 0;
+    interval.register_class = symbol_register_class(symbol);
+    scan->interval_set.intervals = vector_push(
+        scan->interval_set.intervals,
+        sizeof(*scan->interval_set.intervals),
+        &scan->interval_set.length,
+        &interval
+    );
+}
+
+static void scan_jump(
+    struct function_scan *scan,
+    struct symbol *label,
+    size_t position
+)
+{
+    size_t i;
+    struct back_edge back_edge;
+
+    for (i = 0; i < scan->label_count; i++) {
+        if (scan->labels[i].label == label) {
+            back_edge.target = scan->labels[i].position;
+            back_edge.source = position;
+            scan->back_edges = vector_push(
+                scan->back_edges,
+                sizeof(*scan->back_edges),
+                &scan->back_edge_count,
+                &back_edge
+            );
+            return;
+        }
+    }
+}
+
+static void extend_over_loops(struct function_scan *scan)
+{
+    size_t i, j;
+    int changed;
+    struct interval *interval;
+    struct back_edge back_edge;
+
+    do {
+        changed = 0;
+        for (i = 0; i < scan->back_edge_count; i++) {
+            back_edge = scan->back_edges[i];
+            for (j = 0; j < scan->interval_set.length; j++) {
+                interval = &scan->interval_set.intervals[j];
+                if (
+                    interval->start < back_edge.target
+                    && interval->end >= back_edge.target
+                    && interval->end < back_edge.source
+                ) {
+                    interval->end = back_edge.source;
+                    changed = 1;
+                }
+            }
+        }
+    } while (changed);
+}
+
+static void mark_call_crossings(struct function_scan *scan)
+{
+    size_t i, j;
+    struct interval *interval;
+
+    for (i = 0; i < scan->interval_set.length; i++) {
+        interval = &scan->interval_set.intervals[i];
+        j = 0;
+        while (!interval->crosses_call && j < scan->call_count) {
+            interval->crosses_call = interval->start < scan->calls[j]
+                && scan->calls[j] < interval->end;
+            j++;
+        }
+    }
+}
+
+static enum register_class symbol_register_class(struct symbol *symbol)
+{
+    switch (symbol->data.variable.type) {
+        case DATATYPE_INTE:
+        case DATATYPE_NATU:
+            return REGISTER_CLASS_GPR;
+        case DATATYPE_REAL:
+            return REGISTER_CLASS_SSE;
+        default:
+            return REGISTER_CLASS_NONE;
+    }
+}
+
+static int interval_cmp_start(void const *left, void const *right)
+{
+    struct interval const *left_interval = left;
+    struct interval const *right_interval = right;
+
+    if (left_interval->start < right_interval->start) {
+        return -1;
+    }
+    if (left_interval->start > right_interval->start) {
+        return 1;
+    }
+    return 0;
+}
+
+static void linear_scan(struct interval_set interval_set)
+{
+    size_t i, j, active_length, register_index, victim;
+    int free_registers[X86_64_REGALLOC_REGISTERS];
+    struct interval *current;
+    struct interval **active;
+
+    for (i = 0; i < X86_64_REGALLOC_REGISTERS; i++) {
+        free_registers[i] = 1;
+    }
+
+    active = vector_empty(&active_length);
+
+    for (i = 0; i < interval_set.length; i++) {
+        current = &interval_set.intervals[i];
+        expire_intervals(active, &active_length, current->start, free_registers);
+
+        if (
+            current->register_class == REGISTER_CLASS_NONE
+            || (
+                current->register_class == REGISTER_CLASS_SSE
+                && current->crosses_call
+            )
+        ) {
+            continue;
+        }
+
+        if (take_free_register(
+            current->register_class,
+            free_registers,
+            &register_index
+        )) {
+            current->symbol->data.variable.register_index = register_index;
+        } else {
+            victim = active_length;
+            for (j = 0; j < active_length; j++) {
+                if (
+                    active[j]->register_class == current->register_class
+                    && (
+                        victim == active_length
+                        || active[j]->end > active[victim]->end
+                    )
+                ) {
+                    victim = j;
+                }
+            }
+            if (victim == active_length || active[victim]->end <= current->end) {
+                continue;
+            }
+            current->symbol->data.variable.register_index =
+                active[victim]->symbol->data.variable.register_index;
+            active[victim]->symbol->data.variable.register_index = SIZE_MAX;
+            active = vector_splice(
+                active,
+                sizeof(*active),
+                &active_length,
+                victim,
+                victim + 1,
+                NULL,
+                0,
+                NULL
+            );
+        }
+
+        active = vector_push(active, sizeof(*active), &active_length, &current);
+    }
+
+    free(active);
+}
+
+static void expire_intervals(
+    struct interval **active,
+    size_t *active_length,
+    size_t position,
+    int *free_registers
+)
+{
+    size_t i, kept;
+
+    kept = 0;
+    for (i = 0; i < *active_length; i++) {
+        if (active[i]->end < position) {
+            free_registers[
+                active[i]->symbol->data.variable.register_index
+            ] = 1;
+        } else {
+            active[kept] = active[i];
+            kept++;
+        }
+    }
+    *active_length = kept;
+}
+
+static int take_free_register(
+    enum register_class register_class,
+    int *free_registers,
+    size_t *register_index
+)
+{
+    size_t first, count, i;
+
+    if (register_class == REGISTER_CLASS_SSE) {
+        first = FIRST_SSE_INDEX;
+        count = SSE_COUNT;
+    } else {
+        first = FIRST_GPR_INDEX;
+        count = GPR_COUNT;
+    }
+
+    for (i = first; i < first + count; i++) {
+        if (free_registers[i]) {
+            free_registers[i] = 0;
+            *register_index = i;
+            return 1;
+        }
+    }
+
+    return 0;
+}
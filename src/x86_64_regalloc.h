@@ -0,0 +1,28 @@
+#ifndef X86_64_REGALLOC_H_
+#define X86_64_REGALLOC_H_ 1
+
+#include "tac.h"
+#include "x86_64_asm.h"
+
+#define X86_64_REGALLOC_REGISTERS 9
+
+/**
+ * Assigns registers to the temporaries of the function starting at the given
+ * .beginfun node through linear scan over their live intervals. Parameters
+ * already given a stack frame slot are allocated as well. Allocated symbols get
+ * their register_index set, spilled ones keep it as SIZE_MAX and live in their
+ * stack slot.
+ */
+void x86_64_regalloc_function(struct tac_node *beginfun_node);
+
+enum x86_64_register x86_64_regalloc_register(size_t register_index);
+
+int x86_64_regalloc_is_callee_saved(size_t register_index);
+
+/**
+ * Tells whether the given register, of any size, may hold an allocated
+ * temporary, and therefore must not be treated as a scratch register.
+ */
+int x86_64_regalloc_is_allocatable(enum x86_64_register reg);
+
+#endif